@@ -102,6 +102,7 @@ Args::Ctor()
   doNormalizeTy = true;
 
   prof_metrics = Analysis::Args::MetricFlg_NULL;
+  prof_jobs = 1;
 
   profflat_computeFinalMetricValues = true;
 
@@ -124,6 +124,10 @@ public:
   //std::vector<std::string> searchPaths;
   PathTupleVec searchPathTpls;
 
+  // Index of the search paths' directories, kept across runs (cf.
+  // PathFindMgr::useIndex())
+  std::string searchPathIndex;
+
   // Structure files
   std::vector<std::string> structureFiles;
 
@@ -178,6 +182,9 @@ public:
 
   uint prof_metrics;
 
+  // number of threads for aggregating CCT metrics (cf. OpenMP)
+  uint prof_jobs;
+
   // TODO: Currently this is always true even though we only need to
   // compute final metric values for (1) hpcproftt (flat) and (2)
   // hpcprof-flat when it computes derived metrics.  However, at the
@@ -191,6 +198,7 @@ public:
 #define Analysis_OUT_DB_EXPERIMENT "experiment.xml"
 #define Analysis_OUT_DB_CSV        "experiment.csv"
 #define Analysis_OUT_DB_DTD        "experiment.dtd"
+#define Analysis_OUT_DB_DEPTH      "experiment.depth"
 
 #define Analysis_DB_DIR_pfx        "hpctoolkit"
 #define Analysis_DB_DIR_nm         "database"
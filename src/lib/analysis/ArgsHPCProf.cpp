@@ -126,6 +126,10 @@ Options: Source Code and Static Structure:\n\
                        Use <path> when searching for source files. For a\n\
                        recursive search, append a + after the last slash,\n\
                        e.g., /mypath/+ . May use multiple -I options.\n\
+  --search-index <file>\n\
+                       Keep an index of the directories under the -I search\n\
+                       paths in <file> and reuse it in later runs; only\n\
+                       directories modified since are read again.\n\
   -S <file>, --structure <file>\n\
                        Use hpcstruct structure file <file> for correlation.\n\
                        May pass multiple times (e.g., for shared libraries).\n\
@@ -148,6 +152,8 @@ Options: Metrics:\n\
                        hpcprof-mpi does not compute 'thread'.\n\
   --force-metric       Force hpcprof to show all thread-level metrics,\n\
                        regardless of their number.\n\
+  -j <n>, --jobs <n>   Use <n> threads to aggregate metrics over the calling\n\
+                       context tree and to find and copy source files. {1}\n\
 \n\
 Options: Output:\n\
   -o <db-path>, --db <db-path>, --output <db-path>\n\
@@ -188,6 +194,8 @@ CmdLineParser::OptArgDesc Analysis::ArgsHPCProf::optArgs[] = {
 
   { 'I', "include",         CLP::ARG_REQ,  CLP::DUPOPT_CAT,  CLP_SEPARATOR,
      NULL },
+  {  0 , "search-index",    CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
+     NULL },
   { 'S', "structure",       CLP::ARG_REQ,  CLP::DUPOPT_CAT,  CLP_SEPARATOR,
      NULL },
   { 'R', "replace-path",    CLP::ARG_REQ,  CLP::DUPOPT_CAT,  CLP_SEPARATOR,
@@ -201,6 +209,8 @@ CmdLineParser::OptArgDesc Analysis::ArgsHPCProf::optArgs[] = {
      NULL },
   {  0 , "force-metric",    CLP::ARG_NONE, CLP::DUPOPT_CLOB, NULL,
      NULL },
+  { 'j', "jobs",            CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
+     NULL },
 
   // Output options
   { 'o', "output",          CLP::ARG_REQ , CLP::DUPOPT_CLOB, NULL,
@@ -377,6 +387,14 @@ ArgsHPCProf::parse(int argc, const char* const argv[], AppType type)
       }
       Diagnostics_SetDiagnosticFilterLevel(verb);
     }
+    if (parser.isOpt("jobs")) {
+      const string& arg = parser.getOptArg("jobs");
+      long jobs = CmdLineParser::toLong(arg);
+      if (jobs < 1) {
+	ARG_ERROR("invalid argument for --jobs: '" << arg << "'");
+      }
+      prof_jobs = (uint)jobs;
+    }
 
     // Check for agent options
     if (parser.isOpt("agent-cilk")) {
@@ -410,6 +428,9 @@ ArgsHPCProf::parse(int argc, const char* const argv[], AppType type)
 						     Analysis::DefaultPathTupleTarget));
       }
     }
+    if (parser.isOpt("search-index")) {
+      searchPathIndex = parser.getOptArg("search-index");
+    }
     if (parser.isOpt("structure")) {
       string str = parser.getOptArg("structure");
       StrUtil::tokenize_str(str, CLP_SEPARATOR, structureFiles);
@@ -76,6 +76,7 @@ using std::string;
 #include <typeinfo>
 
 #include <sys/stat.h>
+#include <unistd.h>
 
 //*************************** User Include Files ****************************
 
@@ -96,6 +97,8 @@ using std::string;
 #include <lib/profxml/PGMReader.hpp>
 
 #include <lib/prof-lean/hpcrun-metric.h>
+#include <lib/prof-lean/hpcio.h>
+#include <lib/prof-lean/hpcfmt.h>
 
 #include <lib/binutils/LM.hpp>
 #include <lib/binutils/VMAInterval.hpp>
@@ -1201,6 +1204,9 @@ static void
 write(Prof::CallPath::Profile& prof, std::ostream& os,
       const Analysis::Args& args);
 
+static void
+writeDepthTable(Prof::CallPath::Profile& prof, const string& fnm);
+
 
 // makeDatabase: assumes Analysis::Args::makeDatabaseDir() has been called
 void
@@ -1213,7 +1219,7 @@ makeDatabase(Prof::CallPath::Profile& prof, const Analysis::Args& args)
   // 1. Copy source files.  
   //    NOTE: makes file names in 'prof.structure' relative to database
   Analysis::Util::copySourceFiles(prof.structure()->root(),
-				  args.searchPathTpls, db_dir);
+				  args.searchPathTpls, db_dir, args.prof_jobs);
 
   // 2. Copy trace files (if necessary)
   Analysis::Util::copyTraceFiles(db_dir, prof.traceFileNameSet());
@@ -1244,6 +1250,74 @@ makeDatabase(Prof::CallPath::Profile& prof, const Analysis::Args& args)
   IOUtil::CloseStream(os);
   
   delete[] outBuf;
+
+  // 6. Create the trace depth table (used by hpcserver)
+  if (!prof.traceFileNameSet().empty()) {
+    string depth_fnm = db_dir + "/" + Analysis_OUT_DB_DEPTH;
+    writeDepthTable(prof, depth_fnm);
+  }
+}
+
+
+// writeDepthTable: Lets a trace server map the trace id of a sample to
+// the procedure frame at a given call stack depth without parsing
+// 'experiment.xml'.  Frames are listed in pre-order, so a frame always
+// follows its parent.  All values are big-endian 4-byte integers:
+//   numFrames, numFrames x (frame id, parent frame id, depth)
+//   numTraceIds, numTraceIds x (trace id, innermost frame id)
+// Frame ids are the 'i' attributes and trace ids the 'it' attributes of
+// 'experiment.xml'.  Outermost frames have depth 0 and parent 0.
+static void
+writeDepthTable(Prof::CallPath::Profile& prof, const string& fnm)
+{
+  using namespace Prof;
+
+  std::vector<uint> frames;
+  std::vector<uint> traceIds;
+  std::map<const CCT::ProcFrm*, uint> depthOf;
+
+  for (CCT::ANodeIterator it(prof.cct()->root()); it.Current(); ++it) {
+    CCT::ANode* n = it.current();
+    if (n->type() == CCT::ANode::TyProcFrm) {
+      const CCT::ProcFrm* frame = static_cast<const CCT::ProcFrm*>(n);
+      const CCT::ProcFrm* parent =
+	(n->parent()) ? n->parent()->ancestorProcFrm() : NULL;
+      uint depth = (parent) ? depthOf[parent] + 1 : 0;
+      depthOf[frame] = depth;
+      frames.push_back(frame->id());
+      frames.push_back((parent) ? parent->id() : 0);
+      frames.push_back(depth);
+    }
+    else if (n->type() == CCT::ANode::TyStmt) {
+      const CCT::Stmt* stmt = static_cast<const CCT::Stmt*>(n);
+      const CCT::ProcFrm* frame = n->ancestorProcFrm();
+      if (frame && hpcrun_fmt_doRetainId(stmt->cpId())) {
+	traceIds.push_back(stmt->cpId());
+	traceIds.push_back(frame->id());
+      }
+    }
+  }
+
+  FILE* fs = hpcio_fopen_w(fnm.c_str(), 1/*overwrite*/);
+  if (!fs) {
+    DIAG_WMsg(1, "Could not create trace depth table " << fnm);
+    return;
+  }
+
+  bool ok = (hpcfmt_int4_fwrite(frames.size() / 3, fs) == HPCFMT_OK);
+  for (uint i = 0; ok && i < frames.size(); ++i) {
+    ok = (hpcfmt_int4_fwrite(frames[i], fs) == HPCFMT_OK);
+  }
+  ok = ok && (hpcfmt_int4_fwrite(traceIds.size() / 2, fs) == HPCFMT_OK);
+  for (uint i = 0; ok && i < traceIds.size(); ++i) {
+    ok = (hpcfmt_int4_fwrite(traceIds[i], fs) == HPCFMT_OK);
+  }
+  hpcio_fclose(fs);
+
+  if (!ok) {
+    DIAG_WMsg(1, "Could not write trace depth table " << fnm);
+    unlink(fnm.c_str());
+  }
 }
 
 
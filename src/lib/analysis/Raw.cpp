@@ -60,9 +60,12 @@
 //************************* System Include Files ****************************
 
 #include <iostream>
+#include <sstream>
 #include <string>
 using std::string;
 
+#include <vector>
+
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
@@ -85,22 +88,22 @@ using std::string;
 //****************************************************************************
 
 void 
-Analysis::Raw::writeAsText(/*destination,*/ const char* filenm)
+Analysis::Raw::writeAsText(FILE* outfs, const char* filenm)
 {
   using namespace Analysis::Util;
 
   ProfType_t ty = getProfileType(filenm);
   if (ty == ProfType_Callpath) {
-    writeAsText_callpath(filenm);
+    writeAsText_callpath(outfs, filenm);
   }
   else if (ty == ProfType_CallpathMetricDB) {
-    writeAsText_callpathMetricDB(filenm);
+    writeAsText_callpathMetricDB(outfs, filenm);
   }
   else if (ty == ProfType_CallpathTrace) {
-    writeAsText_callpathTrace(filenm);
+    writeAsText_callpathTrace(outfs, filenm);
   }
   else if (ty == ProfType_Flat) {
-    writeAsText_flat(filenm);
+    writeAsText_flat(outfs, filenm);
   }
   else {
     DIAG_Die(DIAG_Unimplemented);
@@ -109,13 +112,13 @@ Analysis::Raw::writeAsText(/*destination,*/ const char* filenm)
 
 
 void
-Analysis::Raw::writeAsText_callpath(const char* filenm)
+Analysis::Raw::writeAsText_callpath(FILE* outfs, const char* filenm)
 {
   if (!filenm) { return; }
 
   Prof::CallPath::Profile* prof = NULL;
   try {
-    prof = Prof::CallPath::Profile::make(filenm, 0/*rFlags*/, stdout);
+    prof = Prof::CallPath::Profile::make(filenm, 0/*rFlags*/, outfs);
   }
   catch (...) {
     DIAG_EMsg("While reading '" << filenm << "'...");
@@ -126,7 +129,7 @@ Analysis::Raw::writeAsText_callpath(const char* filenm)
 
 
 void
-Analysis::Raw::writeAsText_callpathMetricDB(const char* filenm)
+Analysis::Raw::writeAsText_callpathMetricDB(FILE* outfs, const char* filenm)
 {
   if (!filenm) { return; }
 
@@ -142,19 +145,19 @@ Analysis::Raw::writeAsText_callpathMetricDB(const char* filenm)
       DIAG_Throw("error reading metric-db file '" << filenm << "'");
     }
 
-    hpcmetricDB_fmt_hdr_fprint(&hdr, stdout);
+    hpcmetricDB_fmt_hdr_fprint(&hdr, outfs);
 
     for (uint nodeId = 1; nodeId < hdr.numNodes + 1; ++nodeId) {
-      fprintf(stdout, "(%6u: ", nodeId);
+      fprintf(outfs, "(%6u: ", nodeId);
       for (uint mId = 0; mId < hdr.numMetrics; ++mId) {
 	double mval = 0;
 	ret = hpcfmt_real8_fread(&mval, fs);
 	if (ret != HPCFMT_OK) {
 	  DIAG_Throw("error reading trace file '" << filenm << "'");
 	}
-	fprintf(stdout, "%12g ", mval);
+	fprintf(outfs, "%12g ", mval);
       }
-      fprintf(stdout, ")\n");
+      fprintf(outfs, ")\n");
     }
 
     hpcio_fclose(fs);
@@ -167,7 +170,8 @@ Analysis::Raw::writeAsText_callpathMetricDB(const char* filenm)
 
 
 void
-Analysis::Raw::writeAsText_callpathTrace(const char* filenm)
+Analysis::Raw::writeAsText_callpathTrace(FILE* outfs, const char* filenm,
+					 const TraceDumpOpts& opts)
 {
   if (!filenm) { return; }
 
@@ -184,20 +188,52 @@ Analysis::Raw::writeAsText_callpathTrace(const char* filenm)
       DIAG_Throw("error reading trace file '" << filenm << "'");
     }
 
-    hpctrace_fmt_hdr_fprint(&hdr, stdout);
+    int rank, thread;
+    hpcrun_fmt_fnm_rank_thread(filenm, &rank, &thread);
 
-    // Read trace records and exit on EOF
-    while ( !feof(fs) ) {
-      hpctrace_fmt_datum_t datum;
-      ret = hpctrace_fmt_datum_fread(&datum, hdr.flags, fs);
-      if (ret == HPCFMT_EOF) {
-	break;
-      }
-      else if (ret == HPCFMT_ERR) {
+    if (opts.format == TraceDumpOpts::Text) {
+      hpctrace_fmt_hdr_fprint(&hdr, outfs);
+    }
+
+    // Read trace records a block at a time and decode each block in
+    // one pass rather than a datum (three freads) at a time.
+    const size_t recSz = hpctrace_fmt_datum_size(hdr.flags);
+    const int blockLen = HPCIO_RWBufferSz / sizeof(hpctrace_fmt_datum_t);
+    std::vector<char> raw(blockLen * recSz);
+    std::vector<hpctrace_fmt_datum_t> data(blockLen);
+
+    size_t nr;
+    while ((nr = fread(raw.data(), 1, raw.size(), fs)) > 0) {
+      if (nr % recSz != 0) {
 	DIAG_Throw("error reading trace file '" << filenm << "'");
       }
+      int n = nr / recSz;
+      hpctrace_fmt_data_decode(data.data(), n, hdr.flags, raw.data());
+      for (int i = 0; i < n; ++i) {
+	const hpctrace_fmt_datum_t& d = data[i];
+	uint64_t time = HPCTRACE_FMT_GET_TIME(d.comp);
+	if (time < opts.timeBeg || time >= opts.timeEnd) {
+	  continue;
+	}
 
-      hpctrace_fmt_datum_fprint(&datum, hdr.flags, stdout);
+	if (opts.format == TraceDumpOpts::Text) {
+	  hpctrace_fmt_datum_fprint(&data[i], hdr.flags, outfs);
+	}
+	else if (opts.format == TraceDumpOpts::CSV) {
+	  fprintf(outfs, "%d,%d,%" PRIu64 ",%u,", rank, thread, time, d.cpId);
+	  if (d.metricId != HPCTRACE_FMT_MetricId_NULL) {
+	    fprintf(outfs, "%u", d.metricId);
+	  }
+	  fputc('\n', outfs);
+	}
+	else {
+	  TraceDumpRecord rec = { rank, thread, time, d.cpId, d.metricId };
+	  fwrite(&rec, sizeof(rec), 1, outfs);
+	}
+      }
+    }
+    if (ferror(fs)) {
+      DIAG_Throw("error reading trace file '" << filenm << "'");
     }
 
     hpcio_fclose(fs);
@@ -210,7 +246,7 @@ Analysis::Raw::writeAsText_callpathTrace(const char* filenm)
 
 
 void
-Analysis::Raw::writeAsText_flat(const char* filenm)
+Analysis::Raw::writeAsText_flat(FILE* outfs, const char* filenm)
 {
   if (!filenm) { return; }
   
@@ -223,6 +259,8 @@ Analysis::Raw::writeAsText_flat(const char* filenm)
     throw;
   }
 
-  prof.dump(std::cout);
+  std::ostringstream os;
+  prof.dump(os);
+  fputs(os.str().c_str(), outfs);
 }
 
@@ -64,6 +64,10 @@
 
 #include <string>
 
+#include <cstdio>
+
+#include <stdint.h>
+
 //*************************** User Include Files ****************************
 
 #include <include/uint.h> 
@@ -76,24 +80,60 @@ namespace Analysis {
 
 namespace Raw {
 
+// Which trace records to dump and how (cf. hpcproftt --format, --time)
+struct TraceDumpOpts {
+  enum Format {
+    Text,    // the header, then one "(time, cpId)" tuple per line
+    CSV,     // rank,thread,time,cpid,metricid
+    Binary   // packed TraceDumpRecord in host byte order
+  };
+
+  TraceDumpOpts()
+    : format(Text), timeBeg(0), timeEnd(UINT64_MAX)
+  { }
+
+  Format format;
+
+  // keep records with timeBeg <= time < timeEnd
+  uint64_t timeBeg;
+  uint64_t timeEnd;
+};
+
+// a record of TraceDumpOpts::Binary output (same as hpctracedump's)
+struct TraceDumpRecord {
+  int32_t  rank;
+  int32_t  thread;
+  uint64_t time;
+  uint32_t cpId;
+  uint32_t metricId;
+};
+
+// Write a textual dump of the profile, metric-db or trace file 'filenm'
+// to 'outfs'.  Metric-db and trace files may be dumped concurrently as
+// long as each uses its own 'outfs'; profiles may not (see below).
 void 
-writeAsText(/*destination,*/ const char* filenm);
+writeAsText(FILE* outfs, const char* filenm);
 
 static inline void 
-writeAsText(/*destination,*/ const std::string& filenm)
-{ writeAsText(filenm.c_str()); }
+writeAsText(FILE* outfs, const std::string& filenm)
+{ writeAsText(outfs, filenm.c_str()); }
+
+// N.B.: reading a call path or flat profile builds Prof structures that
+// are not thread safe; callers must serialize these.
 
 void
-writeAsText_callpath(/*destination,*/ const char* filenm);
+writeAsText_callpath(FILE* outfs, const char* filenm);
 
 void
-writeAsText_callpathMetricDB(/*destination,*/ const char* filenm);
+writeAsText_callpathMetricDB(FILE* outfs, const char* filenm);
 
+// Rank and thread come from the file name (cf. hpcrun_fmt_fnm_rank_thread).
 void
-writeAsText_callpathTrace(/*destination,*/ const char* filenm);
+writeAsText_callpathTrace(FILE* outfs, const char* filenm,
+			  const TraceDumpOpts& opts = TraceDumpOpts());
 
 void
-writeAsText_flat(/*destination,*/ const char* filenm);
+writeAsText_flat(FILE* outfs, const char* filenm);
 
 } // namespace Raw
 
@@ -87,6 +87,7 @@ using std::string;
 
 #include <lib/support/PathFindMgr.hpp>
 #include <lib/support/PathReplacementMgr.hpp>
+#include <lib/support/StrUtil.hpp>
 #include <lib/support/diagnostics.h>
 #include <lib/support/dictionary.h>
 #include <lib/support/realpath.h>
@@ -376,11 +377,32 @@ demandStructure(VMA vma, Prof::Struct::LM* lmStruct,
 // 
 //***************************************************************************
 
-static string
-copySourceFileMain(const string& fnm_orig,
-		   std::map<string, string>& processedFiles,
-		   const Analysis::PathTupleVec& pathVec,
-		   const string& dstDir);
+// SrcFileCopy: where a source file referenced by the structure was found
+// and where it is copied to in the database
+struct SrcFileCopy {
+  SrcFileCopy()
+    : pathTpl(NULL)
+  { }
+
+  string fnm_fnd;                      // found file ("": lost)
+  const Analysis::PathTuple* pathTpl;  // tuple that reaches 'fnm_fnd'
+  string fnm_new;                      // database file name
+  string fnm_to;                       // copy destination
+};
+
+static void
+findSourceFile(const string& fnm_orig, const Analysis::PathTupleVec& pathVec,
+	       const std::vector<string>& realPathVec, SrcFileCopy& srcFile);
+
+static void
+copySourceFile(const SrcFileCopy& srcFile, string& errMsg);
+
+static const string&
+structFileName(Prof::Struct::ANode* strct);
+
+static void
+structFileName(Prof::Struct::ANode* strct, const string& fnm);
+
 
 static bool 
 Flat_Filter(const Prof::Struct::ANode& x, long GCC_ATTR_UNUSED type)
@@ -394,50 +416,197 @@ Flat_Filter(const Prof::Struct::ANode& x, long GCC_ATTR_UNUSED type)
 namespace Analysis {
 namespace Util {
 
+// prefetchSearchPaths: Read the directories reached by the
+// colon-separated (possibly recursive) search paths 'pathList' with
+// 'jobs' threads, one directory level per round, and hand them to
+// PathFindMgr::singleton() for populating its cache.
+void
+prefetchSearchPaths(const string& pathList, uint jobs)
+{
+  PathFindMgr& pathFindMgr = PathFindMgr::singleton();
+  if (pathFindMgr.isPopulated()) {
+    return;
+  }
+
+  typedef std::pair<string, bool> DirTuple; // <path, is-recursive>
+
+  std::vector<string> pathVec;
+  StrUtil::tokenize_str(pathList, ":", pathVec);
+
+  // cf. PathFindMgr::populate() and PathFindMgr::scan()
+  std::vector<DirTuple> dirVec;
+  for (uint i = 0; i < pathVec.size(); ++i) {
+    string path = pathVec[i];
+    if (path == ".") {
+      continue; // do not cache within CWD
+    }
+    bool isRecursive = PathFindMgr::isRecursivePath(path.c_str());
+    if (isRecursive) {
+      path.resize(path.length() - PathFindMgr::RecursivePathSfxLn);
+    }
+    if (!path.empty()) {
+      dirVec.push_back(DirTuple(RealPath(path.c_str()), isRecursive));
+    }
+  }
+
+  PathFindMgr::DirContentsMap dirMap;
+  std::set<DirTuple> seenDirs(dirVec.begin(), dirVec.end());
+
+  while (!dirVec.empty()) {
+    long numDirs = dirVec.size();
+    std::vector<PathFindMgr::DirContents> contentsVec(numDirs);
+    std::vector<char> isReadVec(numDirs);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(jobs)
+    for (long i = 0; i < numDirs; ++i) {
+      isReadVec[i] = PathFindMgr::readDir(dirVec[i].first, contentsVec[i]);
+    }
+
+    std::vector<DirTuple> dirVecNxt;
+    for (long i = 0; i < numDirs; ++i) {
+      if (!isReadVec[i]) {
+	continue;
+      }
+
+      PathFindMgr::DirContents& contents = contentsVec[i];
+      if (dirVec[i].second) {
+	for (uint j = 0; j < contents.dirs.size(); ++j) {
+	  DirTuple x(contents.dirs[j].first, true);
+	  if (seenDirs.insert(x).second) {
+	    dirVecNxt.push_back(x);
+	  }
+	}
+      }
+      PathFindMgr::DirContents& x_contents = dirMap[dirVec[i].first];
+      x_contents.files.swap(contents.files);
+      x_contents.dirs.swap(contents.dirs);
+    }
+    dirVec.swap(dirVecNxt);
+  }
+
+  pathFindMgr.prefetch(dirMap);
+}
+
+
 // copySourceFiles: For every Prof::Struct::File and
 // Prof::Struct::Alien x in 'structure' that can be reached with paths
 // in 'pathVec', copy x to its appropriate viewname path and update
 // x's path to be relative to this location.
+//
+// Files are found, then copied, by 'jobs' threads.  Each database
+// file is copied once, even if several file names in 'structure'
+// resolve to it.
 void
 copySourceFiles(Prof::Struct::Root* structure, 
 		const Analysis::PathTupleVec& pathVec,
-		const string& dstDir)
+		const string& dstDir, uint jobs)
 {
-  // Prevent multiple copies of the same file (Alien scopes)
-  std::map<string, string> processedFiles;
+  // ------------------------------------------------------
+  // 1. Collect each file name in 'structure' once (Alien scopes)
+  // ------------------------------------------------------
+
+  // Note: A file name will be not be absolute if it is not possible
+  // to resolve it on the current filesystem. (cf. RealPathMgr)
+
+  std::vector<Prof::Struct::ANode*> strctVec;
+  std::vector<uint> strctFileIdx;  // strctVec[i]'s file in 'srcFiles'
+
+  std::map<string, uint> fileIdxMap;
+  std::vector<const string*> fnmVec;
 
   Prof::Struct::ANodeFilter filter(Flat_Filter, "Flat_Filter", 0);
   for (Prof::Struct::ANodeIterator it(structure, &filter); it.Current(); ++it) {
     Prof::Struct::ANode* strct = it.current();
+    const string& fnm_orig = structFileName(strct);
 
-    // Note: 'fnm_orig' will be not be absolute if it is not possible
-    // to resolve it on the current filesystem. (cf. RealPathMgr)
+    std::pair<std::map<string, uint>::iterator, bool> ret =
+      fileIdxMap.insert(make_pair(fnm_orig, (uint)fnmVec.size()));
+    if (ret.second) {
+      fnmVec.push_back(&ret.first->first);
+    }
+    strctVec.push_back(strct);
+    strctFileIdx.push_back(ret.first->second);
+  }
 
-    // DIAG_Assert( , DIAG_UnexpectedInput);
-    const string& fnm_orig = 
-      ((typeid(*strct) == typeid(Prof::Struct::Alien)) ?
-       dynamic_cast<Prof::Struct::Alien*>(strct)->fileName() : 
-       ((typeid(*strct) == typeid(Prof::Struct::Loop)) ? 
-	dynamic_cast<Prof::Struct::Loop*>(strct)->fileName() : 
-	strct->name()));
-    
-    // ------------------------------------------------------
-    // Given fnm_orig, attempt to find and copy fnm_new
-    // ------------------------------------------------------
-    string fnm_new =
-      copySourceFileMain(fnm_orig, processedFiles, pathVec, dstDir);
-    
-    // ------------------------------------------------------
-    // Update static structure
-    // ------------------------------------------------------
+  long numFiles = fnmVec.size();
+  std::vector<SrcFileCopy> srcFiles(numFiles);
+
+  // ------------------------------------------------------
+  // 2. Find each file.  Populating PathFindMgr's cache is not
+  //    thread-safe, so find files serially until it is populated.
+  // ------------------------------------------------------
+  std::vector<string> realPathVec(pathVec.size());
+  for (uint i = 0; i < pathVec.size(); ++i) {
+    string realPath(pathVec[i].first);
+    if (PathFindMgr::isRecursivePath(realPath.c_str())) {
+      realPath.resize(realPath.length() - PathFindMgr::RecursivePathSfxLn);
+    }
+    realPathVec[i] = RealPath(realPath.c_str());
+  }
+
+  long fileBeg = 0;
+  for ( ; fileBeg < numFiles && !PathFindMgr::singleton().isPopulated();
+	++fileBeg) {
+    findSourceFile(*fnmVec[fileBeg], pathVec, realPathVec, srcFiles[fileBeg]);
+  }
+
+#pragma omp parallel for schedule(dynamic, 16) num_threads(jobs)
+  for (long i = fileBeg; i < numFiles; ++i) {
+    findSourceFile(*fnmVec[i], pathVec, realPathVec, srcFiles[i]);
+  }
+
+  // ------------------------------------------------------
+  // 3. Copy each database file once
+  // ------------------------------------------------------
+  std::vector<long> copyVec;
+  std::set<string> dstFiles;
+
+  for (long i = 0; i < numFiles; ++i) {
+    SrcFileCopy& srcFile = srcFiles[i];
+    if (srcFile.fnm_fnd.empty()) {
+      continue;
+    }
+
+    const string& viewnm = srcFile.pathTpl->second;
+    srcFile.fnm_new = "./" + viewnm + srcFile.fnm_fnd;
+    srcFile.fnm_to = ((dstDir[0] != '/') ? "./" : "") + dstDir + "/"
+      + viewnm + srcFile.fnm_fnd;
+
+    if (dstFiles.insert(srcFile.fnm_to).second) {
+      copyVec.push_back(i);
+    }
+  }
+
+  long numCopies = copyVec.size();
+  std::vector<string> errMsgVec(numCopies);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(jobs)
+  for (long i = 0; i < numCopies; ++i) {
+    copySourceFile(srcFiles[copyVec[i]], errMsgVec[i]);
+  }
+
+  for (long i = 0; i < numCopies; ++i) {
+    if (!errMsgVec[i].empty()) {
+      DIAG_EMsg(errMsgVec[i]);
+    }
+  }
+
+  for (long i = 0; i < numFiles; ++i) {
+    if (srcFiles[i].fnm_new.empty()) {
+      DIAG_WMsg(2, "lost: " << *fnmVec[i]);
+    }
+    else {
+      DIAG_Msg(2, "  cp:" << *fnmVec[i] << " -> " << srcFiles[i].fnm_new);
+    }
+  }
+
+  // ------------------------------------------------------
+  // 4. Update static structure
+  // ------------------------------------------------------
+  for (uint i = 0; i < strctVec.size(); ++i) {
+    const string& fnm_new = srcFiles[strctFileIdx[i]].fnm_new;
     if (!fnm_new.empty()) {
-      if (typeid(*strct) == typeid(Prof::Struct::Alien)) {
-	dynamic_cast<Prof::Struct::Alien*>(strct)->fileName(fnm_new);
-      } else if (typeid(*strct) == typeid(Prof::Struct::Loop)) {
-	dynamic_cast<Prof::Struct::Loop*>(strct)->fileName(fnm_new);
-      } else {
-	dynamic_cast<Prof::Struct::File*>(strct)->name(fnm_new);
-      }
+      structFileName(strctVec[i], fnm_new);
     }
   }
 }
@@ -448,62 +617,78 @@ copySourceFiles(Prof::Struct::Root* structure,
 
 
 static std::pair<int, string>
-matchFileWithPath(const string& filenm, const Analysis::PathTupleVec& pathVec);
+matchFileWithPath(const string& filenm, const Analysis::PathTupleVec& pathVec,
+		  const std::vector<string>& realPathVec);
+
+// findSourceFile: Given 'fnm_orig', sets 'srcFile.fnm_fnd' to the
+// file to copy and 'srcFile.pathTpl' to the <search-path, path-view>
+// tuple for it; leaves them empty if the file cannot be found.  May
+// be called by several threads once PathFindMgr's cache is populated.
+static void
+findSourceFile(const string& fnm_orig, const Analysis::PathTupleVec& pathVec,
+	       const std::vector<string>& realPathVec, SrcFileCopy& srcFile)
+{
+  std::pair<int, string> fnd = matchFileWithPath(fnm_orig, pathVec,
+						 realPathVec);
+  int idx = fnd.first;
+  if (idx >= 0) {
+    // fnm_orig explicitly matches a <search-path, path-view> tuple
+    srcFile.fnm_fnd = fnd.second;
+    srcFile.pathTpl = &pathVec[idx];
+  }
+  else if (fnm_orig[0] == '/' && FileUtil::isReadable(fnm_orig.c_str())) {
+    // fnm_orig does not match a pathVec tuple; but if it is an
+    // absolute path that is readable, use the default <search-path,
+    // path-view> tuple.
+    static const Analysis::PathTuple 
+      defaultTpl("/", Analysis::DefaultPathTupleTarget);
+    srcFile.fnm_fnd = fnm_orig;
+    srcFile.pathTpl = &defaultTpl;
+  }
+}
 
-static string
-copySourceFile(const string& filenm, const string& dstDir, 
-	       const Analysis::PathTuple& pathTpl);
 
-static string
-copySourceFileMain(const string& fnm_orig,
-		   std::map<string, string>& processedFiles,
-		   const Analysis::PathTupleVec& pathVec,
-		   const string& dstDir)
+static const string&
+structFileName(Prof::Struct::ANode* strct)
 {
-  string fnm_new;
-  
-  std::map<string, string>::iterator it = processedFiles.find(fnm_orig);
-  if (it != processedFiles.end()) {
-    fnm_new = it->second;
+  if (typeid(*strct) == typeid(Prof::Struct::Alien)) {
+    return dynamic_cast<Prof::Struct::Alien*>(strct)->fileName();
+  }
+  else if (typeid(*strct) == typeid(Prof::Struct::Loop)) {
+    return dynamic_cast<Prof::Struct::Loop*>(strct)->fileName();
   }
   else {
-    std::pair<int, string> fnd = matchFileWithPath(fnm_orig, pathVec);
-    int idx = fnd.first;
-    if (idx >= 0) {
-      // fnm_orig explicitly matches a <search-path, path-view> tuple
-      fnm_new = copySourceFile(fnd.second, dstDir, pathVec[idx]);
-    }
-    else if (fnm_orig[0] == '/' && FileUtil::isReadable(fnm_orig.c_str())) {
-      // fnm_orig does not match a pathVec tuple; but if it is an
-      // absolute path that is readable, use the default <search-path,
-      // path-view> tuple.
-      static const Analysis::PathTuple 
-	defaultTpl("/", Analysis::DefaultPathTupleTarget);
-      fnm_new = copySourceFile(fnm_orig, dstDir, defaultTpl);
-    }
+    return strct->name();
+  }
+}
 
-    if (fnm_new.empty()) {
-      DIAG_WMsg(2, "lost: " << fnm_orig);
-    }
-    else {
-      DIAG_Msg(2, "  cp:" << fnm_orig << " -> " << fnm_new);
-    }
-    processedFiles.insert(make_pair(fnm_orig, fnm_new));
+
+static void
+structFileName(Prof::Struct::ANode* strct, const string& fnm)
+{
+  if (typeid(*strct) == typeid(Prof::Struct::Alien)) {
+    dynamic_cast<Prof::Struct::Alien*>(strct)->fileName(fnm);
+  }
+  else if (typeid(*strct) == typeid(Prof::Struct::Loop)) {
+    dynamic_cast<Prof::Struct::Loop*>(strct)->fileName(fnm);
+  }
+  else {
+    dynamic_cast<Prof::Struct::File*>(strct)->name(fnm);
   }
-  
-  return fnm_new;
 }
 
 
 //***************************************************************************
 
 // matchFileWithPath: Given a file name 'filenm' and a vector of paths
-// 'pathVec', use 'pathfind_r' to determine which path in 'pathVec',
-// if any, reaches 'filenm'.  Returns an index and string pair.  If a
-// match is found, the index is an index in pathVec; otherwise it is
-// negative.  If a match is found, the string is the found file name.
+// 'pathVec' (with their real paths 'realPathVec'), use 'pathfind_r'
+// to determine which path in 'pathVec', if any, reaches 'filenm'.
+// Returns an index and string pair.  If a match is found, the index
+// is an index in pathVec; otherwise it is negative.  If a match is
+// found, the string is the found file name.
 static std::pair<int, string>
-matchFileWithPath(const string& filenm, const Analysis::PathTupleVec& pathVec)
+matchFileWithPath(const string& filenm, const Analysis::PathTupleVec& pathVec,
+		  const std::vector<string>& realPathVec)
 {
   // Find the index to the path that reaches 'filenm'.
   // It is possible that more than one path could reach the same
@@ -516,19 +701,14 @@ matchFileWithPath(const string& filenm, const Analysis::PathTupleVec& pathVec)
   string foundFnm; 
 
   for (uint i = 0; i < pathVec.size(); i++) {
-    // find the absolute form of 'curPath'
+    // the absolute form of 'curPath'
     const string& curPath = pathVec[i].first;
-    string realPath(curPath);
-    if (PathFindMgr::isRecursivePath(curPath.c_str())) {
-      realPath[realPath.length() - PathFindMgr::RecursivePathSfxLn] = '\0';
-    }
-    realPath = RealPath(realPath.c_str());
+    const string& realPath = realPathVec[i];
     int realPathLn = realPath.length();
        
     // 'filenm' should be relative as input for pathfind_r.  If 'filenm'
     // is absolute and 'realPath' is a prefix, make it relative. 
-    string tmpFile(filenm);
-    char* curFile = const_cast<char*>(tmpFile.c_str());
+    const char* curFile = filenm.c_str();
     if (filenm[0] == '/') { // is 'filenm' absolute?
       if (strncmp(curFile, realPath.c_str(), realPathLn) == 0) {
 	curFile = &curFile[realPathLn];
@@ -539,10 +719,11 @@ matchFileWithPath(const string& filenm, const Analysis::PathTupleVec& pathVec)
       }
     }
     
-    const char* fnd_fnm = PathFindMgr::singleton().pathfind(curPath.c_str(),
-							    curFile, "r");
+    string fnd_fnm;
+    bool fnd = PathFindMgr::singleton().pathfind(curPath.c_str(), curFile,
+						 "r", fnd_fnm);
 
-    if (fnd_fnm) {
+    if (fnd) {
       bool update = false;
       if (foundIndex < 0) {
 	update = true;
@@ -554,7 +735,7 @@ matchFileWithPath(const string& filenm, const Analysis::PathTupleVec& pathVec)
       if (update) {
 	foundIndex = i;
 	foundPathLn = realPathLn;
-	foundFnm = RealPath(fnd_fnm);
+	foundFnm = RealPath(fnd_fnm.c_str());
       }
     }
   }
@@ -562,40 +743,25 @@ matchFileWithPath(const string& filenm, const Analysis::PathTupleVec& pathVec)
 }
 
 
-// Given a file 'filenm' a destination directory 'dstDir' and a
-// PathTuple, form a database file name, copy 'filenm' into the
-// database and return the database file name.
-// NOTE: assume filenm is already a 'real path'
-static string
-copySourceFile(const string& filenm, const string& dstDir, 
-	       const Analysis::PathTuple& pathTpl)
+// copySourceFile: Copy 'srcFile.fnm_fnd' to 'srcFile.fnm_to', making
+// its directory as needed; on failure, sets 'errMsg'.
+// NOTE: assume 'fnm_fnd' is already a 'real path'
+static void
+copySourceFile(const SrcFileCopy& srcFile, string& errMsg)
 {
-  const string& fnm_fnd = filenm;
-  const string& viewnm = pathTpl.second;
-
-  // Create new file name and copy commands
-  string fnm_new = "./" + viewnm + fnm_fnd;
-	
-  string fnm_to;
-  if (dstDir[0]  != '/') {
-    fnm_to = "./";
-  }
-  fnm_to = fnm_to + dstDir + "/" + viewnm + fnm_fnd;
-  string dir_to(fnm_to); // need to strip off ending filename to 
-  uint end;              // get full path for 'fnm_to'
-  for (end = dir_to.length() - 1; dir_to[end] != '/'; end--) { }
-  dir_to[end] = '\0';    // should not end with '/'
-	
+  const string& fnm_to = srcFile.fnm_to;
+
+  // strip off ending filename to get full path for 'fnm_to'
+  string dir_to = fnm_to.substr(0, fnm_to.find_last_of('/'));
+
   try {
     FileUtil::mkdir(dir_to);
-    FileUtil::copy(fnm_to, fnm_fnd);
+    FileUtil::copy(fnm_to, srcFile.fnm_fnd);
     DIAG_DevMsgIf(0, "cp " << fnm_to);
   }
   catch (const Diagnostics::Exception& x) {
-    DIAG_EMsg(x.message());
+    errMsg = x.message();
   }
-  
-  return fnm_new;
 }
 
 
@@ -164,10 +164,15 @@ demandStructure(VMA vma, Prof::Struct::LM* lmStrct, BinUtil::LM* lm,
 //
 // --------------------------------------------------------------------------
 
+// prefetchSearchPaths: read the directories that populating
+// PathFindMgr's cache for 'pathList' will need, with 'jobs' threads
+void
+prefetchSearchPaths(const std::string& pathList, uint jobs);
+
 void 
 copySourceFiles(Prof::Struct::Root* structure,
 		const Analysis::PathTupleVec& pathVec,
-		const std::string& dstDir);
+		const std::string& dstDir, uint jobs);
 
 void
 copyTraceFiles(const std::string& dstDir,
@@ -67,6 +67,7 @@
 //***************************************************************************
 
 #include <limits.h>
+#include <stdlib.h>
 
 #include <list>
 #include <map>
@@ -327,6 +328,53 @@ printProc(ostream * os, ostream * gaps, string gaps_file,
 
 //----------------------------------------------------------------------
 
+// The index of the next tag, used to save the output of printProc()
+// for later reuse.
+long
+nextIndex()
+{
+  return next_index;
+}
+
+// Print the text of <P> tags saved from an earlier printProc() whose
+// tags used indices first ... first + num - 1.  Renumber them in the
+// same order starting with next_index.
+//
+// Note: STRING() escapes quotes, so ' i="' only occurs in INDEX.
+void
+printSavedProcs(ostream * os, const string & text, long first, long num)
+{
+  if (os == NULL) {
+    return;
+  }
+
+  const string field = " i=\"";
+  size_t pos = 0;
+
+  for (;;) {
+    size_t next = text.find(field, pos);
+    if (next == string::npos) {
+      break;
+    }
+    next += field.size();
+
+    size_t end = text.find('"', next);
+    if (end == string::npos) {
+      break;
+    }
+    long index = strtol(text.c_str() + next, NULL, 10);
+
+    os->write(text.data() + pos, next - pos);
+    *os << (index - first + next_index);
+    pos = end;
+  }
+  os->write(text.data() + pos, text.size() - pos);
+
+  next_index += num;
+}
+
+//----------------------------------------------------------------------
+
 // Write the unclaimed vma ranges (parseapi gaps) for one Symtab
 // function to the .hpcstruct and .hpcstruct.gaps files.  This only
 // applies to the group leader.
@@ -78,6 +78,9 @@ void printFileEnd(ostream *, FileInfo *);
 void printProc(ostream *, ostream *, string, FileInfo *, GroupInfo *,
 	       ProcInfo *, HPC::StringTable & strTab);
 
+long nextIndex();
+void printSavedProcs(ostream *, const string &, long, long);
+
 }  // namespace Output
 }  // namespace BAnal
 
@@ -0,0 +1,227 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL$
+// $Id$
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+// This file implements the cache of per-function hpcstruct output
+// (Struct-Reuse.hpp).
+//
+// File format:  a header line, the config line from load(), and then
+// one record per entry:
+//
+//   <key> <first index> <num index> <text length>\n<text>
+//
+// The text is the literal output of printProc(), so it is copied
+// verbatim, without escapes.
+
+//***************************************************************************
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include <lib/prof-lean/crypto-hash.h>
+#include <lib/support/diagnostics.h>
+
+#include "Struct-Reuse.hpp"
+
+using namespace std;
+
+#define REUSE_FILE_HEADER  "hpcstruct-reuse 1"
+
+namespace BAnal {
+namespace Struct {
+
+// The config is written as one line.
+static string
+configLine(const string & config)
+{
+  string line = config;
+
+  for (size_t i = 0; i < line.size(); i++) {
+    if (line[i] == '\n') {
+      line[i] = ' ';
+    }
+  }
+  return line;
+}
+
+//----------------------------------------------------------------------
+
+void
+ReuseCache::load(const string & filenm, const string & config)
+{
+  lock_guard <mutex> guard(m_lock);
+
+  m_filenm = filenm;
+  m_config = configLine(config);
+  m_slots.clear();
+
+  ifstream is(filenm.c_str(), ios::binary);
+  if (! is) {
+    return;
+  }
+
+  string header, line;
+  getline(is, header);
+  getline(is, line);
+
+  if (header != REUSE_FILE_HEADER || line != m_config) {
+    return;
+  }
+
+  for (;;) {
+    string key;
+    ReuseEntry entry;
+    size_t len = 0;
+
+    if (! getline(is, line)) {
+      break;
+    }
+    istringstream ls(line);
+    ls >> key >> entry.first_index >> entry.num_index >> len;
+
+    if (! ls || key.empty()) {
+      DIAG_WMsg(1, "Ignoring the rest of malformed hpcstruct reuse file '"
+		<< filenm << "'");
+      break;
+    }
+
+    entry.text.resize(len);
+    if (len > 0 && ! is.read(&entry.text[0], len)) {
+      DIAG_WMsg(1, "Ignoring truncated hpcstruct reuse file '" << filenm << "'");
+      break;
+    }
+
+    m_slots[key].entry = entry;
+  }
+}
+
+//----------------------------------------------------------------------
+
+void
+ReuseCache::save()
+{
+  lock_guard <mutex> guard(m_lock);
+
+  if (m_filenm.empty()) {
+    return;
+  }
+
+  // write a temp file and rename, so an interrupted run does not
+  // leave a partial file
+  stringstream tmp_name;
+  tmp_name << m_filenm << ".tmp." << getpid();
+
+  ofstream os(tmp_name.str().c_str(), ios::binary);
+
+  os << REUSE_FILE_HEADER << "\n"
+     << m_config << "\n";
+
+  for (auto it = m_slots.begin(); it != m_slots.end(); ++it) {
+    const Slot & slot = it->second;
+
+    if (slot.is_used) {
+      os << it->first << " " << slot.entry.first_index
+	 << " " << slot.entry.num_index
+	 << " " << slot.entry.text.size() << "\n"
+	 << slot.entry.text;
+    }
+  }
+  os.close();
+
+  if (! os || rename(tmp_name.str().c_str(), m_filenm.c_str()) != 0) {
+    DIAG_WMsg(1, "Unable to write hpcstruct reuse file '" << m_filenm << "'");
+    unlink(tmp_name.str().c_str());
+  }
+}
+
+//----------------------------------------------------------------------
+
+const ReuseEntry *
+ReuseCache::find(const string & key)
+{
+  lock_guard <mutex> guard(m_lock);
+
+  auto it = m_slots.find(key);
+  if (it == m_slots.end()) {
+    return NULL;
+  }
+
+  it->second.is_used = true;
+  return &(it->second.entry);
+}
+
+void
+ReuseCache::insert(const string & key, const ReuseEntry & entry)
+{
+  lock_guard <mutex> guard(m_lock);
+
+  Slot & slot = m_slots[key];
+  slot.entry = entry;
+  slot.is_used = true;
+}
+
+//----------------------------------------------------------------------
+
+string
+reuseFingerprint(const string & data)
+{
+  unsigned char hash[HASH_LENGTH];
+  char hash_str[2 * HASH_LENGTH + 1];
+
+  crypto_hash_compute((const unsigned char *) data.data(), data.size(),
+		      hash, HASH_LENGTH);
+  crypto_hash_to_hexstring(hash, hash_str, sizeof(hash_str));
+
+  return string(hash_str);
+}
+
+}  // namespace Struct
+}  // namespace BAnal
@@ -0,0 +1,122 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL$
+// $Id$
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+// This file defines the cache of per-function hpcstruct output that
+// lets makeStructure() reuse the analysis of functions that did not
+// change since the previous run (cf. Struct::Options::reuse_file).
+//
+// Each entry is keyed by a fingerprint of one proc group (the work
+// item in Struct.cpp): its code bytes, its slice of the line map,
+// inline info and the names from the skeleton.  The entry holds the
+// <P> tags as printed, plus the range of tag indices they used, so
+// they can be renumbered when printed again.
+
+//***************************************************************************
+
+#ifndef Banal_Struct_Reuse_hpp
+#define Banal_Struct_Reuse_hpp
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace BAnal {
+namespace Struct {
+
+class ReuseEntry {
+public:
+  std::string text;
+  long  first_index;
+  long  num_index;
+
+  ReuseEntry()
+  {
+    first_index = 0;
+    num_index = 0;
+  }
+};
+
+class ReuseCache {
+public:
+  ReuseCache() { }
+
+  // Read the entries in 'filenm', if it exists and was written with
+  // the same 'config' (version, search path, etc).
+  void load(const std::string & filenm, const std::string & config);
+
+  // Write the entries found or inserted in this run back to the file
+  // from load().  Entries not used in this run are dropped.
+  void save();
+
+  // Returns the entry for 'key', or NULL.  The entry stays valid
+  // until the cache is deleted.  Thread-safe.
+  const ReuseEntry * find(const std::string & key);
+
+  // Thread-safe.
+  void insert(const std::string & key, const ReuseEntry & entry);
+
+private:
+  class Slot {
+  public:
+    ReuseEntry entry;
+    bool  is_used;
+
+    Slot() { is_used = false; }
+  };
+
+  std::mutex  m_lock;
+  std::string m_filenm;
+  std::string m_config;
+  std::map <std::string, Slot> m_slots;
+};
+
+// Returns a hex fingerprint (hash) of 'data'.
+std::string reuseFingerprint(const std::string & data);
+
+}  // namespace Struct
+}  // namespace BAnal
+
+#endif
@@ -66,8 +66,15 @@
 #include <sys/types.h>
 #include <sys/resource.h>
 #include <sys/time.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
 #include <include/uint.h>
 
 #if ENABLE_VG_ANNOTATIONS == 1
@@ -114,6 +121,7 @@
 #include "Struct.hpp"
 #include "Struct-Inline.hpp"
 #include "Struct-Output.hpp"
+#include "Struct-Reuse.hpp"
 #include "Struct-Skel.hpp"
 
 #include "gpu/ReadCudaCFG.hpp"
@@ -191,12 +199,26 @@ class HeaderInfo;
 class WorkEnv;
 class WorkItem;
 class LineMapCache;
+class LineTable;
 
 typedef map <Block *, bool> BlockSet;
 typedef map <VMA, HeaderInfo> HeaderList;
 typedef map <VMA, Region *> RegionMap;
 typedef vector <Statement::Ptr> StatementVector;
+typedef vector <LineInformation::Statement_t> LineRowVec;
 typedef vector <WorkItem *> WorkList;
+typedef map <Module *, LineTable *> LineTableMap;
+
+// state for reusing the output of unchanged functions from the
+// previous run (cf. Struct-Reuse.hpp).  the line rows are the line
+// map for the whole file, sorted by start address.
+static ReuseCache * reuse_cache = NULL;
+static bool reuse_this_file = false;
+static LineRowVec reuse_line_rows;
+
+// flat copies of each module's line map for LineMapCache, made once
+// per file before the parallel phases and read only after that.
+static LineTableMap line_tables;
 
 static FileMap *
 makeSkeleton(CodeObject *, const string &);
@@ -205,11 +227,33 @@ static void
 doWorkItem(WorkItem *, string &, bool, bool);
 
 static void
-makeWorkList(FileMap *, WorkList &, WorkList &);
+makeWorkList(FileMap *, WorkList &);
+
+static void
+makeLaunchList(WorkList &, uint, uint, WorkList &);
+
+static void
+doWorkList(WorkList &, WorkList &, uint &, ostream *, ostream *, string &,
+	   string &, bool);
+
+static void
+doPartitions(WorkList &, ostream *, ostream *, string &, string &, bool);
 
 static void
 printWorkList(WorkList &, uint &, ostream *, ostream *, string &);
 
+static void
+makeLineRows(LineRowVec &);
+
+static void
+makeLineTables(vector <Module *> &);
+
+static void
+clearLineTables();
+
+static string
+makeReuseKey(WorkItem *);
+
 static void
 doFunctionList(WorkEnv &, FileInfo *, GroupInfo *, bool);
 
@@ -357,6 +401,8 @@ public:
   bool first_proc;
   bool last_proc;
   bool promote;
+  string reuse_key;
+  const ReuseEntry * reuse;
   boost::atomic <bool> is_done;
 
   WorkItem(FileInfo * fi, GroupInfo * gi, bool first, bool last, double cst)
@@ -367,18 +413,67 @@ public:
     first_proc = first;
     last_proc = last;
     promote = false;
+    reuse = NULL;
     is_done.store(false);
   }
 };
 
 //----------------------------------------------------------------------
 
+// A flat copy of one module's line map, sorted by start address, as
+// parallel arrays.  File names are stored once per module.
+//
+// reach[i] is the max end address of rows 0..i-1.  With it, find()
+// can tell when exactly one row contains vma, the one row that
+// getSourceLines() would return.  Otherwise (overlapping rows or no
+// row), it returns false and the caller asks SymtabAPI.
+//
+class LineTable {
+private:
+  vector <VMA>  start;
+  vector <VMA>  end;
+  vector <VMA>  reach;
+  vector <uint> file;
+  vector <uint> line;
+  vector <string> names;
+
+public:
+  void make(Module * mod);
+
+  bool
+  find(VMA vma, string & filenm, uint & ln, VMA & row_start, VMA & row_end) const
+  {
+    auto it = std::upper_bound(start.begin(), start.end(), vma);
+    if (it == start.begin()) {
+      return false;
+    }
+    size_t i = (it - start.begin()) - 1;
+
+    if (vma >= end[i] || reach[i] > vma || names[file[i]].empty()) {
+      return false;
+    }
+
+    filenm = names[file[i]];
+    ln = line[i];
+    row_start = start[i];
+    row_end = end[i];
+    return true;
+  }
+};
+
+//----------------------------------------------------------------------
+
 // A simple cache of getStatement() that stores one line range.  This
 // saves extra calls to getSourceLines() if we don't need them.
 //
+// A miss first tries the flat line table of sym_func's module (the
+// same module getStatement() tries first), and only calls
+// getStatement() when the table has no unique answer.
+//
 class LineMapCache {
 private:
   SymtabAPI::Function * sym_func;
+  const LineTable * table;
   RealPathMgr * realPath;
   string  cache_filenm;
   uint    cache_line;
@@ -394,6 +489,14 @@ public:
     cache_line = 0;
     start = 1;
     end = 0;
+
+    table = NULL;
+    if (sf != NULL) {
+      auto it = line_tables.find(sf->getModule());
+      if (it != line_tables.end()) {
+	table = it->second;
+      }
+    }
   }
 
   bool
@@ -406,6 +509,19 @@ public:
       return true;
     }
 
+    // then the flat line table
+    VMA row_start, row_end;
+    if (table != NULL && table->find(vma, filenm, line, row_start, row_end)) {
+      realPath->realpath(filenm);
+
+      cache_filenm = filenm;
+      cache_line = line;
+      start = row_start;
+      end = row_end;
+
+      return true;
+    }
+
     // lookup with getStatement() and getSourceLines()
     StatementVector svec;
     getStatement(svec, vma, sym_func);
@@ -603,6 +719,14 @@ makeStructure(string filename,
   }
 
   Output::printStructFileBegin(outFile, gapsFile, sfilename);
+
+  // the saved output depends on the search path and can't include
+  // the full gaps file
+  if (! opts.reuse_file.empty() && outFile != NULL && gapsFile == NULL) {
+    reuse_cache = new ReuseCache;
+    reuse_cache->load(opts.reuse_file,
+		      string(HPCTOOLKIT_VERSION_STRING) + " " + search_path);
+  }
 	
   for (uint i = 0; i < elfFileVector->size(); i++) {
     bool parsable = true;
@@ -644,6 +768,8 @@ makeStructure(string filename,
       }
     }  // end parallel
 
+    makeLineTables(modVec);
+
     if (opts.show_time) {
       printTime("symtab:", &tv_init, &ru_init, &tv_symtab, &ru_symtab);
     }
@@ -701,34 +827,32 @@ makeStructure(string filename,
     WorkList wlPrint;
     WorkList wlLaunch;
     uint num_done = 0;
-    mutex output_mtx;
 
-    makeWorkList(fileMap, wlPrint, wlLaunch);
+    makeWorkList(fileMap, wlPrint);
+
+    // reuse applies to ordinary cpu binaries
+    reuse_this_file = (reuse_cache != NULL && parsable && ! cuda_file && ! intel_file);
+    if (reuse_this_file) {
+      makeLineRows(reuse_line_rows);
+    }
 		
     Output::printLoadModuleBegin(outFile, elfFile->getFileName());
 
-#pragma omp parallel  default(none)				\
-    shared(wlPrint, wlLaunch, num_done, output_mtx)		\
-    firstprivate(outFile, gapsFile, search_path, gaps_filenm, parsable)
-    {
-#pragma omp for  schedule(dynamic, 1)
-      for (uint i = 0; i < wlLaunch.size(); i++) {
-	doWorkItem(wlLaunch[i], search_path, parsable, gapsFile != NULL);
-
-	// the printing must be single threaded
-	if (output_mtx.try_lock()) {
-	  printWorkList(wlPrint, num_done, outFile, gapsFile, gaps_filenm);
-	  output_mtx.unlock();
-	}
-      }
-    }  // end parallel
-
-    // with try_lock(), there are interleavings where not all items
-    // have been printed.
-    printWorkList(wlPrint, num_done, outFile, gapsFile, gaps_filenm);
+    if (opts.mem_limit > 0) {
+      doPartitions(wlPrint, outFile, gapsFile, gaps_filenm, search_path, parsable);
+    }
+    else {
+      makeLaunchList(wlPrint, 0, wlPrint.size(), wlLaunch);
+      doWorkList(wlPrint, wlLaunch, num_done, outFile, gapsFile, gaps_filenm,
+		 search_path, parsable);
+    }
 
     Output::printLoadModuleEnd(outFile);
 
+    reuse_this_file = false;
+    reuse_line_rows.clear();
+    clearLineTables();
+
     if (opts.show_time) {
       printTime("struct:", &tv_parse, &ru_parse, &tv_fini, &ru_fini);
       printTime("total: ", &tv_init, &ru_init, &tv_fini, &ru_fini);
@@ -752,6 +876,12 @@ makeStructure(string filename,
   }
 
   Output::printStructFileEnd(outFile, gapsFile);
+
+  if (reuse_cache != NULL) {
+    reuse_cache->save();
+    delete reuse_cache;
+    reuse_cache = NULL;
+  }
 }
 
 //----------------------------------------------------------------------
@@ -767,6 +897,19 @@ doWorkItem(WorkItem * witem, string & search_path, bool parsable,
   FileInfo * finfo = witem->finfo;
   GroupInfo * ginfo = witem->ginfo;
 
+  // if the group is unchanged from the previous run, then reuse its
+  // output instead of the analysis.
+  if (reuse_this_file) {
+    witem->reuse_key = makeReuseKey(witem);
+    witem->reuse = reuse_cache->find(witem->reuse_key);
+
+    if (witem->reuse != NULL) {
+      ANNOTATE_HAPPENS_BEFORE(&witem->is_done);
+      witem->is_done.exchange(true);
+      return;
+    }
+  }
+
   // each work item gets its own string table and path manager to
   // avoid lock contention.
   HPC::StringTable * strTab = new HPC::StringTable;
@@ -803,12 +946,9 @@ doWorkItem(WorkItem * witem, string & search_path, bool parsable,
 // threads are idle.
 //
 static void
-makeWorkList(FileMap * fileMap, WorkList & wlPrint, WorkList & wlLaunch)
+makeWorkList(FileMap * fileMap, WorkList & wlPrint)
 {
-  double total_cost = 0.0;
-
   wlPrint.clear();
-  wlLaunch.clear();
 
   // the print order is determined by the hierarchy of files and
   // groups in the skeleton.
@@ -824,7 +964,6 @@ makeWorkList(FileMap * fileMap, WorkList & wlPrint, WorkList & wlLaunch)
       // the estimated time is non-linear in the size of the region
       double cost = ginfo->end - ginfo->start;
       cost *= cost;
-      total_cost += cost;
 
       WorkItem * witem =
 	new WorkItem(finfo, ginfo, (git == group_begin), (next_git == group_end), cost);
@@ -832,10 +971,25 @@ makeWorkList(FileMap * fileMap, WorkList & wlPrint, WorkList & wlLaunch)
       wlPrint.push_back(witem);
     }
   }
+}
+
+// Make the launch order for the items begin ... end - 1 of the print
+// order.
+//
+static void
+makeLaunchList(WorkList & wlPrint, uint begin, uint end, WorkList & wlLaunch)
+{
+  double total_cost = 0.0;
+
+  wlLaunch.clear();
+
+  for (uint i = begin; i < end; i++) {
+    total_cost += wlPrint[i]->cost;
+  }
 
   // if single-threaded, then order doesn't matter
   if (opts.jobs_struct == 1) {
-    wlLaunch = wlPrint;
+    wlLaunch.assign(wlPrint.begin() + begin, wlPrint.begin() + end);
     return;
   }
 
@@ -845,8 +999,8 @@ makeWorkList(FileMap * fileMap, WorkList & wlPrint, WorkList & wlLaunch)
   //
   double threshold = WORK_LIST_PCT * total_cost / ((double) opts.jobs_struct);
 
-  for (auto wit = wlPrint.begin(); wit != wlPrint.end(); ++wit) {
-    WorkItem * witem = *wit;
+  for (uint i = begin; i < end; i++) {
+    WorkItem * witem = wlPrint[i];
 
     if (witem->cost > threshold) {
       wlLaunch.push_back(witem);
@@ -856,8 +1010,8 @@ makeWorkList(FileMap * fileMap, WorkList & wlPrint, WorkList & wlLaunch)
   std::sort(wlLaunch.begin(), wlLaunch.end(), WorkItemGreaterThan);
 
   // add the small items in print order
-  for (auto wit = wlPrint.begin(); wit != wlPrint.end(); ++wit) {
-    WorkItem * witem = *wit;
+  for (uint i = begin; i < end; i++) {
+    WorkItem * witem = wlPrint[i];
 
     if (! witem->promote) {
       wlLaunch.push_back(witem);
@@ -867,6 +1021,208 @@ makeWorkList(FileMap * fileMap, WorkList & wlPrint, WorkList & wlLaunch)
 
 //----------------------------------------------------------------------
 
+//
+// Run doWorkItem() on the items in wlLaunch in parallel and print
+// them in wlPrint order as they finish.  On return, all items in
+// wlPrint up to the last one in wlLaunch are printed.
+//
+static void
+doWorkList(WorkList & wlPrint, WorkList & wlLaunch, uint & num_done,
+	   ostream * outFile, ostream * gapsFile, string & gaps_filenm,
+	   string & search_path, bool parsable)
+{
+  mutex output_mtx;
+
+#pragma omp parallel  default(none)				\
+    shared(wlPrint, wlLaunch, num_done, output_mtx)		\
+    firstprivate(outFile, gapsFile, search_path, gaps_filenm, parsable)
+  {
+#pragma omp for  schedule(dynamic, 1)
+    for (uint i = 0; i < wlLaunch.size(); i++) {
+      doWorkItem(wlLaunch[i], search_path, parsable, gapsFile != NULL);
+
+      // the printing must be single threaded
+      if (output_mtx.try_lock()) {
+	printWorkList(wlPrint, num_done, outFile, gapsFile, gaps_filenm);
+	output_mtx.unlock();
+      }
+    }
+  }  // end parallel
+
+  // with try_lock(), there are interleavings where not all items
+  // have been printed.
+  printWorkList(wlPrint, num_done, outFile, gapsFile, gaps_filenm);
+}
+
+//----------------------------------------------------------------------
+
+// Returns: the current resident set size in bytes, or else 0 if not
+// available.
+//
+// glibc keeps freed memory in its arenas, so first ask it to return
+// what it can to the kernel.  Otherwise, the RSS after the first large
+// partition never comes back down.
+//
+static long
+currentRSS()
+{
+  long pages = 0, rss = 0;
+
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+
+  FILE * fp = fopen("/proc/self/statm", "r");
+
+  if (fp == NULL) {
+    return 0;
+  }
+  if (fscanf(fp, "%ld %ld", &pages, &rss) != 2) {
+    rss = 0;
+  }
+  fclose(fp);
+
+  return rss * sysconf(_SC_PAGESIZE);
+}
+
+// Reset the peak RSS (VmHWM) to the current RSS (Linux 4.0 and later).
+// Returns: true on success.
+//
+static bool
+resetPeakRSS()
+{
+  FILE * fp = fopen("/proc/self/clear_refs", "w");
+
+  if (fp == NULL) {
+    return false;
+  }
+  bool ok = (fputs("5", fp) >= 0);
+  ok = (fclose(fp) == 0) && ok;
+
+  return ok;
+}
+
+// Returns: the peak resident set size (VmHWM) in bytes, or else 0 if
+// not available.
+//
+static long
+peakRSS()
+{
+  char line[256];
+  long kb = 0;
+  FILE * fp = fopen("/proc/self/status", "r");
+
+  if (fp == NULL) {
+    return 0;
+  }
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) {
+      break;
+    }
+  }
+  fclose(fp);
+
+  return kb * 1024;
+}
+
+//
+// Memory-bounded mode (opts.mem_limit > 0): run the work list in
+// partitions of consecutive items in print order.  Each partition is
+// analyzed in parallel, printed and its inline trees, string tables
+// and path managers freed before the next one starts, so at most one
+// partition of analysis state is resident.
+//
+// The partition size is in bytes of code.  We start with 1/16 of the
+// total.  After each partition, we take its own memory growth (peak
+// RSS during the partition minus the RSS before it) per byte of code
+// and size the next partition to fit the room left under the limit.
+// Every partition has at least jobs_struct items, so all threads have
+// work.
+//
+// Note: the ParseAPI code object, the line map and the skeleton are
+// still made for the whole binary before this phase.  If they alone
+// exceed the limit, we warn and continue with the smallest partitions.
+//
+static void
+doPartitions(WorkList & wlPrint, ostream * outFile, ostream * gapsFile,
+	     string & gaps_filenm, string & search_path, bool parsable)
+{
+  struct timeval tv_prev, tv_now;
+  struct rusage  ru_prev, ru_now;
+  WorkList wlLaunch;
+  uint num_done = 0;
+  long mem_limit = opts.mem_limit;
+  uint min_items = std::max(opts.jobs_struct, 1u);
+
+  double total_size = 0.0;
+  for (auto wit = wlPrint.begin(); wit != wlPrint.end(); ++wit) {
+    total_size += (*wit)->ginfo->end - (*wit)->ginfo->start;
+  }
+  double part_size = std::max(total_size / 16.0, 1.0);
+
+  long rss = currentRSS();
+  if (rss > mem_limit) {
+    DIAG_WMsg(1, "hpcstruct is using " << rss / (1024 * 1024)
+	      << " meg before analyzing functions, more than the limit of "
+	      << mem_limit / (1024 * 1024) << " meg");
+    part_size = 1.0;
+  }
+
+  if (opts.show_time) {
+    gettimeofday(&tv_prev, NULL);
+    getrusage(RUSAGE_SELF, &ru_prev);
+  }
+
+  uint begin = 0;
+  while (begin < wlPrint.size()) {
+    // each partition has at least min_items items
+    uint end = begin;
+    double size = 0.0;
+    while (end < wlPrint.size()
+	   && (end - begin < min_items || size < part_size)) {
+      size += wlPrint[end]->ginfo->end - wlPrint[end]->ginfo->start;
+      end++;
+    }
+
+    bool have_peak = resetPeakRSS();
+
+    makeLaunchList(wlPrint, begin, end, wlLaunch);
+    doWorkList(wlPrint, wlLaunch, num_done, outFile, gapsFile, gaps_filenm,
+	       search_path, parsable);
+    begin = end;
+
+    long peak = have_peak ? peakRSS() : 0;
+    long prev_rss = rss;
+    rss = currentRSS();
+
+    // without the peak, fall back on what the partition left behind
+    long growth = ((peak > 0) ? peak : rss) - prev_rss;
+    long room = mem_limit - rss;
+
+    if (room <= 0) {
+      part_size = 1.0;
+    }
+    else if (growth > 0 && size > 0.0) {
+      part_size = room / (growth / size);
+      part_size = std::max(std::min(part_size, total_size), 1.0);
+    }
+    else {
+      part_size = std::min(part_size * 2.0, total_size);
+    }
+
+    if (opts.show_time) {
+      printTime("part:  ", &tv_prev, &ru_prev, &tv_now, &ru_now);
+      cout << "funcs: " << begin << " / " << wlPrint.size()
+	   << "  rss: " << rss / (1024 * 1024) << " meg"
+	   << "  peak: " << peak / (1024 * 1024) << " meg" << endl;
+      tv_prev = tv_now;
+      ru_prev = ru_now;
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+
 //
 // Scan the work list from num_done to end for items that are ready to
 // be printed.  The output order is always work list order, regardless
@@ -890,14 +1246,36 @@ printWorkList(WorkList & workList, uint & num_done, ostream * outFile,
       Output::printFileBegin(outFile, finfo);
     }
 
-    for (auto pit = ginfo->procMap.begin(); pit != ginfo->procMap.end(); ++pit) {
-      ProcInfo * pinfo = pit->second;
+    if (witem->reuse != NULL) {
+      const ReuseEntry * entry = witem->reuse;
+      Output::printSavedProcs(outFile, entry->text, entry->first_index,
+			      entry->num_index);
+    }
+    else {
+      // with a reuse key, print to a buffer to save the text
+      stringstream buf;
+      ostream * procFile = witem->reuse_key.empty() ? outFile : &buf;
+      long first_index = Output::nextIndex();
+
+      for (auto pit = ginfo->procMap.begin(); pit != ginfo->procMap.end(); ++pit) {
+	ProcInfo * pinfo = pit->second;
 
-      if (! pinfo->gap_only) {
-	Output::printProc(outFile, gapsFile, gaps_filenm, finfo, ginfo, pinfo, *strTab);
+	if (! pinfo->gap_only) {
+	  Output::printProc(procFile, gapsFile, gaps_filenm, finfo, ginfo, pinfo, *strTab);
+	}
+	delete pinfo->root;
+	pinfo->root = NULL;
+      }
+
+      if (! witem->reuse_key.empty()) {
+	ReuseEntry entry;
+	entry.text = buf.str();
+	entry.first_index = first_index;
+	entry.num_index = Output::nextIndex() - first_index;
+
+	*outFile << entry.text;
+	reuse_cache->insert(witem->reuse_key, entry);
       }
-      delete pinfo->root;
-      pinfo->root = NULL;
     }
 
     if (witem->last_proc) {
@@ -917,6 +1295,234 @@ printWorkList(WorkList & workList, uint & num_done, ostream * outFile,
 
 //----------------------------------------------------------------------
 
+// Sort line rows by start address.
+static bool
+LineRowLessThan(const LineInformation::Statement_t & s1,
+		const LineInformation::Statement_t & s2)
+{
+  return s1->startAddr() < s2->startAddr();
+}
+
+static bool
+VMALessThanLineRow(VMA vma, const LineInformation::Statement_t & st)
+{
+  return vma < st->startAddr();
+}
+
+//
+// Make the list of line rows (the line map) for the whole file,
+// sorted by start address.  This is for the reuse fingerprints, so we
+// can find the slice of the line map for one function without a
+// lookup per address.
+//
+static void
+makeLineRows(LineRowVec & rows)
+{
+  vector <Module *> modVec;
+  the_symtab->getAllModules(modVec);
+
+  rows.clear();
+
+  for (auto mit = modVec.begin(); mit != modVec.end(); ++mit) {
+    LineRowVec modRows;
+
+    if (*mit != NULL && (*mit)->getStatements(modRows)) {
+      rows.insert(rows.end(), modRows.begin(), modRows.end());
+    }
+  }
+
+  std::stable_sort(rows.begin(), rows.end(), LineRowLessThan);
+}
+
+// Make the flat line table (cf. LineTable) for each module, one
+// module per thread, as the line maps were parsed.
+//
+static void
+makeLineTables(vector <Module *> & modVec)
+{
+  vector <LineTable *> tables(modVec.size());
+
+#pragma omp parallel  shared(modVec, tables)
+  {
+#pragma omp for  schedule(dynamic, 1)
+    for (uint i = 0; i < modVec.size(); i++) {
+      tables[i] = new LineTable;
+      tables[i]->make(modVec[i]);
+    }
+  }  // end parallel
+
+  for (uint i = 0; i < modVec.size(); i++) {
+    if (modVec[i] != NULL && line_tables.find(modVec[i]) == line_tables.end()) {
+      line_tables[modVec[i]] = tables[i];
+    }
+    else {
+      delete tables[i];
+    }
+  }
+}
+
+static void
+clearLineTables()
+{
+  for (auto it = line_tables.begin(); it != line_tables.end(); ++it) {
+    delete it->second;
+  }
+  line_tables.clear();
+}
+
+void
+LineTable::make(Module * mod)
+{
+  LineRowVec rows;
+
+  if (mod == NULL || ! mod->getStatements(rows)) {
+    return;
+  }
+  std::stable_sort(rows.begin(), rows.end(), LineRowLessThan);
+
+  start.reserve(rows.size());
+  end.reserve(rows.size());
+  reach.reserve(rows.size());
+  file.reserve(rows.size());
+  line.reserve(rows.size());
+
+  map <string, uint> nameMap;
+  VMA max_end = 0;
+
+  for (auto it = rows.begin(); it != rows.end(); ++it) {
+    const LineInformation::Statement_t & st = *it;
+    auto ret = nameMap.insert(make_pair(st->getFile(), (uint) names.size()));
+    if (ret.second) {
+      names.push_back(st->getFile());
+    }
+
+    start.push_back(st->startAddr());
+    end.push_back(st->endAddr());
+    reach.push_back(max_end);
+    file.push_back(ret.first->second);
+    line.push_back(st->getLine());
+
+    max_end = std::max(max_end, (VMA) st->endAddr());
+  }
+}
+
+// Add the line rows that overlap [start, end), plus the inline
+// sequence at the start of each row, to the fingerprint data.
+static void
+addLineRows(ostream & data, VMA start, VMA end)
+{
+  auto it = std::upper_bound(reuse_line_rows.begin(), reuse_line_rows.end(),
+			     start, VMALessThanLineRow);
+
+  // the previous row may contain start
+  if (it != reuse_line_rows.begin()) {
+    --it;
+  }
+
+  for (; it != reuse_line_rows.end() && (*it)->startAddr() < end; ++it) {
+    const LineInformation::Statement_t & st = *it;
+    VMA vma = std::max((VMA) st->startAddr(), start);
+
+    if (st->endAddr() <= start) {
+      continue;
+    }
+
+    data << "l " << st->startAddr() << " " << st->endAddr()
+	 << " " << st->getLine() << " " << st->getColumn()
+	 << " " << st->getFile() << "\n";
+
+    FunctionBase * func = NULL;
+
+    if (the_symtab->getContainingInlinedFunction(vma, func) && func != NULL) {
+      FunctionBase * parent = func->getInlinedParent();
+
+      while (parent != NULL) {
+	InlinedFunction * ifunc = static_cast <InlinedFunction *> (func);
+	pair <string, Offset> callsite = ifunc->getCallsite();
+
+	data << "i " << callsite.second << " " << callsite.first
+	     << " " << func->getName() << "\n";
+
+	func = parent;
+	parent = func->getInlinedParent();
+      }
+    }
+  }
+}
+
+//
+// Make the reuse key for one work item (proc group): a fingerprint of
+// everything its output depends on.  That is, the skeleton info that
+// goes into the <P> tags, the blocks and edges from ParseAPI and
+// their code bytes, and the slice of the line map and inline info for
+// the group's range and blocks.
+//
+// Note: the output contains absolute addresses, so a function that
+// moved is analyzed again, even if its code is the same.
+//
+static string
+makeReuseKey(WorkItem * witem)
+{
+  FileInfo * finfo = witem->finfo;
+  GroupInfo * ginfo = witem->ginfo;
+  stringstream data;
+
+  data << hex
+       << "g " << ginfo->start << " " << ginfo->end << " " << ginfo->alt_file
+       << " " << finfo->fileName << "\n";
+
+  for (auto pit = ginfo->procMap.begin(); pit != ginfo->procMap.end(); ++pit) {
+    ProcInfo * pinfo = pit->second;
+    ParseAPI::Function * func = pinfo->func;
+
+    data << "p " << pinfo->entry_vma << " " << pinfo->line_num
+	 << " " << pinfo->symbol_index << " " << pinfo->gap_only << "\n"
+	 << pinfo->linkName << "\n"
+	 << pinfo->prettyName << "\n";
+
+    if (func == NULL) {
+      continue;
+    }
+
+    vector <Block *> bvec;
+    const ParseAPI::Function::blocklist & blist = func->blocks();
+
+    for (auto bit = blist.begin(); bit != blist.end(); ++bit) {
+      bvec.push_back(*bit);
+    }
+    std::sort(bvec.begin(), bvec.end(), BlockLessThan);
+
+    for (auto bit = bvec.begin(); bit != bvec.end(); ++bit) {
+      Block * block = *bit;
+      VMA start = block->start();
+      VMA end = block->end();
+
+      data << "b " << start << " " << end << "\n";
+
+      const char * bytes =
+	(const char *) block->region()->getPtrToInstruction(start);
+      if (bytes != NULL) {
+	data.write(bytes, end - start);
+      }
+
+      const Block::edgelist & outEdges = block->targets();
+      for (auto eit = outEdges.begin(); eit != outEdges.end(); ++eit) {
+	Edge * edge = *eit;
+	data << "e " << edge->type() << " " << edge->sinkEdge()
+	     << " " << edge->trg()->start() << "\n";
+      }
+
+      addLineRows(data, start, end);
+    }
+  }
+
+  addLineRows(data, ginfo->start, ginfo->end);
+
+  return reuseFingerprint(data.str());
+}
+
+//----------------------------------------------------------------------
+
 // codeMap is a map of all code regions from start vma to Region *.
 // Used to find the region containing a vma and thus the region's end.
 //
@@ -76,6 +76,19 @@ public:
 
   unsigned long parallel_analysis_threshold;
 
+  // if non-empty, reuse the output for unchanged functions from this
+  // file and save the output for the next run (cf. Struct-Reuse.hpp)
+  std::string reuse_file;
+
+  // if non-zero, analyze functions in partitions, keeping the resident
+  // set size under this many bytes where possible
+  unsigned long mem_limit;
+
+  Options()
+  {
+    mem_limit = 0;
+  }
+
   void set
   (
    unsigned int _jobs,
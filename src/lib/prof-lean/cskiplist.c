@@ -285,8 +285,9 @@ cskiplist_find_helper
 static csklnode_t *
 cskiplist_find(val_cmp compare, cskiplist_t *cskl, void* value)
 {
-  // Acquire lock before reading:
-  pfq_rwlock_read_lock(&cskl->lock);
+  // Acquire lock before reading, unless deleted nodes are reclaimed
+  // by epoch, in which case the caller is inside a read-side critical section:
+  if (!cskl->ebr) pfq_rwlock_read_lock(&cskl->lock);
 
   int     max_height  = cskl->max_height;
   csklnode_t *preds[max_height];
@@ -301,7 +302,7 @@ cskiplist_find(val_cmp compare, cskiplist_t *cskl, void* value)
   }
 
   // Release lock after reading:
-  pfq_rwlock_read_unlock(&cskl->lock);
+  if (!cskl->ebr) pfq_rwlock_read_unlock(&cskl->lock);
 
   return node;
 }
@@ -336,6 +337,25 @@ cskl_links_tostr(int max_height, char str[], int max_cskl_str_len)
   strncat(str, "\n", max_cskl_str_len - str_len - 1);
 }
 
+/*
+ * free each node on the limbo list that no reader can still reach.
+ * pre-condition: the write lock is held.
+ */
+static void
+cskl_limbo_reclaim(cskiplist_t *cskl)
+{
+  csklnode_t **prev = &cskl->limbo;
+  while (*prev) {
+	csklnode_t *node = *prev;
+	if (ebr_reclaimable(cskl->ebr, node->retire_tag)) {
+	  *prev = node->limbo_next;
+	  node->limbo_free(node);
+	} else {
+	  prev = &node->limbo_next;
+	}
+  }
+}
+
 static bool
 cskl_del_bulk_unsynch(val_cmp cmpfn, cskiplist_t *cskl, void *lo, void *hi, mem_free m_free)
 {
@@ -356,6 +376,7 @@ cskl_del_bulk_unsynch(val_cmp cmpfn, cskiplist_t *cskl, void *lo, void *hi, mem_
   int hlayer = cskiplist_find_helper(cmpfn, max_height, cskl->left_sentinel, lo, lpreds,
 				     other, cskiplist_find_full);
   csklnode_t *first = lpreds[0]->nexts[0];
+
   if (lo == hi)
     succs = lpreds;
   else {
@@ -389,10 +410,25 @@ cskl_del_bulk_unsynch(val_cmp cmpfn, cskiplist_t *cskl, void *lo, void *hi, mem_
   // Delete all of the nodes between first and last.
   //----------------------------------------------------------------------------
 
-  for (csklnode_t *node = first; node != last;) {
-	csklnode_t *next = node->nexts[0]; // remember the pointer before trashing node
-	m_free(node); // delete node
-	node = next;
+  if (cskl->ebr) {
+	// readers may still be traversing the spliced-out nodes, whose links
+	// are left intact; mark them so that finds reject them and defer their
+	// deletion until the readers are done.
+	uint64_t tag = ebr_retire(cskl->ebr);
+	for (csklnode_t *node = first; node != last; node = node->nexts[0]) {
+	  node->marked = true;
+	  node->retire_tag = tag;
+	  node->limbo_free = m_free;
+	  node->limbo_next = cskl->limbo;
+	  cskl->limbo = node;
+	}
+	cskl_limbo_reclaim(cskl);
+  } else {
+	for (csklnode_t *node = first; node != last;) {
+	  csklnode_t *next = node->nexts[0]; // remember the pointer before trashing node
+	  m_free(node); // delete node
+	  node = next;
+	}
   }
 
   // Release lock after writing:
@@ -444,6 +480,7 @@ cskl_new(
 	int max_height,
 	val_cmp compare,
 	val_cmp inrange,
+	ebr_t *ebr,
 	mem_alloc m_alloc)
 {
   cskiplist_t* cskl = (cskiplist_t*)m_alloc(sizeof(cskiplist_t));
@@ -451,6 +488,8 @@ cskl_new(
   cskl->compare = compare;
   cskl->inrange = inrange;
   pfq_rwlock_init(&cskl->lock);
+  cskl->ebr = ebr;
+  cskl->limbo = NULL;
 
   // create sentinel nodes
   csklnode_t *left = cskl->left_sentinel   = csklnode_alloc_node(max_height, m_alloc);
@@ -107,6 +107,12 @@ typedef void (*cskl_node_tostr)(void* node_val, int node_height, int max_height,
 void
 cskl_init();
 
+/*
+ * If ebr is non-null, cskl_cmp_find and cskl_inrange_find do not lock;
+ * callers must be inside an ebr_enter/ebr_exit critical section on ebr
+ * for as long as they use a node value returned by a find. Nodes removed
+ * by a bulk delete are then freed only once no such reader remains.
+ */
 cskiplist_t*
 cskl_new(
 	void *lsentinel,
@@ -114,6 +120,7 @@ cskl_new(
 	int maxheight,
 	val_cmp compare,
 	val_cmp inrange,
+	ebr_t *ebr,
 	mem_alloc m_alloc);
 
 void
@@ -58,6 +58,9 @@
 #ifndef __CSKIPLIST_DEFS_H__
 #define __CSKIPLIST_DEFS_H__
 
+#include <stdint.h>
+
+#include "ebr.h"
 #include "mcs-lock.h"
 #include "pfq-rwlock.h"
 
@@ -67,6 +70,10 @@ typedef struct csklnode_s {
   volatile bool fully_linked;
   volatile bool marked;
   mcs_lock_t lock;
+  // deleted nodes wait on the limbo list until no reader can reach them
+  struct csklnode_s *limbo_next;
+  uint64_t retire_tag;
+  mem_free limbo_free;
   // memory allocated for a node will include space for its vector of  pointers
   struct csklnode_s *nexts[];
 } csklnode_t;
@@ -78,6 +85,8 @@ typedef struct cskiplist_s {
   val_cmp compare;
   val_cmp inrange;
   pfq_rwlock_t lock;
+  ebr_t *ebr;         // if non-null, finds are lock-free and deletes deferred
+  csklnode_t *limbo;  // deleted nodes awaiting reclamation
 } cskiplist_t;
 
 #endif /* __CSKIPLIST_DEFS_H__ */
@@ -0,0 +1,140 @@
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL$
+// $Id$
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+//******************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Implement epoch-based reclamation (EBR) for lock-free readers.
+//
+// Notes:
+//   a writer retires objects by advancing the global epoch after they have
+//   been unlinked. a reader that pins an epoch at or after the tag returned
+//   by ebr_retire loaded the global epoch after the unlink and therefore
+//   cannot reach the retired objects. an object is reclaimable once every
+//   reader record is either quiescent or pinned at or after its tag.
+//
+//******************************************************************************
+
+
+
+//******************************************************************************
+// local includes
+//******************************************************************************
+
+#include "ebr.h"
+
+
+
+//******************************************************************************
+// interface operations
+//******************************************************************************
+
+void
+ebr_init(ebr_t *e)
+{
+  atomic_init(&e->epoch, EBR_QUIESCENT + 1);
+  atomic_init(&e->records, NULL);
+}
+
+
+ebr_record_t *
+ebr_record_new(ebr_t *e, mem_alloc m_alloc)
+{
+  ebr_record_t *r = (ebr_record_t *) m_alloc(sizeof(ebr_record_t));
+  atomic_init(&r->epoch, EBR_QUIESCENT);
+
+  ebr_record_t *head = atomic_load_explicit(&e->records, memory_order_relaxed);
+  do {
+    r->next = head;
+  } while (!atomic_compare_exchange_weak_explicit(&e->records, &head, r,
+						  memory_order_release,
+						  memory_order_relaxed));
+  return r;
+}
+
+
+bool
+ebr_enter(ebr_t *e, ebr_record_t *r)
+{
+  if (atomic_load_explicit(&r->epoch, memory_order_relaxed) != EBR_QUIESCENT)
+    return false;
+
+  uint64_t epoch = atomic_load_explicit(&e->epoch, memory_order_relaxed);
+  atomic_store_explicit(&r->epoch, epoch, memory_order_relaxed);
+
+  // the pinned epoch must be visible before any load of the shared
+  // structure; without the fence the store could be reordered after them.
+  atomic_thread_fence(memory_order_seq_cst);
+  return true;
+}
+
+
+void
+ebr_exit(ebr_record_t *r)
+{
+  atomic_store_explicit(&r->epoch, EBR_QUIESCENT, memory_order_release);
+}
+
+
+uint64_t
+ebr_retire(ebr_t *e)
+{
+  // order the preceding unlinks before the epoch advance
+  return atomic_fetch_add(&e->epoch, 1) + 1;
+}
+
+
+bool
+ebr_reclaimable(ebr_t *e, uint64_t tag)
+{
+  ebr_record_t *r = atomic_load_explicit(&e->records, memory_order_acquire);
+  for (; r != NULL; r = r->next) {
+    uint64_t epoch = atomic_load(&r->epoch);
+    if (epoch != EBR_QUIESCENT && epoch < tag) return false;
+  }
+  return true;
+}
@@ -0,0 +1,154 @@
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL$
+// $Id$
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+//******************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Define an API for epoch-based reclamation (EBR) of memory shared with
+//   lock-free readers.
+//
+//   Readers bracket each access to a shared structure with ebr_enter and
+//   ebr_exit; neither blocks or writes any location other than the reader's
+//   own record. A writer that unlinks an object calls ebr_retire to obtain
+//   an epoch tag for it; the object may be reused once ebr_reclaimable
+//   reports that every reader that could have observed it has exited.
+//
+//   Writers never wait for readers. This matters for hpcrun, where a
+//   thread may unlink objects while it is itself inside a critical
+//   section (e.g. dlclose called from a sample handler).
+//
+// Reference:
+//   Keir Fraser. 2004. Practical lock-freedom. Ph.D. thesis, University of
+//   Cambridge Computer Laboratory, Technical Report UCAM-CL-TR-579.
+//
+//******************************************************************************
+
+#ifndef __ebr_h__
+#define __ebr_h__
+
+//******************************************************************************
+// global includes
+//******************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+
+//******************************************************************************
+// local includes
+//******************************************************************************
+
+#include "stdatomic.h"
+#include "mem_manager.h"
+
+
+
+//******************************************************************************
+// macros
+//******************************************************************************
+
+// epoch value of a reader record outside of a critical section
+#define EBR_QUIESCENT 0
+
+
+
+//******************************************************************************
+// types
+//******************************************************************************
+
+typedef struct ebr_record_s {
+  atomic_uint_least64_t epoch;     // EBR_QUIESCENT or epoch pinned at entry
+  struct ebr_record_s *next;       // records are never removed from a domain
+} ebr_record_t;
+
+
+typedef struct {
+  atomic_uint_least64_t epoch;     // global epoch; starts at 1
+  _Atomic(ebr_record_t *) records; // push-only list of reader records
+} ebr_t;
+
+
+
+//******************************************************************************
+// interface operations
+//******************************************************************************
+
+void
+ebr_init(ebr_t *e);
+
+
+// allocate a reader record with m_alloc and add it to the domain.
+// records are never freed: m_alloc may be a non-freeing allocator.
+ebr_record_t *
+ebr_record_new(ebr_t *e, mem_alloc m_alloc);
+
+
+// enter a read-side critical section. nested entries keep the epoch
+// pinned by the outermost one. returns true if this call pinned the
+// epoch, i.e. the caller owns the matching ebr_exit.
+bool
+ebr_enter(ebr_t *e, ebr_record_t *r);
+
+
+void
+ebr_exit(ebr_record_t *r);
+
+
+// called by a writer after it has unlinked one or more objects.
+// returns the tag to associate with those objects.
+uint64_t
+ebr_retire(ebr_t *e);
+
+
+// true if no reader can still hold a reference to an object retired
+// with the given tag.
+bool
+ebr_reclaimable(ebr_t *e, uint64_t tag);
+
+
+#endif
@@ -71,6 +71,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <endian.h>
 
 #include <sys/stat.h>
 
@@ -85,6 +86,40 @@
 
 //***************************************************************************
 
+// Fields are located from the end since <prog> may itself contain '-'.
+void
+hpcrun_fmt_fnm_rank_thread(const char* fnm, int* rank, int* thread)
+{
+  *rank = -1;
+  *thread = -1;
+
+  const char* base = strrchr(fnm, '/');
+  base = (base) ? base + 1 : fnm;
+
+  const char* end = strrchr(base, '.');
+  if (!end) {
+    end = base + strlen(base);
+  }
+
+  // sep[k] is the k-th '-' from the end; sep[4] precedes the rank
+  const char* sep[5];
+  for (int k = 0; k < 5; k++) {
+    const char* p = end;
+    while (p > base && *(p - 1) != '-') {
+      p--;
+    }
+    if (p <= base + 1) {
+      return;
+    }
+    sep[k] = p - 1;
+    end = sep[k];
+  }
+
+  *rank = atoi(sep[4] + 1);
+  *thread = atoi(sep[3] + 1);
+}
+
+
 //***************************************************************************
 // hdr
 //***************************************************************************
@@ -902,6 +937,51 @@ hpctrace_fmt_datum_fread(hpctrace_fmt_datum_t* x, hpctrace_hdr_flags_t flags,
 }
 
 
+size_t
+hpctrace_fmt_datum_size(hpctrace_hdr_flags_t flags)
+{
+  size_t sz = sizeof(uint64_t) + sizeof(uint32_t);
+  if (HPCTRACE_HDR_FLAGS_GET_BIT(flags, HPCTRACE_HDR_FLAGS_DATA_CENTRIC_BIT_POS)) {
+    sz += sizeof(uint32_t);
+  }
+  return sz;
+}
+
+
+// the two record layouts get separate loops so that the body is free
+// of branches and the byte swaps can be vectorized.
+void
+hpctrace_fmt_data_decode(hpctrace_fmt_datum_t* x, int n,
+			 hpctrace_hdr_flags_t flags, const void* buf)
+{
+  const unsigned char* p = (const unsigned char*) buf;
+
+  if (HPCTRACE_HDR_FLAGS_GET_BIT(flags, HPCTRACE_HDR_FLAGS_DATA_CENTRIC_BIT_POS)) {
+    for (int i = 0; i < n; i++, p += 16) {
+      uint64_t comp;
+      uint32_t cpId, metricId;
+      memcpy(&comp, p, sizeof(comp));
+      memcpy(&cpId, p + 8, sizeof(cpId));
+      memcpy(&metricId, p + 12, sizeof(metricId));
+      x[i].comp = be64toh(comp);
+      x[i].cpId = be32toh(cpId);
+      x[i].metricId = be32toh(metricId);
+    }
+  }
+  else {
+    for (int i = 0; i < n; i++, p += 12) {
+      uint64_t comp;
+      uint32_t cpId;
+      memcpy(&comp, p, sizeof(comp));
+      memcpy(&cpId, p + 8, sizeof(cpId));
+      x[i].comp = be64toh(comp);
+      x[i].cpId = be32toh(cpId);
+      x[i].metricId = HPCTRACE_FMT_MetricId_NULL;
+    }
+  }
+}
+
+
 // Append the trace record to the outbuf.
 // Returns: HPCFMT_OK on success, else HPCFMT_ERR.
 int
@@ -942,6 +1022,48 @@ hpctrace_fmt_datum_outbuf(hpctrace_fmt_datum_t* x, hpctrace_hdr_flags_t flags,
 }
 
 
+// encode 'n' data into big-endian records in a local chunk, so that the
+// byte swaps form a tight loop and the output buffer is written once
+// per chunk rather than once per datum.
+int
+hpctrace_fmt_data_outbuf(hpctrace_fmt_datum_t* x, int n,
+			 hpctrace_hdr_flags_t flags, hpcio_outbuf_t* outbuf)
+{
+  enum { chunkLen = 256 };
+  unsigned char buf[chunkLen * sizeof(hpctrace_fmt_datum_t)];
+
+  bool dataCentric =
+    HPCTRACE_HDR_FLAGS_GET_BIT(flags, HPCTRACE_HDR_FLAGS_DATA_CENTRIC_BIT_POS);
+  const size_t recSZ = sizeof(uint64_t) + sizeof(uint32_t)
+    + (dataCentric ? sizeof(uint32_t) : 0);
+
+  for (int i = 0; i < n; i += chunkLen) {
+    int len = (n - i < chunkLen) ? n - i : chunkLen;
+    unsigned char* p = buf;
+
+    for (int j = 0; j < len; j++) {
+      const hpctrace_fmt_datum_t* d = &x[i + j];
+      uint64_t comp = htobe64(d->comp);
+      uint32_t cpId = htobe32(d->cpId);
+      memcpy(p, &comp, sizeof(comp));
+      memcpy(p + sizeof(comp), &cpId, sizeof(cpId));
+      if (dataCentric) {
+	uint32_t metricId = htobe32(d->metricId);
+	memcpy(p + sizeof(comp) + sizeof(cpId), &metricId, sizeof(metricId));
+      }
+      p += recSZ;
+    }
+
+    size_t sz = p - buf;
+    if (hpcio_outbuf_write(outbuf, buf, sz) != (ssize_t) sz) {
+      return HPCFMT_ERR;
+    }
+  }
+
+  return HPCFMT_OK;
+}
+
+
 int
 hpctrace_fmt_datum_fwrite(hpctrace_fmt_datum_t* x, hpctrace_hdr_flags_t flags,
 			  FILE* outfs)
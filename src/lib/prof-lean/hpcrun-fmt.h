@@ -104,6 +104,14 @@ static const char HPCPROF_MetricDBSfx[] = "metric-db";
 static const char HPCPROF_TmpFnmSfx[] = "tmp";
 
 
+// Parse the MPI rank and thread id from the name of a file hpcrun
+// wrote: <prog>-<rank>-<thread>-<host>-<pid>-<gen>.<sfx> (cf.
+// FILENAME_TEMPLATE in hpcrun/files.c).  Either is -1 if 'fnm' does
+// not have this form.
+void
+hpcrun_fmt_fnm_rank_thread(const char* fnm, int* rank, int* thread);
+
+
 //***************************************************************************
 // hdr
 //***************************************************************************
@@ -717,10 +725,27 @@ int
 hpctrace_fmt_datum_fread(hpctrace_fmt_datum_t* x, hpctrace_hdr_flags_t flags,
 			 FILE* fs);
 
+// size in bytes of one trace record in a file whose header has 'flags'
+size_t
+hpctrace_fmt_datum_size(hpctrace_hdr_flags_t flags);
+
+// decode the 'n' big-endian records at 'buf' (e.g. a mapped or
+// block-read trace file past its header) into x[0..n-1]; equivalent
+// to, but cheaper than, 'n' calls to hpctrace_fmt_datum_fread
+void
+hpctrace_fmt_data_decode(hpctrace_fmt_datum_t* x, int n,
+			 hpctrace_hdr_flags_t flags, const void* buf);
+
 int
 hpctrace_fmt_datum_outbuf(hpctrace_fmt_datum_t* x, hpctrace_hdr_flags_t flags,
 			  hpcio_outbuf_t* outbuf);
 
+// write the 'n' data x[0..n-1]; equivalent to, but cheaper than, 'n'
+// calls to hpctrace_fmt_datum_outbuf
+int
+hpctrace_fmt_data_outbuf(hpctrace_fmt_datum_t* x, int n,
+			 hpctrace_hdr_flags_t flags, hpcio_outbuf_t* outbuf);
+
 // N.B.: not async safe
 int
 hpctrace_fmt_datum_fwrite(hpctrace_fmt_datum_t* x, hpctrace_hdr_flags_t flags,
@@ -62,7 +62,15 @@
 // interface functions
 //******************************************************************************
 
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
 // return the time of day in microseconds as a long integer
 unsigned long usec_time();
 
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif
+
 #endif  
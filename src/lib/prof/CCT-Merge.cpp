@@ -113,6 +113,81 @@ MergeContext::fillCPIdSet(Tree* cct)
 }
 
 
+MergeContext::ChildKey
+MergeContext::childKey(const ADynNode& x)
+{
+  ChildKey key;
+  key.lmId = x.lmId_real();
+  key.lmIP = x.lmIP_real();
+  return key;
+}
+
+
+// Index the children of 'x'.  Returns false, leaving 'idx' empty, if
+// some child is not an ADynNode: findDynChild() then searches below
+// it, which the index cannot express.
+bool
+MergeContext::makeChildIndex(ANode* x, ChildIndex& idx)
+{
+  for (ANodeChildIterator it(x); it.Current(); ++it) {
+    ADynNode* x_dyn = dynamic_cast<ADynNode*>(it.current());
+    if (!x_dyn) {
+      idx.clear();
+      return false;
+    }
+    idx[childKey(*x_dyn)].push_back(x_dyn);
+  }
+  return true;
+}
+
+
+ADynNode*
+MergeContext::findDynChild(ANode* x, const ADynNode& y_dyn)
+{
+  // The index covers the standard merge condition only.  The special
+  // condition for structured leaves (see ADynNode::isMergable()) can
+  // match a child with a different IP, so those take the slow path.
+  if (x->childCount() < ChildIndexThreshold
+      || (y_dyn.isLeaf() && y_dyn.structure())) {
+    return x->findDynChild(y_dyn);
+  }
+
+  std::unordered_map<const ANode*, ChildIndex>::iterator it =
+    m_childIdxs.find(x);
+  if (it == m_childIdxs.end()) {
+    it = m_childIdxs.insert(std::make_pair(x, ChildIndex())).first;
+    makeChildIndex(x, it->second);
+  }
+
+  ChildIndex& idx = it->second;
+  if (idx.empty()) {
+    return x->findDynChild(y_dyn);
+  }
+
+  ChildIndex::iterator cands = idx.find(childKey(y_dyn));
+  if (cands != idx.end()) {
+    for (uint i = 0; i < cands->second.size(); ++i) {
+      ADynNode* x_dyn = cands->second[i];
+      if (ADynNode::isMergable(*x_dyn, y_dyn)) {
+	return x_dyn;
+      }
+    }
+  }
+  return NULL;
+}
+
+
+void
+MergeContext::noteDynChild(ANode* x, ADynNode* x_child)
+{
+  std::unordered_map<const ANode*, ChildIndex>::iterator it =
+    m_childIdxs.find(x);
+  if (it != m_childIdxs.end() && !it->second.empty()) {
+    it->second[childKey(*x_child)].push_back(x_child);
+  }
+}
+
+
 //***************************************************************************
 // MergeEffect
 //***************************************************************************
@@ -68,11 +68,14 @@
 #include <vector>
 #include <list>
 #include <set>
+#include <unordered_map>
 
 //*************************** User Include Files ****************************
 
 #include <include/uint.h>
 
+#include <lib/isa/ISATypes.hpp>
+
 #include <lib/prof-lean/hpcrun-fmt.h>
 
 #include <lib/support/diagnostics.h>
@@ -89,6 +92,9 @@ namespace Prof {
 
 namespace CCT {
 
+class ANode;
+class ADynNode;
+
 struct MergeEffect {
   MergeEffect()
     : old_cpId(HPCRUN_FMT_CCTNodeId_NULL), new_cpId(HPCRUN_FMT_CCTNodeId_NULL)
@@ -244,6 +250,29 @@ public:
   }
 
 
+  // -------------------------------------------------------
+  // child index: while merging, a node of the destination tree with
+  // many children gets a hash index of them, keyed by load module and
+  // IP, so that finding the child a source node merges with is not a
+  // linear scan.  Indexes are only valid during one Tree::merge();
+  // other operations may restructure the tree in between.
+  // -------------------------------------------------------
+
+  // Returns x->findDynChild(y_dyn), using or building x's index
+  ADynNode*
+  findDynChild(ANode* x, const ADynNode& y_dyn);
+
+  // Notes that 'x_child' has just been linked as the last child of 'x'
+  void
+  noteDynChild(ANode* x, ADynNode* x_child);
+
+  void
+  clearChildIndexes()
+  { m_childIdxs.clear(); }
+
+  // children a node needs before it is indexed
+  static const uint ChildIndexThreshold = 16;
+
   uint
   makeCPId()
   {
@@ -258,6 +287,32 @@ private:
   void
   fillCPIdSet(Tree* cct);
 
+  struct ChildKey {
+    uint lmId;
+    VMA lmIP;
+
+    bool
+    operator==(const ChildKey& y) const
+    { return lmId == y.lmId && lmIP == y.lmIP; }
+  };
+
+  struct ChildKeyHash {
+    size_t
+    operator()(const ChildKey& x) const
+    { return std::hash<VMA>()(x.lmIP) ^ ((size_t)x.lmId << 40); }
+  };
+
+  // candidates for each key, in child order; ADynNode::isMergable()
+  // makes the final decision
+  typedef std::unordered_map<ChildKey, std::vector<ADynNode*>, ChildKeyHash>
+    ChildIndex;
+
+  static ChildKey
+  childKey(const ADynNode& x);
+
+  bool
+  makeChildIndex(ANode* x, ChildIndex& idx);
+
 private:
   const Tree* m_cct;
 
@@ -265,6 +320,8 @@ private:
 
   bool m_isTrackingCPIds;
   CPIdSet m_cpIdSet;
+
+  std::unordered_map<const ANode*, ChildIndex> m_childIdxs;
 };
 
 } // namespace CCT
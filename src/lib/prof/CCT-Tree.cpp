@@ -76,9 +76,13 @@ using std::set;
 
 #include <typeinfo>
 
+#include <algorithm>
+#include <unordered_set>
+
 //*************************** User Include Files ****************************
 
 #include <include/gcc-attr.h>
+#include <include/hpctoolkit-config.h>
 #include <include/uint.h>
 
 #include "CCT-Tree.hpp"
@@ -208,6 +212,8 @@ Tree::merge(const Tree* y, uint x_newMetricBegIdx, uint mrgFlag, uint oFlag)
   
   MergeEffectList* mrgEffects =
     x_root->mergeDeep(y_root, x_newMetricBegIdx, *m_mergeCtxt, oFlag);
+  m_mergeCtxt->clearChildIndexes();
+  clearNodeIdMap();
 
   DIAG_If(0 /*public diag level*/) {
     verifyUniqueCPIds();
@@ -222,6 +228,7 @@ Tree::pruneCCTByNodeId(const uint8_t* prunedNodes)
 {
   m_root->pruneChildrenByNodeId(prunedNodes);
   DIAG_Assert(!prunedNodes[m_root->id()], "Prof::CCT::Tree::pruneCCTByNodeId(): cannot delete root!");
+  clearNodeIdMap();
   
   //Prof::CCT::ANode::pruneByNodeId(m_root, prunedNodes);
   //DIAG_Assert(m_root, "Prof::CCT::Tree::pruneCCTByNodeId(): cannot delete root!");
@@ -235,6 +242,7 @@ Tree::makeDensePreorderIds()
   nextId = m_root->makeDensePreorderIds(nextId);
 
   m_maxDenseId = (nextId - 1);
+  clearNodeIdMap();
   return m_maxDenseId;
 }
 
@@ -243,14 +251,27 @@ ANode*
 Tree::findNode(uint nodeId) const
 {
   if (!m_nodeidMap) {
+    // a sorted vector instead of a std::map: one allocation for the
+    // whole tree, and with dense pre-order ids it is already sorted
     m_nodeidMap = new NodeIdToANodeMap;
     for (ANodeIterator it(m_root); it.Current(); ++it) {
       ANode* n = it.current();
-      m_nodeidMap->insert(std::make_pair(n->id(), n));
+      m_nodeidMap->push_back(std::make_pair(n->id(), n));
     }
+    std::sort(m_nodeidMap->begin(), m_nodeidMap->end());
   }
-  NodeIdToANodeMap::iterator it = m_nodeidMap->find(nodeId);
-  return (it != m_nodeidMap->end()) ? it->second : NULL;
+  NodeIdToANodeMap::const_iterator it =
+    std::lower_bound(m_nodeidMap->begin(), m_nodeidMap->end(),
+		     std::make_pair(nodeId, (ANode*)NULL));
+  return (it != m_nodeidMap->end() && it->first == nodeId) ? it->second : NULL;
+}
+
+
+void
+Tree::clearNodeIdMap() const
+{
+  delete m_nodeidMap;
+  m_nodeidMap = NULL;
 }
 
 
@@ -338,6 +359,8 @@ ANode::IntToANodeType(long i)
 
 uint ANode::s_nextUniqueId = 2;
 
+uint ANode::s_aggregationJobs = 1;
+
 
 //***************************************************************************
 // ANode, etc: constructors/destructors
@@ -464,6 +487,206 @@ ANode::aggregateMetricsIncl(uint mBegId, uint mEndId)
 }
 
 
+// ---------------------------------------------------------
+// Parallel aggregation
+//
+// With more than one thread, aggregateMetricsIncl/Excl() first split
+// the tree into subtrees of roughly AggrGrainSz nodes ('cuts'), each
+// aggregated as a task that treats the cuts below it as leaves.  A
+// cut's round is one more than the largest round of the cuts below
+// it, so the tasks of one round are disjoint and only read the
+// (final) values of cuts from earlier rounds.  Every node receives
+// its children's values in the same order as in the serial
+// traversal, so results do not depend on the number of threads.
+// ---------------------------------------------------------
+
+typedef std::unordered_set<const ANode*> ANodeSet;
+
+static const uint AggrGrainSz    = 4096; // nodes per task
+static const uint AggrMinGrainSz = 256;  // smallest task for a wide node
+
+
+// addMetrics: x[ival] += y[ival] for each interval in 'ivalset',
+// demanding metrics of size ival.end() (cf. Metric::IData::demandMetric())
+static inline void
+addMetrics(ANode* x, ANode* y, const VMAIntervalSet& ivalset)
+{
+  for (VMAIntervalSet::const_iterator it = ivalset.begin();
+       it != ivalset.end(); ++it) {
+    uint mBegId = (uint)it->beg(), mEndId = (uint)it->end();
+    if (mBegId >= mEndId) {
+      continue;
+    }
+    x->ensureMetricsSize(mEndId);
+    y->ensureMetricsSize(mEndId);
+
+    double* x_m = &x->metric(mBegId);
+    const double* y_m = &y->metric(mBegId);
+    for (uint i = 0; i < mEndId - mBegId; ++i) {
+      x_m[i] += y_m[i];
+    }
+  }
+}
+
+
+static inline bool
+isCut(const ANodeSet* cuts, const ANode* x)
+{
+  return (cuts && cuts->find(x) != cuts->end());
+}
+
+
+#ifdef ENABLE_OPENMP
+
+static bool
+canCutIncl(const ANode* GCC_ATTR_UNUSED x)
+{
+  return true;
+}
+
+
+// canCutExcl: exclusive values flow into the enclosing logical
+// procedure, so a task must begin at one
+static bool
+canCutExcl(const ANode* x)
+{
+  bool isInlineMacro = false;
+  return ANode::isLogicalProc(x, isInlineMacro);
+}
+
+
+// partitionForAggregation: computes the cuts of the tree at 'root'
+// (always a cut) by round.  A node with at least AggrGrainSz nodes
+// below the cuts beneath it becomes a cut (if 'canCut' allows); so
+// do its children with at least AggrMinGrainSz such nodes, so that a
+// wide node's subtrees can be aggregated in parallel.
+static void
+partitionForAggregation(ANode* root, bool (*canCut)(const ANode*),
+			std::vector<std::vector<ANode*> >& rounds,
+			ANodeSet& cuts)
+{
+  struct Child {
+    ANode* x;
+    uint size;  // nodes not yet assigned to a cut
+    int round;  // largest round of a cut below
+  };
+
+  struct Frame {
+    ANode* x;
+    NonUniformDegreeTreeNode* next; // next child to visit
+    uint size;
+    int round;
+    uint bigBeg; // x's children in 'bigChildren' begin here
+  };
+
+  rounds.clear();
+  cuts.clear();
+
+  // children with at least AggrMinGrainSz nodes of the frames on
+  // 'stack', contiguous per frame
+  std::vector<Child> bigChildren;
+
+  std::vector<Frame> stack;
+  Frame rf = { root, root->FirstChild(), 1, -1, 0 };
+  stack.push_back(rf);
+
+  while (!stack.empty()) {
+    Frame& f = stack.back();
+
+    if (f.next) {
+      NonUniformDegreeTreeNode* c = f.next;
+      f.next = (c->NextSibling() == f.x->FirstChild()) ? NULL : c->NextSibling();
+
+      Frame cf = { static_cast<ANode*>(c), c->FirstChild(), 1, -1,
+		   (uint)bigChildren.size() };
+      stack.push_back(cf);
+      continue;
+    }
+
+    // post-order visit of f.x
+    Child me = { f.x, f.size, f.round };
+    uint bigBeg = f.bigBeg;
+    stack.pop_back();
+
+    for (uint i = bigBeg; i < bigChildren.size(); ++i) {
+      me.size += bigChildren[i].size;
+    }
+
+    bool isWide = (me.size >= AggrGrainSz);
+    for (uint i = bigBeg; i < bigChildren.size(); ++i) {
+      Child& c = bigChildren[i];
+      if (isWide && canCut(c.x)) {
+	c.round++;
+	if (rounds.size() <= (uint)c.round) {
+	  rounds.resize(c.round + 1);
+	}
+	rounds[c.round].push_back(c.x);
+	cuts.insert(c.x);
+	me.size -= c.size;
+      }
+      me.round = std::max(me.round, c.round);
+    }
+    bigChildren.resize(bigBeg);
+
+    bool isRoot = stack.empty();
+    if (isRoot || (me.size >= AggrGrainSz && canCut(me.x))) {
+      me.round++;
+      if (rounds.size() <= (uint)me.round) {
+	rounds.resize(me.round + 1);
+      }
+      rounds[me.round].push_back(me.x);
+      cuts.insert(me.x);
+      me.size = 0;
+    }
+
+    if (!isRoot) {
+      Frame& p = stack.back();
+      if (me.size >= AggrMinGrainSz) {
+	bigChildren.push_back(me);
+      }
+      else {
+	p.size += me.size;
+	p.round = std::max(p.round, me.round);
+      }
+    }
+  }
+}
+
+
+#endif // ENABLE_OPENMP
+
+
+// aggregateMetricsIncl_task: adds the values of each node of the
+// subtree at 'root' into its parent in post-order (the root itself
+// excepted); nodes in 'cuts' other than 'root' are treated as leaves
+static void
+aggregateMetricsIncl_task(ANode* root, const VMAIntervalSet& ivalset,
+			  const ANodeSet* cuts)
+{
+  // N.B.: children are visited first to last, as by an ANodeIterator
+  // in IteratorStack::PostOrder
+  ANode* x = root;
+  while (x->firstChild() && (x == root || !isCut(cuts, x))) {
+    x = x->firstChild();
+  }
+
+  while (x != root) {
+    ANode* x_parent = x->parent();
+    addMetrics(x_parent, x, ivalset);
+
+    if (x != x_parent->lastChild()) {
+      x = static_cast<ANode*>(x->NextSibling());
+      while (x->firstChild() && !isCut(cuts, x)) {
+	x = x->firstChild();
+      }
+    }
+    else {
+      x = x_parent;
+    }
+  }
+}
+
+
 void
 ANode::aggregateMetricsIncl(const VMAIntervalSet& ivalset)
 {
@@ -471,25 +694,26 @@ ANode::aggregateMetricsIncl(const VMAIntervalSet& ivalset)
     return; // short circuit
   }
 
-  const ANode* root = this;
-  ANodeIterator it(root, NULL/*filter*/, false/*leavesOnly*/,
-		   IteratorStack::PostOrder);
-  for (ANode* n = NULL; (n = it.current()); ++it) {
-    if (n != root) {
-      ANode* n_parent = n->parent();
-      
-      for (VMAIntervalSet::const_iterator it1 = ivalset.begin();
-	   it1 != ivalset.end(); ++it1) {
-	const VMAInterval& ival = *it1;
-	uint mBegId = (uint)ival.beg(), mEndId = (uint)ival.end();
-
-	for (uint mId = mBegId; mId < mEndId; ++mId) {
-	  double mVal = n->demandMetric(mId, mEndId/*size*/);
-	  n_parent->demandMetric(mId, mEndId/*size*/) += mVal;
-	}
+#ifdef ENABLE_OPENMP
+  if (s_aggregationJobs > 1) {
+    std::vector<std::vector<ANode*> > rounds;
+    ANodeSet cuts;
+    partitionForAggregation(this, canCutIncl, rounds, cuts);
+
+    for (uint r = 0; r < rounds.size(); ++r) {
+      const std::vector<ANode*>& roots = rounds[r];
+      long numRoots = roots.size();
+#pragma omp parallel for schedule(dynamic, 1) num_threads(s_aggregationJobs) \
+  if (numRoots > 1)
+      for (long i = 0; i < numRoots; ++i) {
+	aggregateMetricsIncl_task(roots[i], ivalset, &cuts);
       }
     }
+    return;
   }
+#endif
+
+  aggregateMetricsIncl_task(this, ivalset, NULL);
 }
 
 
@@ -511,20 +735,36 @@ ANode::aggregateMetricsExcl(const VMAIntervalSet& ivalset)
     return; // short circuit
   }
 
+#ifdef ENABLE_OPENMP
+  if (s_aggregationJobs > 1) {
+    std::vector<std::vector<ANode*> > rounds;
+    ANodeSet cuts;
+    partitionForAggregation(this, canCutExcl, rounds, cuts);
+
+    // A task skips its root's post-order visit, which belongs to the
+    // task above it (with the right frame); the root of all has none.
+    for (uint r = 0; r < rounds.size(); ++r) {
+      const std::vector<ANode*>& roots = rounds[r];
+      long numRoots = roots.size();
+#pragma omp parallel for schedule(dynamic, 1) num_threads(s_aggregationJobs) \
+  if (numRoots > 1)
+      for (long i = 0; i < numRoots; ++i) {
+	ANode* x = roots[i];
+	x->aggregateMetricsExcl(NULL, ivalset, &cuts, true, (x == this));
+      }
+    }
+    return;
+  }
+#endif
+
   AProcNode* frame = NULL; // will be set during tree traversal
-  aggregateMetricsExcl(frame, ivalset);
+  aggregateMetricsExcl(frame, ivalset, NULL, true, true);
 }
 
 
-void
-ANode::aggregateMetricsExcl(AProcNode* frame, const VMAIntervalSet& ivalset)
+bool
+ANode::isLogicalProc(const ANode* n, bool& isInlineMacro)
 {
-  ANode* n = this;
-
-  // -------------------------------------------------------
-  // Pre-order visit
-  // -------------------------------------------------------
-  //
   // laks 2015.10.21: we don't want accumulate the exclusive cost of 
   // an inlined statement to the caller. Instead, we assume an inline
   // function (Proc) as the same as a normal procedure (ProcFrm).
@@ -533,8 +773,8 @@ ANode::aggregateMetricsExcl(AProcNode* frame, const VMAIntervalSet& ivalset)
   bool isFrame = (typeid(*n) == typeid(ProcFrm));
   bool isProc  = (typeid(*n) == typeid(Proc));
 
-  bool isInlineMacro = false;
   bool isInlineCall  = false;
+  isInlineMacro = false;
 
   NonUniformDegreeTreeNode *parent = n->Parent();
   if (isProc && parent != NULL) {
@@ -559,35 +799,44 @@ ANode::aggregateMetricsExcl(AProcNode* frame, const VMAIntervalSet& ivalset)
     isInlineMacro = !isInlineCall && myprocname.compare(GUARD_NAME) == 0;
   }
 
-  bool isLogicalProc   = isFrame || isInlineCall || isInlineMacro;
-  AProcNode * frameNxt = (isLogicalProc) ? static_cast<AProcNode*>(n) : frame;
+  return (isFrame || isInlineCall || isInlineMacro);
+}
+
+
+void
+ANode::aggregateMetricsExcl(AProcNode* frame, const VMAIntervalSet& ivalset,
+			    const ANodeSet* cuts, bool doDescend,
+			    bool doPostVisit)
+{
+  ANode* n = this;
+
+  // -------------------------------------------------------
+  // Pre-order visit
+  // -------------------------------------------------------
+  bool isInlineMacro = false;
+  bool isLogical = isLogicalProc(n, isInlineMacro);
+
+  AProcNode * frameNxt = (isLogical) ? static_cast<AProcNode*>(n) : frame;
 
   // -------------------------------------------------------
   // Tree traversal
   // -------------------------------------------------------
-  for (ANodeChildIterator it(n); it.Current(); ++it) {
-    ANode* x = it.current();
-    x->aggregateMetricsExcl(frameNxt, ivalset);
+  if (doDescend) {
+    for (ANodeChildIterator it(n); it.Current(); ++it) {
+      ANode* x = it.current();
+      x->aggregateMetricsExcl(frameNxt, ivalset, cuts, !isCut(cuts, x), true);
+    }
   }
 
   // -------------------------------------------------------
   // Post-order visit
   // -------------------------------------------------------
-  if (typeid(*n) == typeid(CCT::Stmt) || isInlineMacro) {
+  if (doPostVisit && (typeid(*n) == typeid(CCT::Stmt) || isInlineMacro)) {
     ANode* n_parent = n->parent();
 
-    for (VMAIntervalSet::const_iterator it = ivalset.begin();
-        it != ivalset.end(); ++it) {
-      const VMAInterval& ival = *it;
-      uint mBegId = (uint)ival.beg(), mEndId = (uint)ival.end();
-
-      for (uint mId = mBegId; mId < mEndId; ++mId) {
-        double mVal = n->demandMetric(mId, mEndId/*size*/);
-        n_parent->demandMetric(mId, mEndId/*size*/) += mVal;
-        if (frame && frame != n_parent) {
-          frame->demandMetric(mId, mEndId/*size*/) += mVal;
-        }
-      }
+    addMetrics(n_parent, n, ivalset);
+    if (frame && frame != n_parent) {
+      addMetrics(frame, n, ivalset);
     }
   }
 }
@@ -843,7 +1092,7 @@ ANode::mergeDeep(ANode* y, uint x_newMetricBegIdx, MergeContext& mrgCtxt,
 
     MergeEffectList* effctLst1 = NULL;
 
-    ADynNode* x_child_dyn = x->findDynChild(*y_child_dyn);
+    ADynNode* x_child_dyn = mrgCtxt.findDynChild(x, *y_child_dyn);
 
 #define MERGE_ACTION 0
 #define MERGE_ERROR 0
@@ -865,6 +1114,7 @@ ANode::mergeDeep(ANode* y, uint x_newMetricBegIdx, MergeContext& mrgCtxt,
 	effctLst1 = y_child->mergeDeep_fixInsert(x_newMetricBegIdx, mrgCtxt);
 
 	y_child->link(x);
+	mrgCtxt.noteDynChild(x, y_child_dyn);
       }
     }
     else {
@@ -66,8 +66,10 @@
 
 #include <string>
 #include <vector>
+#include <utility>
 #include <list>
 #include <set>
+#include <unordered_set>
 
 #include <typeinfo>
 
@@ -161,7 +163,10 @@ public:
 
   void
   root(ANode* x)
-  { m_root = x; }
+  {
+    m_root = x;
+    clearNodeIdMap();
+  }
 
   bool
   empty() const
@@ -199,6 +204,11 @@ public:
   ANode*
   findNode(uint nodeId) const;
 
+  // Tree operations that change the tree's shape or ids drop the map;
+  // after changing the tree through its ANodes, call clearNodeIdMap().
+  void
+  clearNodeIdMap() const;
+
   // -------------------------------------------------------
   // 
   // -------------------------------------------------------
@@ -238,9 +248,9 @@ public:
   doXMLEscape(uint oFlags);
 
 public:
-  typedef std::map<uint, ANode*> NodeIdToANodeMap;
+  // (id, node) pairs sorted by id
+  typedef std::vector<std::pair<uint, ANode*> > NodeIdToANodeMap;
 
-  
 private:
   // CCT and metadata for interpreting CCT (e.g., metrics)
   ANode* m_root;
@@ -517,14 +527,36 @@ public:
   aggregateMetricsExcl(uint mBegId)
   { aggregateMetricsExcl(mBegId, mBegId + 1); }
 
+  // aggregationJobs: the number of threads aggregateMetricsIncl() and
+  // aggregateMetricsExcl() use.  It is 1 (serial) unless a tool sets
+  // it, e.g., from its --jobs option; OMP_NUM_THREADS does not change it.
+  static uint
+  aggregationJobs()
+  { return s_aggregationJobs; }
+
+  static void
+  aggregationJobs(uint n)
+  { s_aggregationJobs = (n > 0) ? n : 1; }
+
+  // isLogicalProc: whether exclusive metrics of the statements below
+  // 'n' aggregate into 'n' (a procedure frame, inlined call or inlined
+  // macro) rather than into an enclosing frame
+  static bool
+  isLogicalProc(const ANode* n, bool& isInlineMacro);
+
 private:
   //
   // laks 2015.10.21: we don't want accumulate the exclusive cost of 
   // an inlined statement to the caller. Instead, we assume an inline
   // function (Proc) as the same as a normal procedure (ProcFrm).
   // And the lowest common ancestor for Proc and ProcFrm is AProcNode.
+  //
+  // Nodes in 'cuts' are aggregated separately and are not descended
+  // into (cf. aggregateMetricsExcl(const VMAIntervalSet&)).
   void
-  aggregateMetricsExcl(AProcNode* frame, const VMAIntervalSet& ivalset);
+  aggregateMetricsExcl(AProcNode* frame, const VMAIntervalSet& ivalset,
+		       const std::unordered_set<const ANode*>* cuts,
+		       bool doDescend, bool doPostVisit);
 
 public:
   // computeMetrics: compute this subtree's Metric::DerivedDesc metric
@@ -680,6 +712,7 @@ protected:
 
 private:
   static uint s_nextUniqueId;
+  static uint s_aggregationJobs;
   
 protected:
   ANodeTy m_type; // obsolete with typeid(), but hard to replace
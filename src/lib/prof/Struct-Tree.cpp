@@ -107,6 +107,31 @@ namespace Struct {
 
 RealPathMgr& s_realpathMgr = RealPathMgr::singleton();
 
+
+// realpathId: the name id of the real path of the name with id 'id'.
+// A RealPathMgr answer does not change once made, so it is
+// remembered by id and the many nodes that share a file name resolve
+// it once.
+static long
+realpathId(long id)
+{
+  static std::vector<long> s_realpathIds;
+
+  if (id >= (long) s_realpathIds.size()) {
+    s_realpathIds.resize(HPC::StringTable::global().size(), -1);
+  }
+  if (s_realpathIds[id] < 0) {
+    string nm_real = idToName(id);
+    s_realpathMgr.realpath(nm_real);
+    long realId = nameToId(nm_real);
+    if (realId >= (long) s_realpathIds.size()) {
+      s_realpathIds.resize(HPC::StringTable::global().size(), -1);
+    }
+    s_realpathIds[id] = realId;
+  }
+  return s_realpathIds[id];
+}
+
 //***************************************************************************
 // Tree
 //***************************************************************************
@@ -377,7 +402,7 @@ File::Ctor(const char* fname, ANode* parent)
   ANodeTy t = (parent) ? parent->type() : TyANY;
   DIAG_Assert((parent == NULL) || (t == TyRoot) || (t == TyGroup) || (t == TyLM), "");
 
-  m_name = (fname) ? fname : "";
+  m_nameId = nameToId(fname);
   m_procMap = new ProcMap();
 
   ancestorLM()->insertFileMap(this);
@@ -389,7 +414,7 @@ File::operator=(const File& x)
 {
   // shallow copy
   if (&x != this) {
-    m_name    = x.m_name;
+    m_nameId  = x.m_nameId;
     m_procMap = NULL;
   }
   return *this;
@@ -401,13 +426,12 @@ File::demand(LM* lm, const string& filenm)
 {
   const char* note = "(found)";
 
-  string nm_real = filenm;
-  s_realpathMgr.realpath(nm_real);
+  long realId = realpathId(nameToId(filenm));
 
-  File* file = lm->findFile(nm_real);
+  File* file = lm->findFileById(realId);
   if (!file) {
     note = "(created)";
-    file = new File(nm_real, lm);
+    file = new File(idToName(realId), lm);
   }
   DIAG_DevMsgIf(DBG_FILE, "Struct::File::demand: " << note << endl
 		<< "\tin : " << filenm << endl
@@ -423,8 +447,8 @@ Proc::Ctor(const char* n, ACodeNode* parent, const char* ln, bool hasSym)
   ANodeTy t = (parent) ? parent->type() : TyANY;
   DIAG_Assert((parent == NULL) || (t == TyGroup) || (t == TyFile), "");
 
-  m_name = (n) ? n : "";
-  m_linkname = (ln) ? ln : "";
+  m_nameId = nameToId(n);
+  m_linknameId = nameToId(ln);
   m_hasSym = hasSym;
   m_stmtMap = NULL;
   m_alienMap = NULL;
@@ -445,11 +469,11 @@ Proc::operator=(const Proc& x)
 {
   // shallow copy
   if (&x != this) {
-    m_name     = x.m_name;
-    m_linkname = x.m_linkname;
-    m_hasSym   = x.m_hasSym;
-    m_stmtMap  = NULL;
-    m_alienMap = NULL;
+    m_nameId     = x.m_nameId;
+    m_linknameId = x.m_linknameId;
+    m_hasSym     = x.m_hasSym;
+    m_stmtMap    = NULL;
+    m_alienMap   = NULL;
   }
   return *this;
 }
@@ -512,14 +536,15 @@ Proc::demandGuardAlien(std::string & filenm, SrcFile::ln line)
   if (m_alienMap == NULL) {
     m_alienMap = new AlienFileMap();
   }
-  auto it = m_alienMap->find(filenm);
+  long fileId = nameToId(filenm);
+  auto it = m_alienMap->find(fileId);
 
   if (it != m_alienMap->end()) {
     alien = it->second;
   }
   else {
     alien = new Alien(this, filenm, GUARD_NAME, GUARD_NAME, line, line);
-    (* m_alienMap)[filenm] = alien;
+    (* m_alienMap)[fileId] = alien;
   }
 
   return alien;
@@ -538,11 +563,10 @@ Alien::Ctor(ACodeNode* parent, const char* filenm, const char* nm,
   DIAG_Assert((parent == NULL) || (t == TyGroup) || (t == TyAlien)
 	      || (t == TyProc) || (t == TyLoop), "");
 
-  m_filenm = (filenm) ? filenm : "";
-  s_realpathMgr.realpath(m_filenm);
+  m_fileId = realpathId(nameToId(filenm));
 
-  m_name   = (nm) ? nm : "";
-  m_displaynm = (displaynm) ? displaynm : "";
+  m_nameId = nameToId(nm);
+  m_displayId = (displaynm == nm) ? m_nameId : nameToId(displaynm);
   freezeLine();
 
   m_stmtMap = NULL;
@@ -554,9 +578,9 @@ Alien::operator=(const Alien& x)
 {
   // shallow copy
   if (&x != this) {
-    m_filenm = x.m_filenm;
-    m_name   = x.m_name;
-    m_displaynm = x.m_displaynm;
+    m_fileId = x.m_fileId;
+    m_nameId = x.m_nameId;
+    m_displayId = x.m_displayId;
     m_stmtMap = NULL;
   }
   return *this;
@@ -976,8 +1000,7 @@ Root::insertGroupMap(Group* grp)
 void
 Loop::setFile(std::string filenm)
 {
-  m_filenm = filenm;
-  s_realpathMgr.realpath(m_filenm);
+  m_fileId = realpathId(nameToId(filenm));
 }
 
 
@@ -1005,11 +1028,10 @@ Root::insertLMMap(LM* lm)
 void
 LM::insertFileMap(File* f)
 {
-  string nm_real = f->name();
-  s_realpathMgr.realpath(nm_real);
-  DIAG_DevMsg(2, "LM: mapping file name '" << nm_real << "' to File* " << f);
+  long realId = realpathId(f->nameId());
+  DIAG_DevMsg(2, "LM: mapping file name '" << idToName(realId) << "' to File* " << f);
   std::pair<FileMap::iterator, bool> ret =
-    m_fileMap->insert(std::make_pair(nm_real, f));
+    m_fileMap->insert(std::make_pair(realId, f));
   DIAG_Assert(ret.second, "Duplicate instance: " << f->name() << "\n" << toStringXML());
 }
 
@@ -1019,7 +1041,7 @@ File::insertProcMap(Proc* p)
 {
   DIAG_DevMsg(2, "File (" << this << "): mapping proc name '" << p->name()
 	      << "' to Proc* " << p);
-  m_procMap->insert(make_pair(p->name(), p)); // multimap
+  m_procMap->insert(std::make_pair(p->nameId(), p)); // multimap
 }
 
 
@@ -1036,9 +1058,25 @@ Proc::insertStmtMap(Stmt* stmt)
 File*
 LM::findFile(const char* nm) const
 {
+  HPC::StringTable& strTab = HPC::StringTable::global();
+
+  // don't grow the string table with names that were never seen
+  long id = strTab.find(nm);
+  if (id >= 0) {
+    return findFileById(realpathId(id));
+  }
+
   string nm_real = nm;
   s_realpathMgr.realpath(nm_real);
-  FileMap::iterator it = m_fileMap->find(nm_real);
+  long realId = strTab.find(nm_real);
+  return (realId >= 0) ? findFileById(realId) : NULL;
+}
+
+
+File*
+LM::findFileById(long realId) const
+{
+  FileMap::iterator it = m_fileMap->find(realId);
   File* x = (it != m_fileMap->end()) ? it->second : NULL;
   return x;
 }
@@ -1134,16 +1172,38 @@ LM::verifyStmtMap() const
 
 Proc*
 File::findProc(const char* name, const char* linkname) const
+{
+  HPC::StringTable& strTab = HPC::StringTable::global();
+
+  // a name that was never interned names no Proc
+  long nameId = strTab.find(name);
+  if (nameId < 0) {
+    return NULL;
+  }
+
+  long linknameId = -1;
+  if (linkname && linkname[0] != '\0') {
+    linknameId = strTab.find(linkname);
+    if (linknameId < 0) {
+      return NULL;
+    }
+  }
+
+  return findProcById(nameId, linknameId);
+}
+
+
+Proc*
+File::findProcById(long nameId, long linknameId) const
 {
   Proc* found = NULL;
 
-  ProcMap::const_iterator it = m_procMap->find(name);
+  ProcMap::const_iterator it = m_procMap->find(nameId);
   if (it != m_procMap->end()) {
-    if (linkname && linkname[0] != '\0') {
-      for ( ; (it != m_procMap->end() && strcmp(it->first.c_str(), name) == 0);
-	    ++it) {
+    if (linknameId >= 0) {
+      for ( ; (it != m_procMap->end() && it->first == nameId); ++it) {
 	Proc* p = it->second;
-	if (strcmp(p->linkName().c_str(), linkname) == 0) {
+	if (p->linkNameId() == linknameId) {
 	  return p; // found = p
 	}
       }
@@ -1452,7 +1512,7 @@ Proc::codeName() const
 string
 Alien::codeName() const
 {
-  string nm = "<" + m_filenm + ">[" + m_name + "]:";
+  string nm = "<" + fileName() + ">[" + name() + "]:";
   nm += StrUtil::toStr(m_begLn);
   return nm;
 }
@@ -1573,7 +1633,7 @@ LM::toXML(uint oFlags) const
 string
 File::toXML(uint oFlags) const
 {
-  string self = ANode::toXML(oFlags) + " n" + MakeAttrStr(m_name);
+  string self = ANode::toXML(oFlags) + " n" + MakeAttrStr(name());
   return self;
 }
 
@@ -1581,9 +1641,10 @@ File::toXML(uint oFlags) const
 string
 Proc::toXML(uint oFlags) const
 {
-  string self = ANode::toXML(oFlags) + " n" + MakeAttrStr(m_name);
-  if (!m_linkname.empty() && m_name != m_linkname) { // print if different
-    self = self + " ln" + MakeAttrStr(m_linkname);
+  string self = ANode::toXML(oFlags) + " n" + MakeAttrStr(name());
+  if (m_linknameId != HPC::StringTable::EmptyIndex
+      && m_nameId != m_linknameId) { // print if different
+    self = self + " ln" + MakeAttrStr(linkName());
   }
   self = self + " " + XMLLineRange(oFlags) + " " + XMLVMAIntervals(oFlags);
   return self;
@@ -1594,7 +1655,7 @@ string
 Alien::toXML(uint oFlags) const
 {
   string self = ANode::toXML(oFlags)
-    + " f" + MakeAttrStr(m_filenm) + " n" + MakeAttrStr(m_displaynm);
+    + " f" + MakeAttrStr(fileName()) + " n" + MakeAttrStr(displayName());
   self = self + " " + XMLLineRange(oFlags) + " " + XMLVMAIntervals(oFlags);
 
   // add information on the function definition
@@ -1607,11 +1668,11 @@ Alien::toXML(uint oFlags) const
   LM   *lm   = ancestorLM();
 
   // 1b: check if the alien has the file pointer to its definition
-  File *file = lm->findFile(m_filenm);
+  File *file = lm->findFileById(realpathId(m_fileId));
   if (file) {
     
     // 2: check if there's the same procedure name in the file
-    Proc *proc = file->findProc(m_displaynm);
+    Proc *proc = file->findProcById(m_displayId);
     
     if (proc) {
 #if 0
@@ -1632,7 +1693,7 @@ Alien::toXML(uint oFlags) const
 string
 Loop::toXML(uint oFlags) const
 {
-  string self = ACodeNode::toXML(oFlags) + " f" + MakeAttrStr(m_filenm);
+  string self = ACodeNode::toXML(oFlags) + " f" + MakeAttrStr(fileName());
   return self;
 }
 
@@ -2023,7 +2084,7 @@ LM::dumpme(ostream& os, uint oFlags, const char* prefix) const
 ostream&
 File::dumpme(ostream& os, uint oFlags, const char* prefix) const
 {
-  ACodeNode::dumpme(os, oFlags, prefix) << " n=" <<  m_name;
+  ACodeNode::dumpme(os, oFlags, prefix) << " n=" <<  name();
   return os;
 }
 
@@ -2031,7 +2092,7 @@ File::dumpme(ostream& os, uint oFlags, const char* prefix) const
 ostream&
 Proc::dumpme(ostream& os, uint oFlags, const char* prefix) const
 {
-  ACodeNode::dumpme(os, oFlags, prefix) << " n=" << m_name;
+  ACodeNode::dumpme(os, oFlags, prefix) << " n=" << name();
   return os;
 }
 
@@ -2040,7 +2101,7 @@ ostream&
 Alien::dumpme(ostream& os, uint oFlags, const char* prefix) const
 {
   ACodeNode::dumpme(os, oFlags, prefix);
-  os << " f=" << m_filenm << " n=" << m_name;
+  os << " f=" << fileName() << " n=" << name();
   return os;
 }
 
@@ -87,6 +87,7 @@
 #include <lib/support/RealPathMgr.hpp>
 #include <lib/support/SrcFile.hpp>
 using SrcFile::ln_NULL;
+#include <lib/support/StringTable.hpp>
 #include <lib/support/Unique.hpp>
 
 //*************************** Forward Declarations **************************
@@ -100,6 +101,21 @@ namespace Struct {
   typedef std::list<ANode*> ANodeList;
   typedef std::set<ANode*> ANodeSet;
 
+  // File, procedure and alien names are interned in the global
+  // string table; nodes hold the ids and the name maps are keyed by
+  // them.  Templated C++ code has many nodes with the same long name.
+  inline long
+  nameToId(const std::string& x)
+  { return HPC::StringTable::global().str2index(x); }
+
+  inline long
+  nameToId(const char* x)
+  { return (x) ? nameToId(std::string(x)) : HPC::StringTable::EmptyIndex; }
+
+  inline const std::string&
+  idToName(long id)
+  { return HPC::StringTable::global().index2str(id); }
+
 } // namespace Struct
 } // namespace Prof
 
@@ -118,12 +134,13 @@ class LMMap : public std::map<std::string, LM*> { };
 
 // ProcMap: This is is a multimap because procedure names are
 // sometimes "generic", i.e. not qualified by types in the case of
-// templates, resulting in duplicate names
+// templates, resulting in duplicate names.  Keyed by name id.
 class Proc;
-class ProcMap : public std::multimap<std::string, Proc*> { };
+class ProcMap : public std::multimap<long, Proc*> { };
 
+// FileMap: keyed by the name id of the file's real path
 class File;
-class FileMap : public std::map<std::string, File*> { };
+class FileMap : public std::map<long, File*> { };
 
 class Stmt;
 class StmtMap : public std::map<SrcFile::ln, Stmt*> { };
@@ -625,7 +642,7 @@ protected:
     if (!VMAInterval::empty(begVMA, endVMA)) {
       m_vmaSet.insert(begVMA, endVMA);
     }
-    m_scope_filenm = "";
+    m_scope_fileId = HPC::StringTable::EmptyIndex;
     m_scope_lineno = 0;
   }
 
@@ -841,16 +858,16 @@ protected:
   // InlineNode sequence inside the location manager.
   // --------------------------------------------------------
 private:
-  std::string m_scope_filenm;
+  long m_scope_fileId;
   SrcFile::ln m_scope_lineno;
   bool m_lineno_frozen;
   
 public:
   void setScopeLocation(std::string &file, SrcFile::ln line) {
-    m_scope_filenm = file;
+    m_scope_fileId = nameToId(file);
     m_scope_lineno = line;
   }
-  std::string & getScopeFileName() { return m_scope_filenm; }
+  const std::string & getScopeFileName() { return idToName(m_scope_fileId); }
   SrcFile::ln getScopeLineNum() { return m_scope_lineno; }
 };
 
@@ -1125,6 +1142,10 @@ public:
   findFile(const std::string& nm) const
   { return findFile(nm.c_str()); }
 
+  // findFileById: find by the name id of the file's real path
+  File*
+  findFileById(long realId) const;
+
 
   // --------------------------------------------------------
   // search by VMA
@@ -1333,7 +1354,11 @@ public:
 
   virtual const std::string&
   name() const
-  { return m_name; }
+  { return idToName(m_nameId); }
+
+  long
+  nameId() const
+  { return m_nameId; }
 
   virtual std::string
   codeName() const;
@@ -1341,15 +1366,15 @@ public:
 
   void
   name(const char* fname)
-  { m_name = fname; }
+  { m_nameId = nameToId(fname); }
 
   void
   name(const std::string& fname)
-  { m_name = fname; }
+  { m_nameId = nameToId(fname); }
 
   std::string
   baseName() const
-  { return FileUtil::basename(m_name); }
+  { return FileUtil::basename(name()); }
 
 
   // --------------------------------------------------------
@@ -1365,6 +1390,10 @@ public:
   findProc(const std::string& name, const std::string& linkname = "") const
   { return findProc(name.c_str(), linkname.c_str()); }
 
+  // As above, by name ids; a negative 'linknameId' matches any.
+  Proc*
+  findProcById(long nameId, long linknameId = -1) const;
+
 
   // --------------------------------------------------------
   // Output
@@ -1392,7 +1421,7 @@ private:
   friend class Proc;
 
 private:
-  std::string m_name; // the file name including the path
+  long        m_nameId; // the file name including the path
   ProcMap*    m_procMap;
 
 #if 0
@@ -1419,9 +1448,9 @@ protected:
 
 public:
 
-  // map of file name to alien node, for stmts with a single, guard
-  // alien from struct simple
-  typedef std::map <std::string, Alien *> AlienFileMap;
+  // map of file name id to alien node, for stmts with a single,
+  // guard alien from struct simple
+  typedef std::map <long, Alien *> AlienFileMap;
 
   // --------------------------------------------------------
   // Create/Destroy
@@ -1476,7 +1505,11 @@ public:
 
   virtual const std::string&
   name() const
-  { return m_name; }
+  { return idToName(m_nameId); }
+
+  long
+  nameId() const
+  { return m_nameId; }
 
   virtual std::string
   codeName() const;
@@ -1484,15 +1517,19 @@ public:
 
   void
   name(const char* x)
-  { m_name = (x) ? x : ""; }
+  { m_nameId = nameToId(x); }
 
   void
   name(const std::string& x)
-  { m_name = x; }
+  { m_nameId = nameToId(x); }
 
   const std::string&
   linkName() const
-  { return m_linkname; }
+  { return idToName(m_linknameId); }
+
+  long
+  linkNameId() const
+  { return m_linknameId; }
 
   bool
   hasSymbolic() const
@@ -1547,8 +1584,8 @@ private:
   friend class Stmt;
 
 private:
-  std::string m_name;
-  std::string m_linkname;
+  long m_nameId;
+  long m_linknameId;
   bool m_hasSym;
 
   // for struct simple and guard aliens only.  all access should go
@@ -1616,23 +1653,27 @@ public:
 
   const std::string&
   fileName() const
-  { return m_filenm; }
+  { return idToName(m_fileId); }
+
+  long
+  fileId() const
+  { return m_fileId; }
 
   void
   fileName(const std::string& fnm)
-  { m_filenm = fnm; }
+  { m_fileId = nameToId(fnm); }
 
   virtual const std::string&
   name() const
-  { return m_name; }
+  { return idToName(m_nameId); }
 
   void
   name(const char* n)
-  { m_name = n; }
+  { m_nameId = nameToId(n); }
 
   void
   name(const std::string& n)
-  { m_name = n; }
+  { m_nameId = nameToId(n); }
 
   void
   proc(Prof::Struct::Proc *proc)
@@ -1640,7 +1681,11 @@ public:
 
   const std::string&
   displayName() const
-  { return m_displaynm; }
+  { return idToName(m_displayId); }
+
+  long
+  displayNameId() const
+  { return m_displayId; }
 
   virtual std::string
   codeName() const;
@@ -1670,9 +1715,9 @@ private:
   friend class Stmt;
 
 private:
-  std::string m_filenm;
-  std::string m_name;
-  std::string m_displaynm;
+  long m_fileId;
+  long m_nameId;
+  long m_displayId;
 
   // for struct simple only
   StmtMap *   m_stmtMap;
@@ -1737,14 +1782,18 @@ public:
 
   const std::string&
   fileName() const
-  { return m_filenm; }
+  { return idToName(m_fileId); }
+
+  long
+  fileId() const
+  { return m_fileId; }
 
   void
   fileName(const std::string& fnm)
-  { m_filenm = fnm; }
+  { m_fileId = nameToId(fnm); }
 
 private:
-  std::string m_filenm;
+  long m_fileId;
 };
 
 
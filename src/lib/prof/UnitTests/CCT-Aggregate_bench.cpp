@@ -0,0 +1,196 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL$
+// $Id$
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   cct-aggregate-bench [nodes]: times ANode::aggregateMetricsExcl()
+//   and aggregateMetricsIncl() on synthetic deep and wide trees with
+//   1, 2, 4 and 8 aggregation jobs (cf. ANode::aggregationJobs()).
+//   Every job count must reproduce the serial values bit for bit.
+//
+//   Built by 'make check' in src/tool/hpcprof.  Deep trees recurse in
+//   aggregateMetricsExcl(), so run it with a large stack.
+//
+//***************************************************************************
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <include/hpctoolkit-config.h>
+
+#include <lib/prof/CCT-Tree.hpp>
+
+#include <lib/prof-lean/usec_time.h>
+
+#include <lib/support/diagnostics.h>
+
+using namespace std;
+using namespace Prof;
+
+#define BENCH_NODES    2000000
+#define BENCH_METRICS  8
+#define BENCH_MAX_JOBS 8
+
+
+// buildTree: a tree of 'n' nodes with a ProcFrm for every few calls
+// and statements.  A deep tree mostly extends its newest node; a wide
+// tree hangs every node below one of the first few.
+static CCT::ANode*
+buildTree(uint n, bool isDeep, uint seed)
+{
+  srand(seed);
+
+  vector<CCT::ANode*> nodes;
+  nodes.reserve(n);
+  nodes.push_back(new CCT::Root("bench"));
+
+  for (uint i = 1; i < n; ++i) {
+    CCT::ANode* parent;
+    if (isDeep) {
+      uint back = (rand() % 4 == 0) ? rand() % min<size_t>(nodes.size(), 16) : 0;
+      parent = nodes[nodes.size() - 1 - back];
+    }
+    else {
+      parent = nodes[rand() % min<size_t>(nodes.size(), 64)];
+    }
+
+    CCT::ANode* x;
+    switch (rand() % 4) {
+      case 0:  x = new CCT::ProcFrm(parent); break;
+      case 1:  x = new CCT::Call(parent, 0); break;
+      default: x = new CCT::Stmt(parent, 0); break;
+    }
+    for (uint mId = 0; mId < BENCH_METRICS; ++mId) {
+      x->demandMetric(mId, BENCH_METRICS) = (rand() % 1000) / 7.0;
+    }
+    nodes.push_back(x);
+  }
+
+  return nodes[0];
+}
+
+
+static void
+aggregate(CCT::ANode* root)
+{
+  VMAIntervalSet exclSet, inclSet;
+  exclSet.insert(0, BENCH_METRICS / 2);
+  inclSet.insert(BENCH_METRICS / 2, BENCH_METRICS);
+
+  root->aggregateMetricsExcl(exclSet);
+  root->aggregateMetricsIncl(inclSet);
+}
+
+
+static bool
+isIdentical(CCT::ANode* x, CCT::ANode* y)
+{
+  CCT::ANodeIterator it_x(x), it_y(y);
+  for ( ; it_x.current() && it_y.current(); ++it_x, ++it_y) {
+    for (uint mId = 0; mId < BENCH_METRICS; ++mId) {
+      double x_m = it_x.current()->demandMetric(mId, BENCH_METRICS);
+      double y_m = it_y.current()->demandMetric(mId, BENCH_METRICS);
+      if (memcmp(&x_m, &y_m, sizeof(double)) != 0) {
+	return false;
+      }
+    }
+  }
+  return (!it_x.current() && !it_y.current());
+}
+
+
+static void
+benchTree(const char* name, bool isDeep, uint numNodes)
+{
+  cout << name << " tree, " << numNodes << " nodes" << endl;
+
+  CCT::ANode::aggregationJobs(1);
+  CCT::ANode* ref = buildTree(numNodes, isDeep, 1);
+  unsigned long t0 = usec_time();
+  aggregate(ref);
+  double serial = (usec_time() - t0) / 1e6;
+  cout << "  jobs: 1  time: " << serial << " s" << endl;
+
+#ifdef ENABLE_OPENMP
+  for (uint jobs = 2; jobs <= BENCH_MAX_JOBS; jobs *= 2) {
+    CCT::ANode::aggregationJobs(jobs);
+
+    CCT::ANode* root = buildTree(numNodes, isDeep, 1);
+    t0 = usec_time();
+    aggregate(root);
+    double elapsed = (usec_time() - t0) / 1e6;
+    cout << "  jobs: " << jobs << "  time: " << elapsed
+	 << " s  speedup: " << serial / elapsed << endl;
+
+    if (!isIdentical(ref, root)) {
+      DIAG_Die(name << " tree: " << jobs << " jobs changed the metric values");
+    }
+    delete root;
+  }
+  CCT::ANode::aggregationJobs(1);
+#endif
+
+  delete ref;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  uint numNodes = (argc > 1) ? (uint)atol(argv[1]) : BENCH_NODES;
+
+  benchTree("deep", true, numNodes);
+  benchTree("wide", false, numNodes);
+
+  cout << "Metric values were identical for every job count" << endl;
+  return 0;
+}
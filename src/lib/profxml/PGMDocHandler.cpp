@@ -369,7 +369,7 @@ PGMDocHandler::startElement(const XMLCh* const GCC_ATTR_UNUSED uri,
     DIAG_DevMsgIf(DBG, "PGMDocHandler: " << m_curProc->toStringMe());
 
     curStrct = m_curProc;
-    PGMDocHandler::idToProcMap[id] = (Prof::Struct::Proc*) m_curProc;
+    PGMDocHandler::idToProcMap[atol(id.c_str())] = m_curProc;
   }
 
   // Alien
@@ -379,15 +379,17 @@ PGMDocHandler::startElement(const XMLCh* const GCC_ATTR_UNUSED uri,
 
     string nm  = getAttr(attributes, attrName);
     string ln  = getAttr(attributes, attrLnName);
-    string fnm = getAttr(attributes, attrFile);
-    fnm = m_args.realpath(fnm);
+    const string& fnm = realpathFile(getAttr(attributes, attrFile));
 
     SrcFile::ln begLn, endLn;
     getLineAttr(begLn, endLn, attributes);
 
     Struct::ACodeNode* parent = dynamic_cast<Struct::ACodeNode*>(getCurrentScope());
     Struct::Alien* alien = new Struct::Alien(parent, fnm, nm, nm, begLn, endLn);
-    alien->proc( idToProcMap[ln] );
+
+    std::map<long, Struct::Proc*>::iterator it =
+      idToProcMap.find(atol(ln.c_str()));
+    alien->proc((it != idToProcMap.end()) ? it->second : NULL);
 
     string node_id = getAttr(attributes, attrId);
     alien->m_origId = atoi(node_id.c_str());
@@ -408,8 +410,7 @@ PGMDocHandler::startElement(const XMLCh* const GCC_ATTR_UNUSED uri,
     SrcFile::ln begLn, endLn;
     getLineAttr(begLn, endLn, attributes);
 
-    string fnm = getAttr(attributes, attrFile);
-    fnm = m_args.realpath(fnm);
+    string fnm = realpathFile(getAttr(attributes, attrFile));
 
     // by now the file and function names should have been found
     Struct::ACodeNode* parent = dynamic_cast<Struct::ACodeNode*>(getCurrentScope());
@@ -681,6 +682,22 @@ PGMDocHandler::warning(const SAXParseException& e)
 //
 // ---------------------------------------------------------------------------
 
+// Aliens and loops repeat a few file names many times; resolve each
+// name once and keep the answer by name id.
+const string&
+PGMDocHandler::realpathFile(const string& fnm)
+{
+  long id = Struct::nameToId(fnm);
+
+  std::map<long, long>::iterator it = m_realpathIds.find(id);
+  if (it == m_realpathIds.end()) {
+    long realId = Struct::nameToId(m_args.realpath(fnm));
+    it = m_realpathIds.insert(std::make_pair(id, realId)).first;
+  }
+  return Struct::idToName(it->second);
+}
+
+
 Struct::File*
 PGMDocHandler::findCurrentFile()
 {
@@ -84,7 +84,11 @@ public:
   static const char* ToString(Doc_t docty);
 
 private:
-    std::map<std::string, Prof::Struct::Proc*> idToProcMap;
+    // Proc for each structure-file id, for the 'ln' of aliens
+    std::map<long, Prof::Struct::Proc*> idToProcMap;
+
+    // file name id to the name id of its real path
+    std::map<long, long> m_realpathIds;
 
 public:
 
@@ -217,6 +221,10 @@ private:
 
   void
   processGroupDocEndTag();
+
+  // m_args.realpath(), once per distinct file name
+  const std::string&
+  realpathFile(const std::string& fnm);
   
 private:
   Doc_t m_docty;
@@ -60,6 +60,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/syscall.h>
 
 #include <fnmatch.h>
 
@@ -215,14 +216,32 @@ countChar(const char* path, char c)
 //
 //***************************************************************************
 
+// cpy: appends the rest of 'srcFd' to 'dstFd'.  Where available,
+// copy_file_range() lets the kernel (or a network file system's
+// server) copy the data without passing it through user space.
 static void
 cpy(int srcFd, int dstFd)
 {
-  static const int bufSz = 4096;
+#if defined(SYS_copy_file_range)
+  ssize_t nCopied;
+  while ((nCopied = syscall(SYS_copy_file_range, srcFd, NULL, dstFd, NULL,
+			    (size_t)(1 << 30), 0)) > 0) { }
+  if (nCopied == 0) {
+    return;
+  }
+  // otherwise (e.g., ENOSYS, EXDEV, EINVAL), copy what is left below
+#endif
+
+  static const int bufSz = 64 * 1024;
   char buf[bufSz];
   ssize_t nRead;
   while ((nRead = read(srcFd, buf, bufSz)) > 0) {
-    write(dstFd, buf, nRead);
+    for (ssize_t nWritten = 0, ret; nWritten < nRead; nWritten += ret) {
+      ret = write(dstFd, buf + nWritten, nRead - nWritten);
+      if (ret < 0) {
+	return;
+      }
+    }
   }
 }
 
@@ -59,12 +59,20 @@
 
 //************************* System Include Files ****************************
 
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
 #include <string>
 using std::string;
 
+#include <cstdio>
 #include <cstring>
+#include <ctime>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <unistd.h>
 
 //*************************** User Include Files ****************************
 
@@ -98,6 +106,270 @@ bool try_slow_lookup_for_relative_paths(const char *path)
   return contains_relative;
 }
 
+//***************************************************************************
+// DirIndex: the persistent index of directory contents (cf.
+// PathFindMgr::useIndex())
+//***************************************************************************
+
+// Index file format (text, one item per line):
+//   hpctoolkit-search-index 1
+//   D <mtime-sec> <mtime-nsec> <directory path>
+//   f <file name>            (regular file '<directory path>/<name>')
+//   d <subdirectory name>    (subdirectory '<directory path>/<name>')
+//   l <real path>            (symlinked subdirectory)
+// where the 'f', 'd' and 'l' lines follow their 'D' line.
+
+static const char* DirIndex_magic = "hpctoolkit-search-index 1";
+
+// Directories modified this recently may change again within the
+// same time stamp; do not save them.
+static const time_t DirIndex_racySec = 2;
+
+class DirIndex
+{
+public:
+  DirIndex()
+  { }
+
+  bool
+  isEnabled() const
+  { return !m_fnm.empty(); }
+
+  void
+  load(const string& fnm);
+
+  void
+  save();
+
+  // find: if 'path' is indexed and unchanged, copies its contents and
+  // returns true.  Otherwise returns false and, if stat() succeeds,
+  // sets 'mtime' and 'hasMtime' for a following insert().
+  bool
+  find(const string& path, PathFindMgr::DirContents& contents,
+       struct timespec& mtime, bool& hasMtime);
+
+  void
+  insert(const string& path, const struct timespec& mtime,
+	 const PathFindMgr::DirContents& contents);
+
+private:
+  struct Entry {
+    Entry()
+      : isVisited(false)
+    { mtime.tv_sec = 0; mtime.tv_nsec = 0; }
+
+    struct timespec mtime;
+    PathFindMgr::DirContents contents;
+    bool isVisited; // validated or read in this run
+  };
+
+  typedef std::map<string, Entry> EntryMap;
+
+  bool
+  hasVisitedAncestor(const string& path) const;
+
+  std::mutex m_lock;
+  string m_fnm;
+  EntryMap m_entries;
+};
+
+
+void
+DirIndex::load(const string& fnm)
+{
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  m_fnm = fnm;
+  m_entries.clear();
+
+  std::ifstream is(fnm.c_str());
+  if (!is) {
+    return; // no index yet
+  }
+
+  string line;
+  if (!std::getline(is, line) || line != DirIndex_magic) {
+    DIAG_WMsg(1, "Ignoring unrecognized search index '" << fnm << "'");
+    return;
+  }
+
+  Entry* entry = NULL;
+  string path;
+  while (std::getline(is, line)) {
+    if (line.size() < 2 || line[1] != ' ') {
+      break; // malformed
+    }
+    string arg = line.substr(2);
+
+    if (line[0] == 'D') {
+      std::istringstream ls(arg);
+      long sec = 0, nsec = 0;
+      ls >> sec >> nsec;
+      ls.get(); // ' '
+      std::getline(ls, path);
+      if (!ls || path.empty()) {
+	break; // malformed
+      }
+      entry = &m_entries[path];
+      entry->mtime.tv_sec = sec;
+      entry->mtime.tv_nsec = nsec;
+    }
+    else if (!entry) {
+      break; // malformed
+    }
+    else if (line[0] == 'f') {
+      entry->contents.files.push_back(path + "/" + arg);
+    }
+    else if (line[0] == 'd') {
+      entry->contents.dirs.push_back(std::make_pair(path + "/" + arg, false));
+    }
+    else if (line[0] == 'l') {
+      entry->contents.dirs.push_back(std::make_pair(arg, true));
+    }
+    else {
+      break; // malformed
+    }
+  }
+
+  if (!is.eof()) {
+    DIAG_WMsg(1, "Ignoring the rest of malformed search index '" << fnm << "'");
+    if (entry) {
+      m_entries.erase(path); // may be incomplete
+    }
+  }
+}
+
+
+void
+DirIndex::save()
+{
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  if (m_fnm.empty()) {
+    return;
+  }
+
+  // write a temporary file and rename it, so that concurrent runs
+  // (e.g., hpcprof-mpi ranks) never see a partial index
+  std::ostringstream tmpFnm;
+  tmpFnm << m_fnm << ".tmp." << getpid();
+
+  std::ofstream os(tmpFnm.str().c_str());
+  os << DirIndex_magic << "\n";
+
+  time_t racyTime = time(NULL) - DirIndex_racySec;
+
+  for (EntryMap::const_iterator it = m_entries.begin();
+       it != m_entries.end(); ++it) {
+    const string& path = it->first;
+    const Entry& entry = it->second;
+
+    if (entry.mtime.tv_sec >= racyTime
+	|| (!entry.isVisited && hasVisitedAncestor(path))
+	|| path.find('\n') != string::npos) {
+      continue;
+    }
+
+    const PathFindMgr::DirContents& contents = entry.contents;
+    bool isSaveable = true;
+    std::ostringstream es;
+    es << "D " << entry.mtime.tv_sec << " " << entry.mtime.tv_nsec
+       << " " << path << "\n";
+
+    for (uint i = 0; i < contents.files.size() && isSaveable; ++i) {
+      const string& x = contents.files[i];
+      string nm = x.substr(path.length() + 1);
+      isSaveable = (nm.find('\n') == string::npos);
+      es << "f " << nm << "\n";
+    }
+    for (uint i = 0; i < contents.dirs.size() && isSaveable; ++i) {
+      const string& x = contents.dirs[i].first;
+      isSaveable = (x.find('\n') == string::npos);
+      if (contents.dirs[i].second) {
+	es << "l " << x << "\n";
+      }
+      else {
+	es << "d " << x.substr(path.length() + 1) << "\n";
+      }
+    }
+
+    if (isSaveable) {
+      os << es.str();
+    }
+  }
+
+  os.close();
+  if (!os || rename(tmpFnm.str().c_str(), m_fnm.c_str()) != 0) {
+    DIAG_WMsg(1, "Unable to write search index '" << m_fnm << "'");
+    unlink(tmpFnm.str().c_str());
+  }
+}
+
+
+bool
+DirIndex::find(const string& path, PathFindMgr::DirContents& contents,
+	       struct timespec& mtime, bool& hasMtime)
+{
+  hasMtime = false;
+
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    EntryMap::iterator it = m_entries.find(path);
+    if (it != m_entries.end() && it->second.isVisited) {
+      contents = it->second.contents;
+      return true;
+    }
+  }
+
+  struct stat statbuf;
+  if (stat(path.c_str(), &statbuf) != 0 || !S_ISDIR(statbuf.st_mode)) {
+    return false;
+  }
+  mtime = statbuf.st_mtim;
+  hasMtime = true;
+
+  std::lock_guard<std::mutex> guard(m_lock);
+  EntryMap::iterator it = m_entries.find(path);
+  if (it != m_entries.end()
+      && it->second.mtime.tv_sec == mtime.tv_sec
+      && it->second.mtime.tv_nsec == mtime.tv_nsec) {
+    it->second.isVisited = true;
+    contents = it->second.contents;
+    return true;
+  }
+  return false;
+}
+
+
+void
+DirIndex::insert(const string& path, const struct timespec& mtime,
+		 const PathFindMgr::DirContents& contents)
+{
+  std::lock_guard<std::mutex> guard(m_lock);
+  Entry& entry = m_entries[path];
+  entry.mtime = mtime;
+  entry.contents = contents;
+  entry.isVisited = true;
+}
+
+
+bool
+DirIndex::hasVisitedAncestor(const string& path) const
+{
+  for (size_t pos = path.rfind('/'); pos != string::npos && pos > 0;
+       pos = path.rfind('/', pos - 1)) {
+    EntryMap::const_iterator it = m_entries.find(path.substr(0, pos));
+    if (it != m_entries.end() && it->second.isVisited) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+static DirIndex s_dirIndex;
+
+
 //***************************************************************************
 // PathFindMgr
 //***************************************************************************
@@ -126,26 +398,25 @@ PathFindMgr::singleton()
 
 const char*
 PathFindMgr::pathfind(const char* pathList, const char* name, const char* mode)
+{
+  // FIXME: static buffer (per object) for pathfind answer
+  if (pathfind(pathList, name, mode, m_pathfind_ans)) {
+    return m_pathfind_ans.c_str();
+  }
+  else {
+    return NULL; // failure
+  }
+}
+
+
+bool
+PathFindMgr::pathfind(const char* pathList, const char* name, const char* mode,
+		      std::string& answer)
 {
   // -------------------------------------------------------
   // 0. Cache files found using 'pathList'
   // -------------------------------------------------------
-  if (!m_isPopulated) {
-    m_isPopulated = true;
-    std::vector<std::string> pathVec; // will contain all -I paths
-    StrUtil::tokenize_str(std::string(pathList), ":", pathVec);
-    
-    std::set<std::string> seenPaths;
-    std::vector<std::string> recursionStack;
-    while (!m_isFull && !pathVec.empty()) {
-      if (pathVec.back() != ".") { // do not cache within CWD
-	scan(pathVec.back(), seenPaths, &recursionStack);
-	seenPaths.clear();
-	recursionStack.clear();
-      }
-      pathVec.pop_back();
-    }
-  }
+  populate(pathList);
 
   // -------------------------------------------------------
   // 1. Resolve 'name' either by pathfind cache or by pathfind_slow
@@ -170,16 +441,45 @@ PathFindMgr::pathfind(const char* pathList, const char* name, const char* mode)
   // paths not found by pathfind() and (c) paths relative to the
   // current-working-directory.
   // -------------------------------------------------------
+  answer = RealPath(name_real.c_str());
 
-  // FIXME: static buffer (per object) for pathfind answer
-  m_pathfind_ans = RealPath(name_real.c_str());
+  return (found || answer[0] == '/');
+}
 
-  if (found || m_pathfind_ans[0] == '/') {
-    return m_pathfind_ans.c_str();
+
+void
+PathFindMgr::populate(const char* pathList)
+{
+  if (m_isPopulated) {
+    return;
   }
-  else {
-    return NULL; // failure
+
+  m_isPopulated = true;
+  std::vector<std::string> pathVec; // will contain all -I paths
+  StrUtil::tokenize_str(std::string(pathList), ":", pathVec);
+    
+  std::set<std::string> seenPaths;
+  std::vector<std::string> recursionStack;
+  while (!m_isFull && !pathVec.empty()) {
+    if (pathVec.back() != ".") { // do not cache within CWD
+      scan(pathVec.back(), seenPaths, &recursionStack);
+      seenPaths.clear();
+      recursionStack.clear();
+    }
+    pathVec.pop_back();
   }
+
+  m_prefetched.clear();
+}
+
+
+void
+PathFindMgr::prefetch(DirContentsMap& dirs)
+{
+  if (!m_isPopulated) {
+    m_prefetched.swap(dirs);
+  }
+  dirs.clear();
 }
 
 
@@ -450,12 +750,82 @@ PathFindMgr::scan(std::string& path, std::set<std::string>& seenPaths,
   // -------------------------------------------------------
   // Scan 'path'
   // -------------------------------------------------------
-  DIR* dir = opendir(path.c_str());
-  if (!dir) {
+  DirContents contents_rd;
+  const DirContents* contents = &contents_rd;
+
+  DirContentsMap::const_iterator it_pf = m_prefetched.find(path);
+  if (it_pf != m_prefetched.end()) {
+    contents = &it_pf->second;
+  }
+  else if (!readDir(path, contents_rd)) {
     return localPaths;
   }
 
+  // --------------------------------------------------
+  // case 1: regular files
+  // --------------------------------------------------
+  if (doCacheFiles) {
+    for (uint i = 0; i < contents->files.size() && !m_isFull; ++i) {
+      insert(contents->files[i]);
+    }
+  }
+
+  // --------------------------------------------------
+  // case 2: directories
+  // --------------------------------------------------
   bool isFirstDir = true;
+  for (uint i = 0; i < contents->dirs.size(); ++i) {
+    std::string x_fnm = contents->dirs[i].first;
+    bool isLink = contents->dirs[i].second;
+
+    if (isLink && seenPaths.find(x_fnm) != seenPaths.end()) {
+      continue; // avoid cycles
+    }
+
+    if (recursionStack) {
+      if (doRecursiveScan) {
+	x_fnm += "/*";
+	recursionStack->push_back(x_fnm);
+      }
+    }
+    else {
+      x_fnm += "/*";
+      if (!isFirstDir) {
+	localPaths += ":";
+      }
+      localPaths += x_fnm;
+      isFirstDir = false;
+    }
+  }
+  
+  if (recursionStack && !recursionStack->empty()) {
+    std::string nextPath = recursionStack->back();
+    recursionStack->pop_back();
+    scan(nextPath, seenPaths, recursionStack);
+  }
+
+  return localPaths;
+}
+
+
+bool
+PathFindMgr::readDir(const std::string& path, DirContents& contents)
+{
+  struct timespec mtime;
+  bool hasMtime = false;
+  if (s_dirIndex.isEnabled()
+      && s_dirIndex.find(path, contents, mtime, hasMtime)) {
+    return true;
+  }
+
+  contents.files.clear();
+  contents.dirs.clear();
+
+  DIR* dir = opendir(path.c_str());
+  if (!dir) {
+    return false;
+  }
+
   struct dirent* x;
   while ( (x = readdir(dir)) ) {
     // skip "." and ".."
@@ -495,7 +865,8 @@ PathFindMgr::scan(std::string& path, std::set<std::string>& seenPaths,
     // --------------------------------------------------
     // special case: resolve symlink to regular file or directory
     // --------------------------------------------------
-    if (x_type == DT_LNK) {
+    bool isLink = (x_type == DT_LNK);
+    if (isLink) {
       struct stat statbuf;
       int ret = stat(x_fnm.c_str(), &statbuf); // 'stat' resolves symlinks
       if (ret != 0) {
@@ -508,50 +879,37 @@ PathFindMgr::scan(std::string& path, std::set<std::string>& seenPaths,
       else if (S_ISDIR(statbuf.st_mode)) {
 	x_type = DT_DIR;
 	x_fnm = RealPath(x_fnm.c_str());
-	if (seenPaths.find(x_fnm) != seenPaths.end()) {
-	  continue; // avoid cycles
-	}
       }
     }
 
-    // --------------------------------------------------
-    // case 1: regular file
-    // --------------------------------------------------
     if (x_type == DT_REG) {
-      if (doCacheFiles && !m_isFull) {
-	insert(x_fnm);
-      }
+      contents.files.push_back(x_fnm);
     }
-
-    // --------------------------------------------------
-    // case 2: directory
-    // --------------------------------------------------
     else if (x_type == DT_DIR) {
-      if (recursionStack) {
-	if (doRecursiveScan) {
-	  x_fnm += "/*";
-	  recursionStack->push_back(x_fnm);
-	}
-      }
-      else {
-	x_fnm += "/*";
-	if (!isFirstDir) {
-	  localPaths += ":";
-	}
-	localPaths += x_fnm;
-	isFirstDir = false;
-      }
+      contents.dirs.push_back(std::make_pair(x_fnm, isLink));
     }
   }
   closedir(dir);
-  
-  if (recursionStack && !recursionStack->empty()) {
-    std::string nextPath = recursionStack->back();
-    recursionStack->pop_back();
-    scan(nextPath, seenPaths, recursionStack);
+
+  if (hasMtime) {
+    s_dirIndex.insert(path, mtime, contents);
   }
 
-  return localPaths;
+  return true;
+}
+
+
+void
+PathFindMgr::useIndex(const std::string& fnm)
+{
+  s_dirIndex.load(fnm);
+}
+
+
+void
+PathFindMgr::saveIndex()
+{
+  s_dirIndex.save();
 }
 
 
@@ -127,6 +127,68 @@ public:
   // calls to this function, and must not be freed by the caller.
   const char*
   pathfind(const char* pathList, const char* name, const char* mode);
+
+  // pathfind: as above, but copies the answer to 'answer' and returns
+  // whether it was found.  Once the cache has been populated (cf.
+  // populate()), this may be called by several threads at once.
+  bool
+  pathfind(const char* pathList, const char* name, const char* mode,
+	   std::string& answer);
+
+
+  // populate: caches the files found using 'pathList', as the first
+  // call to pathfind() would.  Does nothing if already populated.
+  void
+  populate(const char* pathList);
+
+  bool
+  isPopulated() const
+  { return m_isPopulated; }
+
+
+  // DirContents: the regular files and the subdirectories (with
+  // whether each is a symlink) of a directory, as full paths in
+  // readdir() order
+  struct DirContents {
+    std::vector<std::string> files;
+    std::vector<std::pair<std::string, bool> > dirs;
+  };
+
+  typedef std::map<std::string, DirContents> DirContentsMap;
+
+  // readDir: reads the directory 'path' into 'contents', following
+  // symlinks; symlinked subdirectories are real-pathed.  Returns false
+  // if 'path' cannot be opened.  Does not touch any PathFindMgr, so
+  // it may be called by several threads at once.  With an index (cf.
+  // useIndex()), the contents are taken from it instead when the
+  // directory's modification time is unchanged.
+  static bool
+  readDir(const std::string& path, DirContents& contents);
+
+
+  // useIndex: keep the contents of the directories read by readDir()
+  // in the index file 'fnm' across runs.  Loads 'fnm' if it exists;
+  // an entry is reused while its directory's modification time is
+  // unchanged, and reused without a stat() once validated in this run.
+  //
+  // N.B.: A directory's modification time does not change when the
+  // target of a symlink in it does; remove the index if such links
+  // are retargeted.
+  static void
+  useIndex(const std::string& fnm);
+
+  // saveIndex: writes the index (cf. useIndex()), if any, dropping
+  // directories that were not reached this run from a directory that
+  // was (i.e., that were deleted or moved)
+  static void
+  saveIndex();
+
+  // prefetch: hands over the contents of directories, keyed by their
+  // paths as scan() forms them, that were read ahead of time (e.g.,
+  // concurrently with readDir()).  Populating the cache uses these
+  // instead of reading the directories again.  Consumes 'dirs'.
+  void
+  prefetch(DirContentsMap& dirs);
   
   
   // Is this a valid recursive path of the form '.../path/\*' ?
@@ -282,6 +344,8 @@ private:
   uint64_t m_size;
 
   std::string m_pathfind_ans;
+
+  DirContentsMap m_prefetched; // cleared once populated
 };
 
 #endif
@@ -53,6 +53,7 @@
 // 1. You can test for string equality by testing their indices.
 //
 // 2. str2index() inserts the string if not already in the table.
+// find() only looks it up and returns -1 if it is not there.
 //
 // 3. index2str() returns "invalid-string" if the index is out of
 // range.  We could possibly throw an exception instead.
@@ -60,14 +61,25 @@
 // 4. This version manages the strings via new and delete.  We could
 // add a custom allocator to store the strings in a common area for
 // faster bulk deletion.
+//
+// 5. Indices and the strings they refer to are stable for the life of
+// the table, so a reference from index2str() may be held.
+//
+// 6. global() is a process-wide table for interning names that are
+// shared by many objects, e.g., the procedure and file names of a
+// Prof::Struct tree.  It is never deleted, so its strings outlive any
+// static objects that use them.  As with any table, inserting is not
+// thread-safe; lookups are safe while no thread inserts.  In the
+// global table, EmptyIndex is always the empty string.
 
 //***************************************************************************
 
 #ifndef Support_String_Table_hpp
 #define Support_String_Table_hpp
 
-#include <map>
+#include <functional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace HPC {
@@ -81,8 +93,26 @@ public:
   }
 };
 
+// hash the strings, not the pointers
+class StringHash {
+public:
+  size_t operator() (const std::string *s) const
+  {
+    return std::hash<std::string>()(*s);
+  }
+};
+
+class StringEqual {
+public:
+  bool operator() (const std::string *s1, const std::string *s2) const
+  {
+    return *s1 == *s2;
+  }
+};
+
 class StringTable {
-  typedef std::map <const std::string *, long, StringCompare> StringMap;
+  typedef std::unordered_map <const std::string *, long,
+			      StringHash, StringEqual> StringMap;
   typedef std::vector <const std::string *> StringVec;
 
 private:
@@ -106,6 +136,16 @@ public:
     }
   }
 
+  // index of "" in the global table
+  static const long EmptyIndex = 0;
+
+  // the process-wide table
+  static StringTable & global()
+  {
+    static StringTable * table = newGlobal();
+    return *table;
+  }
+
   // lookup the string in the map and insert if not there
   long str2index(const std::string & str)
   {
@@ -124,7 +164,15 @@ public:
     return index;
   }
 
-  const std::string & index2str(long index)
+  // lookup the string in the map, but don't insert
+  long find(const std::string & str) const
+  {
+    StringMap::const_iterator it = m_map.find(&str);
+
+    return (it != m_map.end()) ? it->second : -1;
+  }
+
+  const std::string & index2str(long index) const
   {
     if (index < 0 || index >= (long) m_vec.size()) {
       return m_invalid;
@@ -132,11 +180,19 @@ public:
     return *(m_vec[index]);
   }
 
-  long size()
+  long size() const
   {
     return m_vec.size();
   }
 
+private:
+  static StringTable * newGlobal()
+  {
+    StringTable * table = new StringTable;
+    table->str2index("");
+    return table;
+  }
+
 };  // class StringTable
 
 }  // namespace HPC
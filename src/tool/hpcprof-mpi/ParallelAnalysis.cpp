@@ -403,9 +403,14 @@ unpackMetrics(Prof::CallPath::Profile& profile,
   DIAG_Assert(packedMetrics.numNodes() == cct.maxDenseId() + 1, "");
   DIAG_Assert(packedMetrics.numMetrics() == mEndId - mBegId, "");
 
-  for (uint nodeId = 1; nodeId < packedMetrics.numNodes(); ++nodeId) {
+  // N.B.: with dense ids, every nodeId in [1, numNodes()) is in 'cct'
+  for (Prof::CCT::ANodeIterator it(cct.root()); it.Current(); ++it) {
+    Prof::CCT::ANode* n = it.current();
+    uint nodeId = n->id();
+    if (nodeId == 0 || nodeId >= packedMetrics.numNodes()) {
+      continue;
+    }
     for (uint mId1 = 0, mId2 = mBegId; mId2 < mEndId; ++mId1, ++mId2) {
-      Prof::CCT::ANode* n = cct.findNode(nodeId);
       n->demandMetric(mId2) = packedMetrics.idx(nodeId, mId1);
     }
   }
@@ -92,6 +92,7 @@ using std::vector;
 #include <lib/analysis/Util.hpp>
 
 #include <lib/binutils/VMAInterval.hpp>
+#include <lib/prof/CCT-Tree.hpp>
 #include <lib/prof/FileError.hpp>
 
 #include <lib/prof-lean/hpcrun-fmt.h>
@@ -99,6 +100,7 @@ using std::vector;
 #include <lib/support/diagnostics.h>
 #include <lib/support/FileUtil.hpp>
 #include <lib/support/Logic.hpp>
+#include <lib/support/PathFindMgr.hpp>
 #include <lib/support/RealPathMgr.hpp>
 #include <lib/support/StrUtil.hpp>
 
@@ -240,7 +242,12 @@ realmain(int argc, char* const* argv)
   Args args;
   args.parse(argc, argv, Analysis::AppType::APP_HPCPROF_MPI); // may call exit()
 
+  Prof::CCT::ANode::aggregationJobs(args.prof_jobs);
+
   RealPathMgr::singleton().searchPaths(args.searchPathStr());
+  if (!args.searchPathIndex.empty()) {
+    PathFindMgr::useIndex(args.searchPathIndex);
+  }
   hpcprof_set_abort_timeout();
 
   // -------------------------------------------------------
@@ -425,7 +432,11 @@ realmain(int argc, char* const* argv)
       profGbl->metricMgr()->zeroDBInfo();
     }
 
+    // only this rank copies source files
+    Analysis::Util::prefetchSearchPaths(RealPathMgr::singleton().searchPaths(),
+					args.prof_jobs);
     Analysis::CallPath::makeDatabase(*profGbl, args);
+    PathFindMgr::saveIndex();
   }
   else {
     Analysis::Util::copyTraceFiles(args.db_dir, profGbl->traceFileNameSet());
@@ -77,7 +77,10 @@ using std::string;
 #include <lib/analysis/CallPath.hpp>
 #include <lib/analysis/Util.hpp>
 
+#include <lib/prof/CCT-Tree.hpp>
+
 #include <lib/support/diagnostics.h>
+#include <lib/support/PathFindMgr.hpp>
 #include <lib/support/RealPathMgr.hpp>
 
 
@@ -139,7 +142,14 @@ realmain(int argc, char* const* argv)
   Args args;
   args.parse(argc, argv);
 
+  Prof::CCT::ANode::aggregationJobs(args.prof_jobs);
+
   RealPathMgr::singleton().searchPaths(args.searchPathStr());
+  if (!args.searchPathIndex.empty()) {
+    PathFindMgr::useIndex(args.searchPathIndex);
+  }
+  Analysis::Util::prefetchSearchPaths(RealPathMgr::singleton().searchPaths(),
+				      args.prof_jobs);
 
   Analysis::Util::NormalizeProfileArgs_t nArgs =
     Analysis::Util::normalizeProfileArgs(args.profileFiles);
@@ -249,6 +259,7 @@ realmain(int argc, char* const* argv)
   }
 
   Analysis::CallPath::makeDatabase(*prof, args);
+  PathFindMgr::saveIndex();
 
 
   // -------------------------------------------------------
@@ -66,6 +66,9 @@ using std::endl;
 #include <string>
 using std::string;
 
+#include <stdint.h>
+#include <stdlib.h>
+
 //*************************** User Include Files ****************************
 
 #include <include/hpctoolkit-config.h>
@@ -105,7 +108,21 @@ static const char* usage_details =
 		 "Options:\n"
 		 "  -V, --version        Print version information.\n"
 		 "  -h, --help           Print this help.\n"
-		 "  -l, --lm             Print the load modules only.\n";
+		 "  -l, --lm             Print the load modules only.\n"
+		 "  -j <num>, --jobs <num>\n"
+		 "                       Dump up to <num> files concurrently.  Output\n"
+		 "                       stays in command-line order.  Default is 1.\n"
+		 "  -f <fmt>, --format <fmt>\n"
+		 "                       Dump trace records as 'text' (default), 'csv'\n"
+		 "                       (rank,thread,time,cpid,metricid) or 'binary'\n"
+		 "                       (packed {int32 rank, int32 thread, uint64 time,\n"
+		 "                       uint32 cpid, uint32 metricid} in host byte\n"
+		 "                       order).  csv and binary take trace files only.\n"
+		 "  -t <begin:end>, --time <begin:end>\n"
+		 "                       Dump trace records with begin <= time < end\n"
+		 "                       (nanoseconds).  Either bound may be omitted.\n"
+		 "  -r <lo[:hi]>, --rank <lo[:hi]>\n"
+		 "                       Dump only files whose MPI rank is in [lo, hi].\n";
 
 
 #define CLP CmdLineParser
@@ -120,11 +137,51 @@ CmdLineParser::OptArgDesc Args::optArgs[] = {
      NULL },
   { 'l', "lm",              CLP::ARG_NONE, CLP::DUPOPT_CLOB, NULL,
      NULL },
+  { 'j', "jobs",            CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
+     NULL },
+  { 'f', "format",          CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
+     NULL },
+  { 't', "time",            CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
+     NULL },
+  { 'r', "rank",            CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
+     NULL },
   CmdLineParser_OptArgDesc_NULL_MACRO // SGI's compiler requires this version
 };
 
 #undef CLP
 
+//***************************************************************************
+
+// Parse "lo:hi", "lo", "lo:" or ":hi" into 'lo' and 'hi', which keep
+// their values for omitted bounds.  Returns false if malformed.
+static bool
+parseRange(const char* arg, uint64_t* lo, uint64_t* hi)
+{
+  char* end;
+  if (*arg != ':') {
+    *lo = strtoull(arg, &end, 10);
+    if (end == arg) {
+      return false;
+    }
+    arg = end;
+  }
+  if (*arg == '\0') {
+    return true;
+  }
+  if (*arg != ':') {
+    return false;
+  }
+  arg++;
+  if (*arg != '\0') {
+    *hi = strtoull(arg, &end, 10);
+    if (*end != '\0') {
+      return false;
+    }
+  }
+  return true;
+}
+
+
 //***************************************************************************
 // Args
 //***************************************************************************
@@ -148,6 +205,10 @@ Args::Ctor()
   obj_metricsAsPercents = true;
   obj_showSourceCode = false;
   obj_procThreshold = 1;
+  jobs = 1;
+  rankFilter = false;
+  rankLo = -1;
+  rankHi = INT32_MAX;
 
   Diagnostics_SetDiagnosticFilterLevel(1);
 
@@ -236,6 +297,45 @@ Args::parse(int argc, const char* const argv[])
       // print the load modules only
       Analysis::Util::option = Analysis::Util::OutputOption_t::Print_LoadModule_Only;
     }
+    if (parser.isOpt("jobs")) {
+      const string& arg = parser.getOptArg("jobs");
+      jobs = (int) CmdLineParser::toLong(arg);
+      if (jobs < 1) {
+	ARG_ERROR("--jobs must be at least 1");
+      }
+    }
+    if (parser.isOpt("format")) {
+      const string& arg = parser.getOptArg("format");
+      if (arg == "text") {
+	traceOpts.format = Analysis::Raw::TraceDumpOpts::Text;
+      }
+      else if (arg == "csv") {
+	traceOpts.format = Analysis::Raw::TraceDumpOpts::CSV;
+      }
+      else if (arg == "binary") {
+	traceOpts.format = Analysis::Raw::TraceDumpOpts::Binary;
+      }
+      else {
+	ARG_ERROR("unknown --format '" << arg << "'");
+      }
+    }
+    if (parser.isOpt("time")) {
+      const string& arg = parser.getOptArg("time");
+      if (!parseRange(arg.c_str(), &traceOpts.timeBeg, &traceOpts.timeEnd)) {
+	ARG_ERROR("bad --time range '" << arg << "'");
+      }
+    }
+    if (parser.isOpt("rank")) {
+      const string& arg = parser.getOptArg("rank");
+      uint64_t lo = 0, hi = INT32_MAX;
+      if (arg[0] == ':' || !parseRange(arg.c_str(), &lo, &hi)) {
+	ARG_ERROR("bad --rank range '" << arg << "'");
+      }
+      // a single rank selects just that rank
+      rankFilter = true;
+      rankLo = lo;
+      rankHi = (arg.find(':') != string::npos) ? (long) hi : (long) lo;
+    }
 
     // FIXME: sanity check that options correspond to mode
     
@@ -71,6 +71,7 @@
 #include <include/uint.h>
 
 #include <lib/analysis/Args.hpp>
+#include <lib/analysis/Raw.hpp>
 
 #include <lib/support/diagnostics.h>
 #include <lib/support/CmdLineParser.hpp>
@@ -142,6 +143,18 @@ public:
   bool obj_metricsAsPercents;
   bool obj_showSourceCode;
 
+  // number of files to dump concurrently
+  int jobs;
+
+  // trace record format and time range
+  Analysis::Raw::TraceDumpOpts traceOpts;
+
+  // keep files whose MPI rank is in [rankLo, rankHi]; files whose name
+  // has no rank are kept only when not filtering
+  bool rankFilter;
+  long rankLo;
+  long rankHi;
+
 private:
   void Ctor();
   void setHPCHome(); 
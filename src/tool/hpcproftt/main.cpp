@@ -54,6 +54,11 @@
 using std::string;
 
 #include <exception>
+#include <mutex>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 //*********************** Xerces Include Files *******************************
 
@@ -67,6 +72,9 @@ using std::string;
 #include <lib/analysis/Flat-ObjCorrelation.hpp>
 #include <lib/analysis/Raw.hpp>
 
+#include <lib/prof-lean/hpcio.h>
+#include <lib/prof-lean/hpcrun-fmt.h>
+
 #include <lib/support/diagnostics.h>
 #include <lib/support/NaN.h>
 
@@ -76,7 +84,7 @@ static int
 realmain(int argc, char* const* argv);
 
 static int
-main_rawData(const std::vector<string>& profileFiles);
+main_rawData(const Args& args);
 
 
 //****************************************************************************
@@ -124,7 +132,7 @@ static int
 realmain(int argc, char* const* argv) 
 {
   Args args(argc, argv);  // exits if error on command line
-  return main_rawData(args.profileFiles); 
+  return main_rawData(args);
 }
 
 
@@ -132,23 +140,164 @@ realmain(int argc, char* const* argv)
 //
 //****************************************************************************
 
+// Raw::writeAsText cannot read profiles concurrently.
+static std::mutex profileLock;
+
+
+// Dump one file to 'os', catching (and reporting) any error so that
+// it never escapes an OpenMP region.  Returns true on success.
+static bool
+dumpFile(FILE* os, const char* fnm, const Args& args)
+{
+  using namespace Analysis::Util;
+
+  const Analysis::Raw::TraceDumpOpts& traceOpts = args.traceOpts;
+  bool isText = (traceOpts.format == Analysis::Raw::TraceDumpOpts::Text);
+
+  if (args.rankFilter) {
+    int rank, thread;
+    hpcrun_fmt_fnm_rank_thread(fnm, &rank, &thread);
+    if (rank < args.rankLo || rank > args.rankHi) {
+      return true;
+    }
+  }
+
+  try {
+    // generate nice header
+    if (option == Print_All && isText) {
+      string rule(77, '=');
+      fprintf(os, "%s\n%s\n%s\n", rule.c_str(), fnm, rule.c_str());
+    }
+
+    ProfType_t ty = getProfileType(fnm);
+    if (ty == ProfType_CallpathTrace) {
+      Analysis::Raw::writeAsText_callpathTrace(os, fnm, traceOpts);
+    }
+    else if (!isText) {
+      DIAG_EMsg("'" << fnm << "' is not a trace file; only trace files "
+		"can be dumped as csv or binary");
+      return false;
+    }
+    else if (ty == ProfType_Callpath || ty == ProfType_Flat) {
+      std::lock_guard<std::mutex> lock(profileLock);
+      Analysis::Raw::writeAsText(os, fnm);
+    }
+    else {
+      Analysis::Raw::writeAsText(os, fnm);
+    }
+  }
+  catch (const Diagnostics::Exception& x) {
+    DIAG_EMsg(x.message());
+    return false;
+  }
+  catch (const std::exception& x) {
+    DIAG_EMsg("[std::exception] " << x.what());
+    return false;
+  }
+  catch (...) {
+    DIAG_EMsg("Unknown exception encountered!");
+    return false;
+  }
+  return true;
+}
+
+
+// An unlinked temporary file in $TMPDIR (or /tmp); it goes away when
+// closed.  (cf. hpctracedump)
+static FILE*
+openSpillFile()
+{
+  const char* dir = getenv("TMPDIR");
+  string path = string((dir && *dir) ? dir : "/tmp") + "/hpcproftt-XXXXXX";
+
+  std::vector<char> name(path.begin(), path.end());
+  name.push_back('\0');
+  int fd = mkstemp(name.data());
+  if (fd < 0) {
+    return NULL;
+  }
+  unlink(name.data());
+
+  FILE* fs = fdopen(fd, "w+");
+  if (!fs) {
+    close(fd);
+  }
+  return fs;
+}
+
+
+// Copy all of 'spill' to 'outfs'.  Returns true on success.
+static bool
+copySpill(FILE* spill, FILE* outfs)
+{
+  if (fflush(spill) != 0 || fseek(spill, 0, SEEK_SET) != 0) {
+    return false;
+  }
+
+  std::vector<char> buf(HPCIO_RWBufferSz);
+  size_t len;
+  while ((len = fread(buf.data(), 1, buf.size(), spill)) > 0) {
+    if (fwrite(buf.data(), 1, len, outfs) != len) {
+      return false;
+    }
+  }
+  return !ferror(spill);
+}
+
+
+// Dump the files in command-line order.  With more than one job, each
+// file is dumped into its own spill file and the ordered section
+// copies it to stdout, so memory stays bounded however large the
+// dumps are.
 static int
-main_rawData(const std::vector<string>& profileFiles)
+main_rawData(const Args& args)
 {
-  std::ostream& os = std::cout;
+  const std::vector<string>& profileFiles = args.profileFiles;
+  int jobs = args.jobs;
+
+  if (args.traceOpts.format == Analysis::Raw::TraceDumpOpts::CSV) {
+    fputs("rank,thread,time,cpid,metricid\n", stdout);
+  }
+
+  if (jobs <= 1 || profileFiles.size() <= 1) {
+    for (uint i = 0; i < profileFiles.size(); ++i) {
+      if (!dumpFile(stdout, profileFiles[i].c_str(), args)) {
+	return 1;
+      }
+    }
+    return 0;
+  }
+
+  bool failed = false;
 
+#pragma omp parallel for ordered schedule(dynamic, 1) num_threads(jobs)
   for (uint i = 0; i < profileFiles.size(); ++i) {
-    const char* fnm = profileFiles[i].c_str();
+    FILE* spill = openSpillFile();
+    bool ok = (spill != NULL);
+    if (ok) {
+      ok = dumpFile(spill, profileFiles[i].c_str(), args);
+    }
+    else {
+      DIAG_EMsg("unable to create a temporary file for '"
+		<< profileFiles[i] << "'");
+    }
 
-    // generate nice header
-    if (Analysis::Util::option == Analysis::Util::Print_All)  {
-      os << std::setfill('=') << std::setw(77) << "=" << std::endl;
-      os << fnm << std::endl;
-      os << std::setfill('=') << std::setw(77) << "=" << std::endl;
+#pragma omp ordered
+    {
+      if (!failed) {
+	if (ok && !copySpill(spill, stdout)) {
+	  DIAG_EMsg("error writing output for '" << profileFiles[i] << "'");
+	  ok = false;
+	}
+	failed = !ok;
+      }
+    }
+    if (spill) {
+      fclose(spill);
     }
-    Analysis::Raw::writeAsText(fnm); // pass os FIXME
   }
-  return 0;
+
+  return failed ? 1 : 0;
 }
 
 //****************************************************************************
@@ -46,8 +46,11 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include <ucontext.h>
 
+#include <monitor.h>
+
 #include <cct/cct_bundle.h>
 #include <cct/cct.h>
 #include <messages/messages.h>
@@ -59,6 +62,7 @@
 #include <lush/lush-backtrace.h>
 #include <thread_data.h>
 #include <hpcrun_stats.h>
+#include <fnbounds/fnbounds_interface.h>
 #include <trace.h>
 #include <trampoline/common/trampoline.h>
 #include <utilities/ip-normalized.h>
@@ -268,6 +272,78 @@ hpcrun_backtrace2cct(cct_bundle_t* cct, ucontext_t* context,
   return n;
 }
 
+//
+// Insert a call chain recorded by the kernel (e.g. the user part of a
+// PERF_SAMPLE_CALLCHAIN record) rather than one unwound from a context.
+// ips[0] is the innermost frame. The chain is complete only if it reaches
+// a libmonitor fence; otherwise it is recorded as a partial unwind.
+//
+cct_node_t*
+hpcrun_callchain2cct(cct_bundle_t* cct, void** ips, int nips,
+		     int metricId, hpcrun_metricVal_t metricIncr,
+		     void* data)
+{
+  if (nips <= 0) return NULL;
+
+  thread_data_t* td = hpcrun_get_thread_data();
+  backtrace_info_t bt;
+  memset(&bt, 0, sizeof(bt));
+  bt.fence = FENCE_NONE;
+  bt.partial_unwind = true;
+
+  td->btbuf_cur = td->btbuf_beg;
+  td->btbuf_sav = td->btbuf_end;
+
+  for (int i = 0; i < nips; i++) {
+    void* ip = ips[i];
+    void* func_start = NULL;
+    void* func_end = NULL;
+    load_module_t* lm = NULL;
+
+    hpcrun_ensure_btbuf_avail();
+
+    frame_t* frame = td->btbuf_cur++;
+    memset(frame, 0, sizeof(*frame));
+    frame->cursor.pc_unnorm = ip;
+    if (fnbounds_enclosing_addr(ip, &func_start, &func_end, &lm)) {
+      frame->ip_norm = hpcrun_normalize_ip(ip, lm);
+      frame->the_function = hpcrun_normalize_ip(func_start, lm);
+    } else {
+      frame->ip_norm = hpcrun_normalize_ip(ip, NULL);
+      frame->the_function = frame->ip_norm;
+    }
+    frame->cursor.pc_norm = frame->ip_norm;
+    frame->cursor.the_function = frame->the_function;
+
+    if (monitor_unwind_process_bottom_frame(ip)) {
+      bt.fence = FENCE_MAIN;
+    } else if (monitor_unwind_thread_bottom_frame(ip)) {
+      bt.fence = FENCE_THREAD;
+    }
+    if (bt.fence != FENCE_NONE) {
+      bt.partial_unwind = false;
+      break;
+    }
+  }
+
+  bt.begin = td->btbuf_beg;
+  bt.last  = td->btbuf_cur - 1;
+
+  cct_backtrace_finalize(&bt, 0);
+
+  if (bt.partial_unwind) {
+    if (ENABLED(NO_PARTIAL_UNW)) {
+      return NULL;
+    }
+    hpcrun_stats_num_samples_partial_inc();
+  }
+
+  hpcrun_stats_frames_total_inc((long)(bt.last - bt.begin + 1));
+
+  return hpcrun_cct_record_backtrace_w_metric(cct, bt.partial_unwind, &bt,
+					      false, metricId, metricIncr, data);
+}
+
 #if 0 // TODO: tallent: Use Mike's improved code; retire prior routines
 
 static cct_node_tt*
@@ -100,6 +100,9 @@ extern cct_node_t* hpcrun_backtrace2cct(cct_bundle_t* cct, ucontext_t* context,
 	int metricId, hpcrun_metricVal_t metricIncr,
 	int skipInner, int isSync, void *data);
 
+extern cct_node_t* hpcrun_callchain2cct(cct_bundle_t* cct, void** ips, int nips,
+	int metricId, hpcrun_metricVal_t metricIncr, void *data);
+
 
 extern void hpcrun_kernel_callpath_register(hpcrun_kernel_callpath_t kcp);
 
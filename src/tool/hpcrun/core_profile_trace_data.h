@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <lib/prof-lean/hpcio-buffer.h>
 #include <lib/prof-lean/hpcfmt.h> // for metric_aux_info_t
+#include <lib/prof-lean/hpcrun-fmt.h> // for hpctrace_fmt_datum_t
 
 #include "epoch.h"
 #include "cct2metrics.h"
@@ -38,6 +39,9 @@ typedef struct core_profile_trace_data_t {
   FILE* hpcrun_file;
   void* trace_buffer;
   hpcio_outbuf_t *trace_outbuf;
+  hpctrace_fmt_datum_t *trace_stage; // trace records not yet encoded
+  int trace_stage_len;
+  bool trace_stage_busy;             // trace_stage is being filled or encoded
 
   // ----------------------------------------
   // Perf support
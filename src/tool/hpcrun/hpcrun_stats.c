@@ -80,6 +80,13 @@ static atomic_long frames_total = ATOMIC_VAR_INIT(0);
 static atomic_long trolled_frames = ATOMIC_VAR_INIT(0);
 static atomic_long frames_libfail_total = ATOMIC_VAR_INIT(0);
 
+static atomic_long callchain_compared = ATOMIC_VAR_INIT(0);
+static atomic_long callchain_matched = ATOMIC_VAR_INIT(0);
+static atomic_long callchain_frames = ATOMIC_VAR_INIT(0);
+static atomic_long callchain_frames_matched = ATOMIC_VAR_INIT(0);
+
+static atomic_long perf_batch_dropped = ATOMIC_VAR_INIT(0);
+
 static atomic_long acc_trace_records = ATOMIC_VAR_INIT(0);
 static atomic_long acc_trace_records_dropped = ATOMIC_VAR_INIT(0);
 static atomic_long acc_samples = ATOMIC_VAR_INIT(0);
@@ -106,6 +113,13 @@ hpcrun_stats_reinit(void)
   atomic_store_explicit(&trolled_frames, 0, memory_order_relaxed);
   atomic_store_explicit(&frames_libfail_total, 0, memory_order_relaxed);
 
+  atomic_store_explicit(&callchain_compared, 0, memory_order_relaxed);
+  atomic_store_explicit(&callchain_matched, 0, memory_order_relaxed);
+  atomic_store_explicit(&callchain_frames, 0, memory_order_relaxed);
+  atomic_store_explicit(&callchain_frames_matched, 0, memory_order_relaxed);
+
+  atomic_store_explicit(&perf_batch_dropped, 0, memory_order_relaxed);
+
   atomic_store_explicit(&acc_trace_records, 0, memory_order_relaxed);
   atomic_store_explicit(&acc_trace_records_dropped, 0, memory_order_relaxed);
 
@@ -434,6 +448,33 @@ hpcrun_stats_num_samples_yielded(void)
   return atomic_load_explicit(&num_samples_yielded, memory_order_relaxed);
 }
 
+//-----------------------------------------------------
+// kernel call chains compared with the unwinder
+//-----------------------------------------------------
+
+void
+hpcrun_stats_callchain_compared_inc(long frames, long frames_matched,
+				    bool matched)
+{
+  atomic_fetch_add_explicit(&callchain_compared, 1L, memory_order_relaxed);
+  atomic_fetch_add_explicit(&callchain_frames, frames, memory_order_relaxed);
+  atomic_fetch_add_explicit(&callchain_frames_matched, frames_matched,
+			    memory_order_relaxed);
+  if (matched) {
+    atomic_fetch_add_explicit(&callchain_matched, 1L, memory_order_relaxed);
+  }
+}
+
+//-----------------------------------------------------
+// batched perf records dropped for lack of a call chain
+//-----------------------------------------------------
+
+void
+hpcrun_stats_perf_batch_dropped_inc(void)
+{
+  atomic_fetch_add_explicit(&perf_batch_dropped, 1L, memory_order_relaxed);
+}
+
 //-----------------------------
 // print summary
 //-----------------------------
@@ -491,6 +532,22 @@ hpcrun_stats_print_summary(void)
        cpu_intervals_total, cpu_intervals_susp
        );
 
+  long cc_compared = atomic_load_explicit(&callchain_compared, memory_order_relaxed);
+  if (cc_compared > 0) {
+    AMSG("CALLCHAIN COMPARISON: samples: %ld (matched: %ld), "
+	 "caller frames: %ld (matched: %ld)",
+	 cc_compared,
+	 atomic_load_explicit(&callchain_matched, memory_order_relaxed),
+	 atomic_load_explicit(&callchain_frames, memory_order_relaxed),
+	 atomic_load_explicit(&callchain_frames_matched, memory_order_relaxed));
+  }
+
+  long batch_dropped = atomic_load_explicit(&perf_batch_dropped, memory_order_relaxed);
+  if (batch_dropped > 0) {
+    AMSG("PERF BATCH: records dropped without a user call chain: %ld",
+	 batch_dropped);
+  }
+
   if (hpcrun_get_disabled()) {
     AMSG("SAMPLING HAS BEEN DISABLED");
   }
@@ -45,6 +45,13 @@
 // ******************************************************* EndRiceCopyright *
 
 
+//***************************************************************************
+// system includes
+//***************************************************************************
+
+#include <stdbool.h>
+
+
 //***************************************************************************
 // interface operations
 //***************************************************************************
@@ -167,6 +174,21 @@ void hpcrun_stats_num_unwind_intervals_suspicious_inc(void);
 long hpcrun_stats_num_unwind_intervals_suspicious(void);
 
 
+//-----------------------------------------------------
+// kernel call chains compared with the unwinder
+//-----------------------------------------------------
+
+void hpcrun_stats_callchain_compared_inc(long frames, long frames_matched,
+					 bool matched);
+
+
+//-----------------------------------------------------
+// batched perf records dropped for lack of a call chain
+//-----------------------------------------------------
+
+void hpcrun_stats_perf_batch_dropped_inc(void);
+
+
 //------------------------------------------------------
 // samples that include 1 or more successful troll steps
 //------------------------------------------------------
@@ -566,10 +566,22 @@ record_sample(event_thread_t *current, perf_mmap_data_t *mmap_data,
     .sampling_period = hpcrun_cycles_cmd_period,
     .is_time_based_metric = time_based_metric
   };
-  *sv = hpcrun_sample_callpath(context, current->event->hpcrun_metric_id,
+  if (context == NULL) {
+    // an older record of a batch, or the kernel call chain mode: use
+    // the user call chain recorded by the kernel instead of unwinding
+    *sv = hpcrun_sample_callchain((void **) mmap_data->user_ips,
+        mmap_data->user_nr, current->event->hpcrun_metric_id,
+        (hpcrun_metricVal_t) {.r=counter}, &info);
+  } else {
+    *sv = hpcrun_sample_callpath(context, current->event->hpcrun_metric_id,
         (hpcrun_metricVal_t) {.r=counter},
         0/*skipInner*/, 0/*isSync*/, &info);
 
+    if (sv->sample_node != NULL &&
+        perf_util_get_callchain_mode() == PERF_CALLCHAIN_COMPARE)
+      perf_util_compare_callchain(mmap_data);
+  }
+
   blame_shift_apply(current->event->hpcrun_metric_id, sv->sample_node, 
                     counter /*metricIncr*/);
 
@@ -1190,8 +1202,23 @@ perf_event_handler(
     sample_val_t sv;
     memset(&sv, 0, sizeof(sample_val_t));
 
-    if (mmap_data.header_type == PERF_RECORD_SAMPLE)
-      record_sample(current, &mmap_data, context, &sv);
+    if (mmap_data.header_type == PERF_RECORD_SAMPLE) {
+      // the signal context only describes the newest record. when samples
+      // are batched (HPCRUN_PERF_BATCH), the older ones are attributed
+      // through their own user call chain, as are all of them in the
+      // kernel call chain mode (HPCRUN_PERF_CALLCHAIN=kernel).
+      // an older record without a user call chain would be charged to
+      // the newest sample's IP, so drop it and count it instead.
+      void *record_context = context;
+      if (mmap_data.user_nr > 0 &&
+          (more_data || perf_util_get_callchain_mode() == PERF_CALLCHAIN_KERNEL))
+        record_context = NULL;
+
+      if (more_data && mmap_data.user_nr == 0)
+        hpcrun_stats_perf_batch_dropped_inc();
+      else
+        record_sample(current, &mmap_data, record_context, &sv);
+    }
 
     kernel_block_handler(current, sv, &mmap_data);
 
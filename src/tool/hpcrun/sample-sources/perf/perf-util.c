@@ -48,6 +48,8 @@
 
 #include <linux/version.h>
 #include <ctype.h>
+#include <stdlib.h>
+#include <strings.h>
 
 
 /******************************************************************************
@@ -55,6 +57,8 @@
  *****************************************************************************/
 
 #include <hpcrun/cct_insert_backtrace.h>
+#include <hpcrun/hpcrun_stats.h>
+#include <hpcrun/thread_data.h>
 #include <lib/prof-lean/spinlock.h>     // hostid
 #include <lib/support-lean/OSUtil.h>     // hostid
 
@@ -293,6 +297,88 @@ perf_util_get_max_sample_rate()
 }
 
 
+//----------------------------------------------------------
+// returns the number of samples the kernel accumulates in the
+// ring buffer before signaling hpcrun, as set by HPCRUN_PERF_BATCH.
+// the default of 1 signals on every sample.
+//----------------------------------------------------------
+int
+perf_util_get_batch_size()
+{
+  static int initialized = 0;
+  static int batch_size  = PERF_WAKEUP_EACH_SAMPLE;
+  if (!initialized) {
+    const char *val_str = getenv("HPCRUN_PERF_BATCH");
+    if (val_str != NULL) {
+      int val = atoi(val_str);
+      if (val > PERF_MAX_BATCH) {
+        EMSG("WARNING: Lowered HPCRUN_PERF_BATCH %d to %d.", val, PERF_MAX_BATCH);
+        val = PERF_MAX_BATCH;
+      }
+      if (val > 1) batch_size = val;
+    }
+    initialized = 1;
+  }
+  return batch_size;
+}
+
+
+//----------------------------------------------------------
+// returns how the call path of a sample is obtained, as set by
+// HPCRUN_PERF_CALLCHAIN:
+//   kernel:  build it from the user call chain recorded by the kernel,
+//            without unwinding. requires frame pointers.
+//   compare: unwind as usual, and count how often the kernel call
+//            chain agrees with the unwinder (see hpcrun_stats).
+//----------------------------------------------------------
+perf_callchain_mode_t
+perf_util_get_callchain_mode()
+{
+  static int initialized = 0;
+  static perf_callchain_mode_t mode = PERF_CALLCHAIN_UNWIND;
+  if (!initialized) {
+    const char *val_str = getenv("HPCRUN_PERF_CALLCHAIN");
+    if (val_str != NULL) {
+      if (strcasecmp(val_str, "kernel") == 0) {
+        mode = PERF_CALLCHAIN_KERNEL;
+      } else if (strcasecmp(val_str, "compare") == 0) {
+        mode = PERF_CALLCHAIN_COMPARE;
+      } else if (strcasecmp(val_str, "unwind") != 0) {
+        EMSG("WARNING: unknown HPCRUN_PERF_CALLCHAIN '%s', using 'unwind'.", val_str);
+      }
+    }
+    initialized = 1;
+  }
+  return mode;
+}
+
+
+//----------------------------------------------------------
+// compare the user call chain recorded by the kernel for a sample
+// with the backtrace the unwinder just generated for it.
+// the leaf is skipped since the sampled ip and the signal context
+// differ by the skid; the call chain matches if every caller the
+// unwinder found, up to the libmonitor fence, has the same return
+// address in the kernel call chain.
+//----------------------------------------------------------
+void
+perf_util_compare_callchain(perf_mmap_data_t *data)
+{
+  thread_data_t *td = hpcrun_get_thread_data();
+  if (td->btbuf_cur == NULL || data->user_nr == 0) return;
+
+  long nframes = td->btbuf_cur - td->btbuf_beg;
+  long matched = 0;
+  for (long i = 1; i < nframes && i < data->user_nr; i++) {
+    void *ra = hpcrun_frame_get_unnorm(td->btbuf_beg + i);
+    if (ra != (void *) data->user_ips[i]) break;
+    matched++;
+  }
+  long callers = nframes > 1 ? nframes - 1 : 0;
+  hpcrun_stats_callchain_compared_inc(callers, matched, matched == callers);
+}
+
+
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3,7,0)
 //----------------------------------------------------------
 // testing perf availability
@@ -398,8 +484,10 @@ perf_util_attr_init(
     attr->sample_period = our_rate;
   }
 
+  int batch_size = perf_util_get_batch_size();
+
   attr->disabled       = 1;                 /* the counter will be enabled later  */
-  attr->wakeup_events  = 1;                 /* wake up every samples */
+  attr->wakeup_events  = batch_size;        /* wake up every batch_size samples */
   attr->sample_type    = sample_type;
   attr->exclude_kernel = EXCLUDE;
   attr->exclude_hv     = EXCLUDE;
@@ -407,6 +495,18 @@ perf_util_attr_init(
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3,7,0)
   attr->exclude_callchain_user   = EXCLUDE_CALLCHAIN;
   attr->exclude_callchain_kernel = EXCLUDE_CALLCHAIN;
+
+  if (batch_size > PERF_WAKEUP_EACH_SAMPLE ||
+      perf_util_get_callchain_mode() != PERF_CALLCHAIN_UNWIND) {
+    // only the newest sample of a batch has a signal context to unwind;
+    // the others are attributed with the user call chain the kernel
+    // records for them. the kernel call chain mode uses it for all.
+    attr->sample_type           |= PERF_SAMPLE_IP | PERF_SAMPLE_CALLCHAIN;
+    attr->exclude_callchain_user = INCLUDE_CALLCHAIN;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,8,0)
+    attr->sample_max_stack       = MAX_CALLCHAIN_FRAMES + MAX_USER_CALLCHAIN_FRAMES;
+#endif
+  }
 #endif
 
   if (perf_util_is_ksym_available()) {
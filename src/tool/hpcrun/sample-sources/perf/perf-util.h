@@ -61,6 +61,11 @@
 // If we include user call chains, it should be bigger than that.
 #define MAX_CALLCHAIN_FRAMES 32
 
+// the number of maximum user frames kept from a kernel-recorded call
+// chain (batched sampling). Deeper chains are truncated at the outermost
+// end and recorded as partial unwinds.
+#define MAX_USER_CALLCHAIN_FRAMES 128
+
 
 /******************************************************************************
  * Data types
@@ -81,6 +86,8 @@ typedef struct perf_mmap_data_s {
                      /* if PERF_SAMPLE_READ */
   u64    nr;         /* if PERF_SAMPLE_CALLCHAIN */
   u64    ips[MAX_CALLCHAIN_FRAMES];       /* if PERF_SAMPLE_CALLCHAIN */
+  u64    user_nr;    /* if PERF_SAMPLE_CALLCHAIN, user frames */
+  u64    user_ips[MAX_USER_CALLCHAIN_FRAMES]; /* innermost first */
   u32    size;       /* if PERF_SAMPLE_RAW */
   char   *data;      /* if PERF_SAMPLE_RAW */
   /* if PERF_SAMPLE_BRANCH_STACK */
@@ -107,6 +114,14 @@ typedef struct perf_mmap_data_s {
 } perf_mmap_data_t;
 
 
+// how call paths of perf samples are obtained (HPCRUN_PERF_CALLCHAIN)
+typedef enum perf_callchain_mode_e {
+  PERF_CALLCHAIN_UNWIND,   // unwind from the signal context (default)
+  PERF_CALLCHAIN_KERNEL,   // use the call chain recorded by the kernel
+  PERF_CALLCHAIN_COMPARE   // unwind, and compare with the kernel call chain
+} perf_callchain_mode_t;
+
+
 // --------------------------------------------------------------
 // main data structure to store the information of an event.
 // this structure is designed to be created once during the initialization.
@@ -166,6 +181,15 @@ perf_util_get_paranoid_level();
 int
 perf_util_get_max_sample_rate();
 
+int
+perf_util_get_batch_size();
+
+perf_callchain_mode_t
+perf_util_get_callchain_mode();
+
+void
+perf_util_compare_callchain(perf_mmap_data_t *data);
+
 int
 perf_util_check_precise_ip_suffix(char *event);
 
@@ -55,6 +55,7 @@
 #define PERF_FLAGS      0
 #define PERF_REQUEST_0_SKID      2
 #define PERF_WAKEUP_EACH_SAMPLE  1
+#define PERF_MAX_BATCH           1024
 
 #define EXCLUDE    1
 #define INCLUDE    0
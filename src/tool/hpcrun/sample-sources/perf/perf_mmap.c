@@ -83,11 +83,15 @@
 
 #define MMAP_OFFSET_0            0
 
-#define PERF_DATA_PAGE_EXP        1      // use 2^PERF_DATA_PAGE_EXP pages
+#define PERF_DATA_PAGE_EXP        1      // use at least 2^PERF_DATA_PAGE_EXP pages
 #define PERF_DATA_PAGES           (1 << PERF_DATA_PAGE_EXP)
 
-#define PERF_MMAP_SIZE(pagesz)    ((pagesz) * (PERF_DATA_PAGES + 1))
-#define PERF_TAIL_MASK(pagesz)    (((pagesz) * PERF_DATA_PAGES) - 1)
+// generous size of a sample record with kernel and user call chains,
+// used to size the buffer for a batch of samples
+#define PERF_RECORD_SIZE_ESTIMATE 2048
+
+#define PERF_MMAP_SIZE(pagesz)    ((pagesz) * (data_pages + 1))
+#define PERF_TAIL_MASK(pagesz)    (((pagesz) * data_pages) - 1)
 
 #define BUFFER_FRONT(current_perf_mmap)              ((char *) current_perf_mmap + pagesize)
 #define BUFFER_SIZE               (tail_mask + 1)
@@ -107,6 +111,7 @@
 
 static int pagesize      = 0;
 static size_t tail_mask  = 0;
+static int data_pages    = PERF_DATA_PAGES;
 
 
 /******************************************************************************
@@ -244,29 +249,44 @@ perf_sample_callchain(u64 data_head, u64 *data_tail,
                       pe_mmap_t *current_perf_mmap, perf_mmap_data_t* mmap_data)
 {
   mmap_data->nr = 0;     // initialze the number of records to be 0
+  mmap_data->user_nr = 0;
   u64 num_records = 0;
 
   // determine how many frames in the call chain
-  if (perf_read_u64(data_head, data_tail, current_perf_mmap, &num_records) == 0) {
-    if (num_records > 0) {
-
-      // warning: if the number of frames is bigger than the storage (MAX_CALLCHAIN_FRAMES)
-      // we have to truncate them. This is not a good practice, but so far it's the only
-      // simplest solution I can come up.
-      mmap_data->nr = (num_records < MAX_CALLCHAIN_FRAMES ? num_records : MAX_CALLCHAIN_FRAMES);
-
-      // read the IPs for the frames
-      if (perf_read(data_head, data_tail,
-                    current_perf_mmap, mmap_data->ips, num_records * sizeof(u64)) != 0) {
-        // the data seems invalid
-        mmap_data->nr = 0;
-        TMSG(LINUX_PERF, "unable to read all %d frames", num_records);
-      }
-    }
-  } else {
+  if (perf_read_u64(data_head, data_tail, current_perf_mmap, &num_records) != 0) {
     TMSG(LINUX_PERF, "unable to read the number of frames" );
+    return 0;
+  }
+
+  // the call chain is a sequence of contexts, each introduced by a marker
+  // (PERF_CONTEXT_KERNEL, PERF_CONTEXT_USER, ...). kernel frames, with
+  // their leading marker, go in ips[]; user frames go in user_ips[].
+  //
+  // warning: if the number of frames is bigger than the storage
+  // (MAX_CALLCHAIN_FRAMES or MAX_USER_CALLCHAIN_FRAMES) we have to truncate
+  // them. the outermost frames are the ones dropped.
+  bool in_user = false;
+  for (u64 i = 0; i < num_records; i++) {
+    u64 ip;
+    if (perf_read_u64(data_head, data_tail, current_perf_mmap, &ip) != 0) {
+      // the data seems invalid
+      mmap_data->nr = 0;
+      mmap_data->user_nr = 0;
+      TMSG(LINUX_PERF, "unable to read all %d frames", num_records);
+      break;
+    }
+    if (ip >= PERF_CONTEXT_MAX) {
+      in_user = (ip == PERF_CONTEXT_USER);
+      if (in_user) continue;
+    }
+    if (in_user) {
+      if (mmap_data->user_nr < MAX_USER_CALLCHAIN_FRAMES)
+        mmap_data->user_ips[mmap_data->user_nr++] = ip;
+    } else if (mmap_data->nr < MAX_CALLCHAIN_FRAMES) {
+      mmap_data->ips[mmap_data->nr++] = ip;
+    }
   }
-  return mmap_data->nr;
+  return mmap_data->nr + mmap_data->user_nr;
 }
 
 
@@ -434,8 +454,8 @@ parse_sample_id_buffer(u64 data_head, u64 *data_tail,
 //----------------------------------------------------------
 // reading mmap buffer from the kernel
 // in/out: mmapped data of type perf_mmap_data_t.
-// return true if there are more data to be read,
-//        false otherwise
+// return the number of bytes that remain to be read after this
+//        record (non-zero if more records are pending), 0 otherwise
 //----------------------------------------------------------
 int
 read_perf_buffer(pe_mmap_t *current_perf_mmap,
@@ -486,9 +506,10 @@ read_perf_buffer(pe_mmap_t *current_perf_mmap,
 
   // update tail after consuming a record
   rmb();  // memory fence before writing data_tail
-  current_perf_mmap->data_tail += hdr.size;
+  data_tail = current_perf_mmap->data_tail + hdr.size;
+  current_perf_mmap->data_tail = data_tail;
 
-  return (data_tail-current_perf_mmap->data_tail);
+  return (data_head > data_tail ? data_head - data_tail : 0);
 }
 
 //----------------------------------------------------------
@@ -537,6 +558,14 @@ void
 perf_mmap_init()
 {
   pagesize = sysconf(_SC_PAGESIZE);
+
+  // the buffer must hold a whole batch of samples between two wakeups.
+  // the kernel requires a power of two number of data pages.
+  size_t batch_bytes = (size_t) perf_util_get_batch_size() * PERF_RECORD_SIZE_ESTIMATE;
+  data_pages = PERF_DATA_PAGES;
+  while ((size_t) data_pages * pagesize < batch_bytes) {
+    data_pages <<= 1;
+  }
   tail_mask = PERF_TAIL_MASK(pagesize);
 }
 
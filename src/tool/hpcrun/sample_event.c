@@ -221,6 +221,7 @@ hpcrun_sample_callpath(void* context, int metricId,
 
   td->btbuf_cur = NULL;
   td->deadlock_drop = false;
+  bool uw_pinned = uw_recipe_map_reader_enter();
   int ljmp = sigsetjmp(it->jb, 1);
   if (ljmp == 0) {
     if (epoch != NULL) {
@@ -250,6 +251,7 @@ hpcrun_sample_callpath(void* context, int metricId,
         metricId, metricIncr, skipInner, NULL);
     hpcrun_cleanup_partial_unwind();
   }
+  uw_recipe_map_reader_exit(uw_pinned);
   td->current_jmp_buf = old;
 
   // --------------------------------------
@@ -316,6 +318,91 @@ hpcrun_sample_callpath(void* context, int metricId,
   return ret;
 }
 
+//
+// Record a sample whose call path was captured by the kernel (or some other
+// agent) rather than unwound here, e.g. the older records of a batch drained
+// from a perf ring buffer, for which no signal context exists. ips[0] is the
+// innermost frame. No trace record is written for these samples.
+//
+sample_val_t
+hpcrun_sample_callchain(void** ips, int nips, int metricId,
+			hpcrun_metricVal_t metricIncr, sampling_info_t *data)
+{
+  sample_val_t ret;
+  hpcrun_sample_val_init(&ret);
+
+  if (monitor_block_shootdown()) {
+    monitor_unblock_shootdown();
+    return ret;
+  }
+
+  if (!hpctoolkit_sampling_is_active()) {
+    monitor_unblock_shootdown();
+    return ret;
+  }
+
+  hpcrun_stats_num_samples_total_inc();
+
+  if (hpcrun_is_sampling_disabled()) {
+    TMSG(SAMPLE,"global suspension");
+    hpcrun_all_sources_stop();
+    monitor_unblock_shootdown();
+    return ret;
+  }
+
+  TMSG(SAMPLE_CALLPATH, "attempting callchain sample (%d frames)", nips);
+  hpcrun_stats_num_samples_attempted_inc();
+
+  thread_data_t* td   = hpcrun_get_thread_data();
+  sigjmp_buf_t* it    = &(td->bad_unwind);
+  sigjmp_buf_t* old   = td->current_jmp_buf;
+  td->current_jmp_buf = it;
+
+  cct_node_t* node = NULL;
+  epoch_t* epoch = td->core_profile_trace_data.epoch;
+
+  hpcrun_set_handling_sample(td);
+
+  td->btbuf_cur = NULL;
+  td->deadlock_drop = false;
+  bool uw_pinned = uw_recipe_map_reader_enter();
+  int ljmp = sigsetjmp(it->jb, 1);
+  if (ljmp == 0) {
+    if (epoch != NULL) {
+      epoch = hpcrun_check_for_new_loadmap(epoch);
+
+      void *data_aux = NULL;
+      if (data != NULL)
+        data_aux = data->sample_data;
+
+      node = hpcrun_callchain2cct(&(epoch->csdata), ips, nips, metricId,
+                                  metricIncr, data_aux);
+
+      if (ENABLED(DUMP_BACKTRACES) && td->btbuf_cur != NULL) {
+        hpcrun_bt_dump(td->btbuf_cur, "CALLCHAIN");
+      }
+    }
+  }
+  else {
+    hpcrun_cleanup_partial_unwind();
+  }
+  uw_recipe_map_reader_exit(uw_pinned);
+  td->current_jmp_buf = old;
+
+  ret.sample_node = node;
+
+  hpcrun_clear_handling_sample(td);
+  if (TD_GET(mem_low) || ENABLED(FLUSH_EVERY_SAMPLE)) {
+    hpcrun_flush_epochs(&(TD_GET(core_profile_trace_data)));
+    hpcrun_reclaim_freeable_mem();
+  }
+
+  TMSG(SAMPLE_CALLPATH,"done w callchain sample, return %p", ret.sample_node);
+  monitor_unblock_shootdown();
+
+  return ret;
+}
+
 static int const PTHREAD_CTXT_SKIP_INNER = 1;
 
 cct_node_t*
@@ -345,6 +432,7 @@ hpcrun_gen_thread_ctxt(void* context)
   hpcrun_set_handling_sample(td);
 
   td->btbuf_cur = NULL;
+  bool uw_pinned = uw_recipe_map_reader_enter();
   int ljmp = sigsetjmp(it->jb, 1);
   backtrace_info_t bt;
 
@@ -355,6 +443,7 @@ hpcrun_gen_thread_ctxt(void* context)
     if (epoch != NULL) {
       if (! hpcrun_generate_backtrace_no_trampoline(&bt, context,
           PTHREAD_CTXT_SKIP_INNER)) {
+        uw_recipe_map_reader_exit(uw_pinned);
         hpcrun_clear_handling_sample(td); // restore state
         EMSG("Internal error: unable to obtain backtrace for pthread context");
         return NULL;
@@ -371,6 +460,7 @@ hpcrun_gen_thread_ctxt(void* context)
     node = hpcrun_cct_record_backtrace(&(epoch->csdata), false, &bt,
         bt.has_tramp);
   }
+  uw_recipe_map_reader_exit(uw_pinned);
   // restore back the sigjmp
   td->current_jmp_buf = old;
 
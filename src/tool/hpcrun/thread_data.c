@@ -311,6 +311,9 @@ core_profile_trace_data_init
   cptd->hpcrun_file  = NULL;
   cptd->trace_buffer = NULL;
   cptd->trace_outbuf = NULL;
+  cptd->trace_stage  = NULL;
+  cptd->trace_stage_len = 0;
+  cptd->trace_stage_busy = false;
 
   // ----------------------------------------
   // perf event support
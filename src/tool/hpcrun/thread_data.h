@@ -292,6 +292,9 @@ typedef struct thread_data_t {
 
 static const size_t HPCRUN_TraceBufferSz = HPCIO_RWBufferSz;
 
+// number of trace records staged before they are encoded in bulk
+static const int HPCRUN_TraceStageLen = 256;
+
 
 void 
 hpcrun_init_pthread_key
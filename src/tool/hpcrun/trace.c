@@ -72,11 +72,13 @@
 
 #include <memory/hpcrun-malloc.h>
 #include <messages/messages.h>
+#include <utilities/hpcrun-nanotime.h>
 
 #include <lib/prof-lean/hpcfmt.h>
 #include <lib/prof-lean/hpcrun-fmt.h>
 #include <lib/prof-lean/hpcio.h>
 #include <lib/prof-lean/hpcio-buffer.h>
+#include <lib/prof-lean/stdatomic.h>
 
 //*********************************************************************
 // local macros
@@ -100,6 +102,8 @@
 
 static void hpcrun_trace_file_validate(int valid, char *op);
 static inline void hpcrun_trace_append_with_time_real(core_profile_trace_data_t *cptd, unsigned int call_path_id, uint metric_id, uint32_t dLCA, uint64_t nanotime);
+static void hpcrun_trace_stage_write(core_profile_trace_data_t *cptd);
+static void hpcrun_trace_stage_flush(core_profile_trace_data_t *cptd);
 
 
 //*********************************************************************
@@ -108,6 +112,7 @@ static inline void hpcrun_trace_append_with_time_real(core_profile_trace_data_t
 
 static int tracing = 0;
 static int trace_suitable_metric = 0;
+static hpctrace_hdr_flags_t trace_flags;
 
 //*********************************************************************
 // interface operations
@@ -125,6 +130,22 @@ hpcrun_trace_init()
 {
   tracing = hpcrun_get_env_bool(HPCRUN_TRACE);
   TMSG(TRACE, "Tracing is %s", (tracing ? "ON" : "OFF"));
+  if (tracing) {
+    hpcrun_trace_clock_init();
+  }
+
+  trace_flags = hpctrace_hdr_flags_NULL;
+#ifdef DATACENTRIC_TRACE
+  HPCTRACE_HDR_FLAGS_SET_BIT(trace_flags, HPCTRACE_HDR_FLAGS_DATA_CENTRIC_BIT_POS, true);
+#else
+  HPCTRACE_HDR_FLAGS_SET_BIT(trace_flags, HPCTRACE_HDR_FLAGS_DATA_CENTRIC_BIT_POS, false);
+#endif
+
+#if defined(LCA_TRACE) && (defined (HOST_CPU_x86_64) || defined (HOST_CPU_PPC))
+  HPCTRACE_HDR_FLAGS_SET_BIT(trace_flags, HPCTRACE_HDR_FLAGS_LCA_RECORDED_BIT_POS, true);
+#else
+  HPCTRACE_HDR_FLAGS_SET_BIT(trace_flags, HPCTRACE_HDR_FLAGS_LCA_RECORDED_BIT_POS, false);
+#endif
 }
 
 void
@@ -154,21 +175,14 @@ hpcrun_trace_open(core_profile_trace_data_t * cptd)
 			      HPCRUN_TraceBufferSz, HPCIO_OUTBUF_UNLOCKED, hpcrun_malloc);
     hpcrun_trace_file_validate(ret == HPCFMT_OK, "open");
 
-    hpctrace_hdr_flags_t flags = hpctrace_hdr_flags_NULL;
-#ifdef DATACENTRIC_TRACE
-    HPCTRACE_HDR_FLAGS_SET_BIT(flags, HPCTRACE_HDR_FLAGS_DATA_CENTRIC_BIT_POS, true);
-#else
-    HPCTRACE_HDR_FLAGS_SET_BIT(flags, HPCTRACE_HDR_FLAGS_DATA_CENTRIC_BIT_POS, false);
-#endif
+    cptd->trace_stage = hpcrun_malloc(HPCRUN_TraceStageLen * sizeof(hpctrace_fmt_datum_t));
+    cptd->trace_stage_len = 0;
 
 #if defined(LCA_TRACE) && (defined (HOST_CPU_x86_64) || defined (HOST_CPU_PPC))
-    HPCTRACE_HDR_FLAGS_SET_BIT(flags, HPCTRACE_HDR_FLAGS_LCA_RECORDED_BIT_POS, true);
     ENABLE(USE_TRAMP);
-#else
-    HPCTRACE_HDR_FLAGS_SET_BIT(flags, HPCTRACE_HDR_FLAGS_LCA_RECORDED_BIT_POS, false);
 #endif
     
-    ret = hpctrace_fmt_hdr_outbuf(flags, cptd->trace_outbuf);
+    ret = hpctrace_fmt_hdr_outbuf(trace_flags, cptd->trace_outbuf);
     hpcrun_trace_file_validate(ret == HPCFMT_OK, "write header to");
   }
   TMSG(TRACE, "Trace open done");
@@ -189,11 +203,7 @@ void
 hpcrun_trace_append(core_profile_trace_data_t *cptd, cct_node_t* node, uint metric_id, uint32_t dLCA, uint64_t sampling_period)
 {
   if (tracing && hpcrun_sample_prob_active()) {
-    struct timeval tv;
-    int ret = gettimeofday(&tv, NULL);
-    assert(ret == 0 && "in trace_append: gettimeofday failed!");
-    uint64_t nanotime = ((uint64_t)tv.tv_usec
-                         + (((uint64_t)tv.tv_sec) * 1000000)) * 1000;
+    uint64_t nanotime = hpcrun_trace_nanotime();
     if (sampling_period > 0 && prev_nanotime != 0 && nanotime - prev_nanotime > TRACE_GAP_FACTOR * sampling_period) {
       cct_bundle_t* cct_bundle = &(cptd->epoch->csdata);
       cct_node_t* idle_node = hpcrun_cct_bundle_get_no_activity_node(cct_bundle);
@@ -238,6 +248,7 @@ hpcrun_trace_close(core_profile_trace_data_t * cptd)
   if (tracing && hpcrun_sample_prob_active()) {
 
     TMSG(TRACE, "Trace active close code");
+    hpcrun_trace_stage_flush(cptd);
     int ret = hpcio_outbuf_close(&cptd->trace_outbuf);
     if (ret != HPCFMT_OK) {
       EMSG("unable to flush and close trace file");
@@ -266,7 +277,7 @@ hpcrun_trace_append_with_time_real(core_profile_trace_data_t *cptd, unsigned int
     if(cptd->trace_max_time_us < nanotime) {
         cptd->trace_max_time_us = nanotime;
     }
-    
+
     hpctrace_fmt_datum_t trace_datum;
     trace_datum.cpId = (uint32_t)call_path_id;
     //TODO: was not in GPU version
@@ -275,27 +286,68 @@ hpcrun_trace_append_with_time_real(core_profile_trace_data_t *cptd, unsigned int
       dLCA = HPCTRACE_FMT_DLCA_NULL;
 
 #if defined(LCA_TRACE)
+    trace_datum.comp = 0;
     HPCTRACE_FMT_SET_TIME(trace_datum.comp, nanotime);
     HPCTRACE_FMT_SET_DLCA(trace_datum.comp, dLCA);
 #else
     trace_datum.comp = nanotime;
 #endif
-    
-    hpctrace_hdr_flags_t flags = hpctrace_hdr_flags_NULL;
-#ifdef DATACENTRIC_TRACE
-    HPCTRACE_HDR_FLAGS_SET_BIT(flags, HPCTRACE_HDR_FLAGS_DATA_CENTRIC_BIT_POS, true);
-#else
-    HPCTRACE_HDR_FLAGS_SET_BIT(flags, HPCTRACE_HDR_FLAGS_DATA_CENTRIC_BIT_POS, false);
-#endif
-    
-#if defined(LCA_TRACE) && (defined (HOST_CPU_x86_64) || defined (HOST_CPU_PPC))
-    HPCTRACE_HDR_FLAGS_SET_BIT(flags, HPCTRACE_HDR_FLAGS_LCA_RECORDED_BIT_POS, true);
-#else
-    HPCTRACE_HDR_FLAGS_SET_BIT(flags, HPCTRACE_HDR_FLAGS_LCA_RECORDED_BIT_POS, false);
-#endif
-    
-    int ret = hpctrace_fmt_datum_outbuf(&trace_datum, flags, cptd->trace_outbuf);
-    hpcrun_trace_file_validate(ret == HPCFMT_OK, "append");
+
+    // a sample that interrupts this thread while it fills or encodes the
+    // stage must not touch it; its record is written straight through.
+    // that record may land ahead of older staged ones, so the trace is
+    // no longer ordered.
+    if (cptd->trace_stage_busy) {
+      cptd->traceOrdered = false;
+      int ret = hpctrace_fmt_datum_outbuf(&trace_datum, trace_flags,
+                                          cptd->trace_outbuf);
+      hpcrun_trace_file_validate(ret == HPCFMT_OK, "append");
+      return;
+    }
+
+    // stage the record; records are encoded and written in bulk.  the
+    // fences keep the compiler from moving stage accesses outside the
+    // window in which the flag is set.
+    cptd->trace_stage_busy = true;
+    atomic_signal_fence(memory_order_seq_cst);
+
+    cptd->trace_stage[cptd->trace_stage_len++] = trace_datum;
+    if (cptd->trace_stage_len == HPCRUN_TraceStageLen) {
+      hpcrun_trace_stage_write(cptd);
+    }
+
+    atomic_signal_fence(memory_order_seq_cst);
+    cptd->trace_stage_busy = false;
+}
+
+
+// encode and write the staged records; the caller sets trace_stage_busy
+static void
+hpcrun_trace_stage_write(core_profile_trace_data_t *cptd)
+{
+  int ret = hpctrace_fmt_data_outbuf(cptd->trace_stage,
+                                     cptd->trace_stage_len, trace_flags,
+                                     cptd->trace_outbuf);
+  cptd->trace_stage_len = 0;
+  hpcrun_trace_file_validate(ret == HPCFMT_OK, "append");
+}
+
+
+static void
+hpcrun_trace_stage_flush(core_profile_trace_data_t *cptd)
+{
+  if (cptd->trace_stage == NULL || cptd->trace_stage_len == 0
+      || cptd->trace_stage_busy) {
+    return;
+  }
+
+  cptd->trace_stage_busy = true;
+  atomic_signal_fence(memory_order_seq_cst);
+
+  hpcrun_trace_stage_write(cptd);
+
+  atomic_signal_fence(memory_order_seq_cst);
+  cptd->trace_stage_busy = false;
 }
 
 
@@ -65,6 +65,7 @@
 #include "epoch.h"
 #include "monitor.h"
 #include "sample_event.h"
+#include "uw_recipe_map.h"
 
 #include <messages/messages.h>
 
@@ -89,6 +90,9 @@ hpcrun_backtrace_lite(void** buffer, int size, ucontext_t* context)
 
   hpcrun_unw_init();
 
+  // recipes found by the cursor are only valid while the map is pinned
+  bool uw_pinned = uw_recipe_map_reader_enter();
+
   hpcrun_unw_cursor_t cursor;
   hpcrun_unw_init_cursor(&cursor, context);
 
@@ -111,7 +115,9 @@ hpcrun_backtrace_lite(void** buffer, int size, ucontext_t* context)
     }
     first_step = 0;
   }
-  
+
+  uw_recipe_map_reader_exit(uw_pinned);
+
   return my_size;
 }
 #endif
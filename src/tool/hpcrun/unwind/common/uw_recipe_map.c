@@ -48,7 +48,10 @@
  * Maintain a map from address Intervals to unwind intervals.
  *
  * Note: the caller need not acquire/release locks as part
- * of using the map.
+ * of using the map. Lookups never lock: a sample brackets its unwind
+ * with uw_recipe_map_reader_enter/exit, and recipes for unmapped load
+ * modules are freed only once every such reader has exited
+ * (epoch-based reclamation; see lib/prof-lean/ebr.h).
  *
  * $Id$
  */
@@ -86,6 +89,7 @@
 #include "unwind-interval.h"
 #include <fnbounds/fnbounds_interface.h>
 #include <lib/prof-lean/cskiplist.h>
+#include <lib/prof-lean/ebr.h>
 #include <lib/prof-lean/mcs-lock.h>
 #include <lib/prof-lean/binarytree.h>
 #include "binarytree_uwi.h"
@@ -276,6 +280,15 @@ static cskiplist_t *unwinder_to_cskiplist[NUM_UNWINDERS];
 // and inserting entries into unwinder_to_cskiplist:
 static mem_alloc my_alloc = hpcrun_malloc;
 
+// reclamation domain for nodes deleted from unwinder_to_cskiplist
+static ebr_t uw_recipe_map_ebr;
+static __thread ebr_record_t *uw_recipe_map_reader = NULL;
+
+// count of unmaps; a thread whose uw_hash_table predates the latest
+// unmap may hold pointers to recipes that are about to be freed.
+static atomic_uint_least64_t uw_recipe_map_unmaps;
+static __thread uint64_t uw_hash_unmaps = 0;
+
 //******************************************************************************
 // String output
 //******************************************************************************
@@ -562,10 +575,15 @@ uw_recipe_map_notify_map(load_module_t* lm)
   void* end = lm->dso_info->end_addr;
   uw_recipe_map_report_and_dump("*** map: before unpoisoning", start, end);
 
+  // unpoisoning finds a node before deleting it
+  bool pinned = uw_recipe_map_reader_enter();
+
   unwinder_t uw;
   for (uw = 0; uw < NUM_UNWINDERS; uw++)
     uw_recipe_map_unpoison((uintptr_t)start, (uintptr_t)end, uw);
 
+  uw_recipe_map_reader_exit(pinned);
+
   uw_recipe_map_report_and_dump("*** map: after unpoisoning", start, end);
 }
 
@@ -578,6 +596,13 @@ uw_recipe_map_notify_unmap(load_module_t* lm)
   void* end = lm->dso_info->end_addr;
   uw_recipe_map_report_and_dump("*** unmap: before poisoning", start, end);
 
+  bool pinned = uw_recipe_map_reader_enter();
+
+  // bump the unmap count before any recipe is retired. a reader that pins
+  // an epoch late enough to let the retired recipes be reclaimed is then
+  // guaranteed to see the new count and flush its hash table first.
+  atomic_fetch_add(&uw_recipe_map_unmaps, 1);
+
   // Remove intervals in the range [start, end) from the unwind interval tree.
   TMSG(UW_RECIPE_MAP, "uw_recipe_map_delete_range from %p to %p", start, end);
   unwinder_t uw;
@@ -588,6 +613,8 @@ uw_recipe_map_notify_unmap(load_module_t* lm)
   for (uw = 0; uw < NUM_UNWINDERS; uw++)
     uw_recipe_map_repoison((uintptr_t)start, (uintptr_t)end, uw);
 
+  uw_recipe_map_reader_exit(pinned);
+
   thread_data_t *td = hpcrun_get_thread_data();
 
   // we need to confirm that the hashtable is allocated. if we are
@@ -635,6 +662,8 @@ uw_recipe_map_init(void)
 #endif
   mcs_init(&GFL_lock);
   bitree_uwi_init(my_alloc);
+  ebr_init(&uw_recipe_map_ebr);
+  atomic_init(&uw_recipe_map_unmaps, 0);
 
   TMSG(UW_RECIPE_MAP, "init address-to-recipe map");
   ilmstat_btuwi_pair_t* lsentinel =
@@ -645,7 +674,8 @@ uw_recipe_map_init(void)
   for (uw = 0; uw < NUM_UNWINDERS; uw++)
     unwinder_to_cskiplist[uw] =
       cskl_new(lsentinel, rsentinel, SKIPLIST_HEIGHT,
-	       ilmstat_btuwi_pair_cmp, ilmstat_btuwi_pair_inrange, my_alloc);
+	       ilmstat_btuwi_pair_cmp, ilmstat_btuwi_pair_inrange,
+	       &uw_recipe_map_ebr, my_alloc);
 
   uw_recipe_map_notify_init();
 
@@ -655,6 +685,35 @@ uw_recipe_map_init(void)
 }
 
 
+bool
+uw_recipe_map_reader_enter(void)
+{
+  if (uw_recipe_map_reader == NULL)
+    uw_recipe_map_reader = ebr_record_new(&uw_recipe_map_ebr, my_alloc);
+
+  if (!ebr_enter(&uw_recipe_map_ebr, uw_recipe_map_reader))
+    return false;
+
+  // drop cached recipes that may belong to load modules unmapped since this
+  // thread's last sample; they stay valid only while that sample was pinned.
+  uint64_t unmaps = atomic_load_explicit(&uw_recipe_map_unmaps, memory_order_acquire);
+  if (unmaps != uw_hash_unmaps) {
+    thread_data_t *td = hpcrun_get_thread_data();
+    if (td->uw_hash_table) uw_hash_delete_range(td->uw_hash_table, NULL, (void *) UINTPTR_MAX);
+    uw_hash_unmaps = unmaps;
+  }
+
+  return true;
+}
+
+
+void
+uw_recipe_map_reader_exit(bool pinned)
+{
+  if (pinned) ebr_exit(uw_recipe_map_reader);
+}
+
+
 /*
  * just look, don't make any modifications, even to the hashtable
  */
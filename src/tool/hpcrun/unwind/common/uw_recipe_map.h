@@ -60,6 +60,24 @@ void
 uw_recipe_map_init(void);
 
 
+/*
+ * Bracket every use of the map, from the first lookup to the last use of
+ * the unwr_info it fills in. Lookups take no locks; recipes of unmapped
+ * load modules are freed only after every reader that might have seen
+ * them has exited.
+ *
+ * Entries nest: only the outermost enter returns true, and its value must
+ * be passed to the matching exit. Place the exit where a siglongjmp out of
+ * the unwinder lands, as hpcrun_sample_callpath does.
+ */
+bool
+uw_recipe_map_reader_enter(void);
+
+
+void
+uw_recipe_map_reader_exit(bool pinned);
+
+
 /*
  * if addr is found in range in the map, return true and
  *   *unwr_info is the ilmstat_btuwi_pair_t ( ([start, end), ldmod, status), btuwi ),
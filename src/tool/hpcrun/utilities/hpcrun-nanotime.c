@@ -50,14 +50,26 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <strings.h>
 #include <time.h>
 
+#include <sys/time.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
 //*****************************************************************************
 // local includes
 //*****************************************************************************
 
 #include "hpcrun-nanotime.h"
 
+#include <hpcrun/messages/messages.h>
+#include <lib/support-lean/timer.h>
+
 
 
 //*****************************************************************************
@@ -66,14 +78,54 @@
 
 #define NS_PER_SEC 1000000000
 
+// the trace clock converts time stamp counter ticks to nanoseconds as
+// (ticks * tsc_mult) >> TSC_SHIFT, relative to a (tsc, ns) anchor that
+// each thread takes from CLOCK_REALTIME and refreshes once a second.
+// bounding the ticks converted to one second keeps the product in
+// 64 bits.
+#define TSC_SHIFT                32
+#define TSC_CALIBRATION_NS       (10 * 1000 * 1000)   // 10ms
+#define TSC_RESYNC_NS            NS_PER_SEC
+
+
 
 //*****************************************************************************
+// type declarations
 //*****************************************************************************
-// interface operations
+
+typedef enum {
+  TRACE_CLOCK_GETTIMEOFDAY,   // microsecond resolution, the default
+  TRACE_CLOCK_REALTIME,       // CLOCK_REALTIME, nanosecond resolution
+  TRACE_CLOCK_TSC             // time stamp counter, see above
+} trace_clock_t;
+
+
+typedef struct tsc_anchor_s {
+  uint64_t tsc;
+  uint64_t ns;
+  uint64_t last;   // last time returned, to keep the clock monotonic
+} tsc_anchor_t;
+
+
+
+//*****************************************************************************
+// local variables
 //*****************************************************************************
 
-uint64_t
-hpcrun_nanotime()
+static trace_clock_t trace_clock = TRACE_CLOCK_GETTIMEOFDAY;
+static uint64_t tsc_mult = 0;
+static uint64_t tsc_resync_ticks = 0;
+
+static __thread tsc_anchor_t tsc_anchor;
+
+
+
+//*****************************************************************************
+// private operations
+//*****************************************************************************
+
+static uint64_t
+realtime_ns()
 {
   struct timespec now;
 
@@ -82,9 +134,165 @@ hpcrun_nanotime()
   assert(res == 0);
 
   uint64_t now_sec = now.tv_sec;
-  uint64_t now_ns = now_sec * NS_PER_SEC + now.tv_nsec;
+  return now_sec * NS_PER_SEC + now.tv_nsec;
+}
+
+
+static uint64_t
+gettimeofday_ns()
+{
+  struct timeval tv;
+
+  int ret = gettimeofday(&tv, NULL);
+
+  assert(ret == 0 && "in trace_append: gettimeofday failed!");
+
+  return ((uint64_t)tv.tv_usec + (((uint64_t)tv.tv_sec) * 1000000)) * 1000;
+}
+
+
+// read the counter on both sides of the clock to pair them closely
+static void
+tsc_anchor_set(tsc_anchor_t *anchor)
+{
+  uint64_t tsc0 = time_getTSC();
+  uint64_t ns = realtime_ns();
+  uint64_t tsc1 = time_getTSC();
+
+  anchor->tsc = tsc0 + (tsc1 - tsc0) / 2;
+  anchor->ns = ns;
+}
+
+
+// the counter is only usable as a clock if it ticks at a constant
+// rate, independent of frequency scaling and sleep states
+static bool
+tsc_is_invariant()
+{
+#if defined(__x86_64__)
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) {
+    return false;
+  }
+  return (edx & (1 << 8)) != 0;
+#elif defined(__powerpc64__)
+  return true;  // the time base
+#else
+  return false;
+#endif
+}
+
+
+static bool
+tsc_calibrate()
+{
+  tsc_anchor_t start, end;
+
+  tsc_anchor_set(&start);
+  hpcrun_nanosleep(TSC_CALIBRATION_NS);
+  tsc_anchor_set(&end);
+
+  uint64_t ticks = end.tsc - start.tsc;
+  uint64_t ns = end.ns - start.ns;
+  if (end.tsc <= start.tsc || end.ns <= start.ns) {
+    return false;
+  }
+
+  tsc_mult = (ns << TSC_SHIFT) / ticks;
+  if (tsc_mult == 0) {
+    return false;
+  }
+  tsc_resync_ticks = ((uint64_t) TSC_RESYNC_NS << TSC_SHIFT) / tsc_mult;
+
+  TMSG(TRACE, "trace clock: %lu ticks in %lu ns, mult = %lu, resync every %lu ticks",
+       ticks, ns, tsc_mult, tsc_resync_ticks);
+  return true;
+}
+
+
+//*****************************************************************************
+//*****************************************************************************
+// interface operations
+//*****************************************************************************
+
+uint64_t
+hpcrun_nanotime()
+{
+  return realtime_ns();
+}
+
+
+//-----------------------------------------------------------------------------
+// the trace clock: gettimeofday by default. HPCRUN_TRACE_CLOCK=realtime
+// selects CLOCK_REALTIME for nanosecond resolution, and
+// HPCRUN_TRACE_CLOCK=tsc nanoseconds extrapolated from the time stamp
+// counter, calibrated once against CLOCK_REALTIME. every clock is
+// recorded in nanoseconds since the epoch, so trace files are unchanged.
+//-----------------------------------------------------------------------------
+
+void
+hpcrun_trace_clock_init()
+{
+  const char *clock = getenv("HPCRUN_TRACE_CLOCK");
+  if (clock == NULL || strcasecmp(clock, "gettimeofday") == 0) {
+    return;
+  }
+
+  if (strcasecmp(clock, "realtime") == 0) {
+    trace_clock = TRACE_CLOCK_REALTIME;
+    return;
+  }
+
+  if (strcasecmp(clock, "tsc") != 0) {
+    EMSG("WARNING: unknown HPCRUN_TRACE_CLOCK '%s', using gettimeofday",
+         clock);
+    return;
+  }
+
+  if (!tsc_is_invariant()) {
+    EMSG("WARNING: HPCRUN_TRACE_CLOCK=tsc requires an invariant time stamp "
+         "counter, using gettimeofday");
+    return;
+  }
+
+  if (!tsc_calibrate()) {
+    EMSG("WARNING: unable to calibrate the time stamp counter, "
+         "using gettimeofday");
+    return;
+  }
+
+  trace_clock = TRACE_CLOCK_TSC;
+}
+
+
+uint64_t
+hpcrun_trace_nanotime()
+{
+  if (trace_clock == TRACE_CLOCK_GETTIMEOFDAY) {
+    return gettimeofday_ns();
+  }
+  if (trace_clock == TRACE_CLOCK_REALTIME) {
+    return realtime_ns();
+  }
+
+  tsc_anchor_t *anchor = &tsc_anchor;
+  uint64_t ticks = time_getTSC() - anchor->tsc;
+
+  if (anchor->ns == 0 || ticks >= tsc_resync_ticks) {
+    tsc_anchor_set(anchor);
+    ticks = 0;
+  }
+
+  uint64_t now = anchor->ns + ((ticks * tsc_mult) >> TSC_SHIFT);
+
+  // a resync may step the clock back by the drift accumulated since the
+  // previous one; never let a thread's time stamps decrease
+  if (now < anchor->last) {
+    now = anchor->last;
+  }
+  anchor->last = now;
 
-  return now_ns;
+  return now;
 }
 
 
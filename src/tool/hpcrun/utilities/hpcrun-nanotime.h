@@ -71,4 +71,18 @@ hpcrun_nanosleep
   uint32_t nsec
 );
 
+// select the clock used for trace time stamps (HPCRUN_TRACE_CLOCK)
+void
+hpcrun_trace_clock_init
+(
+  void
+);
+
+// time stamp for a trace record, in nanoseconds
+uint64_t
+hpcrun_trace_nanotime
+(
+  void
+);
+
 #endif
@@ -71,6 +71,7 @@ using std::string;
 #include <include/hpctoolkit-config.h>
 
 #include "Args.hpp"
+#include "Constants.hpp"
 
 #include <lib/analysis/Util.hpp>
 
@@ -111,7 +112,13 @@ Options: General\n\
   -V, --version        Print version information.\n\
   -h, --help           Print this help.\n\
   -c, --compression    Enables or disables compression (on by default)\n\
-                       Allowed values: on off \n\
+                       Allowed values: on off packed\n\
+                           'packed' sends timelines as varints before\n\
+                           compressing them. Clients that do not announce\n\
+                           support for it get 'on' instead.\n\
+  --compression-level <n>\n\
+                       zlib level (0-9) used for timelines (default is 6).\n\
+                           1 is the fastest, at the cost of larger replies.\n\
   -p, --port           Sets the main communication port (default is 21590)\n\
                            Specifying 0 indicates that an open port should be \n\
                            chosen automatically.\n\
@@ -120,6 +127,17 @@ Options: General\n\
                            indicates that the port will be auto-negotiated with\n\
                            the client. Specifying 1 indicates that the xml will\n\
                            be transferred on the main data port.\n\
+  -j, --jobs <num>     Use <num> threads to compute the timelines of a data\n\
+                           request (default is 1). Ignored in the MPI version.\n\
+  -C, --cache <MB>     Keeps up to <MB> megabytes of computed timelines to\n\
+                           answer repeated requests (default is 256).\n\
+                           Specifying 0 disables the cache.\n\
+  --pyramid            Serves zoomed-out timelines from a level-of-detail\n\
+                           pyramid (experiment.mt.lod) built when the trace\n\
+                           is merged. Faster for large traces, but a pixel\n\
+                           shows the record nearest the start of a pyramid\n\
+                           bucket rather than of the pixel, so the timeline\n\
+                           can differ slightly from one read directly.\n\
 \n\
 ";
 
@@ -144,11 +162,19 @@ CmdLineParser::OptArgDesc Args::optArgs[] = {
   { 'h', "help",        CLP::ARG_NONE, CLP::DUPOPT_CLOB, NULL,
      NULL },
   {  'c' , "compression",       CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
+     NULL },
+  {  0 , "compression-level",   CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
      CLP::isOptArg_long },
   {  'p' , "port",       CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
      CLP::isOptArg_long },
   {  'x' , "xmlport",       CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
      CLP::isOptArg_long },
+  {  'j' , "jobs",          CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
+     CLP::isOptArg_long },
+  {  'C' , "cache",         CLP::ARG_REQ,  CLP::DUPOPT_CLOB, NULL,
+     CLP::isOptArg_long },
+  {  0 , "pyramid",         CLP::ARG_NONE, CLP::DUPOPT_CLOB, NULL,
+     NULL },
   CmdLineParser_OptArgDesc_NULL_MACRO // SGI's compiler requires this version
 };
 
@@ -175,9 +201,13 @@ Args::Args(int argc, const char* const argv[])
 void
 Args::Ctor()
 {
-  compression = true;
+  compressionType = TraceviewerServer::COMPRESSION_DEFLATE;
+  compressionLevel = 6;
   mainPort = DEFAULT_PORT;//21590
   xmlPort = 0;
+  jobs = 1;
+  cacheSize = 256;
+  pyramid = false;
 }
 
 
@@ -256,7 +286,18 @@ Args::parse(int argc, const char* const argv[])
     // Check for other options: Communication options
     if (parser.isOpt("compression")) {
       const string& arg = parser.getOptArg("compression");
-      compression = CmdLineParser::parseArg_bool(arg, "--compression option");
+      if (arg == "packed")
+        compressionType = TraceviewerServer::COMPRESSION_PACKED;
+      else if (CmdLineParser::parseArg_bool(arg, "--compression option"))
+        compressionType = TraceviewerServer::COMPRESSION_DEFLATE;
+      else
+        compressionType = TraceviewerServer::COMPRESSION_NONE;
+    }
+    if (parser.isOpt("compression-level")) {
+      const string& arg = parser.getOptArg("compression-level");
+      compressionLevel = (int) CmdLineParser::toLong(arg);
+      if (compressionLevel < 0 || compressionLevel > 9)
+         	  ARG_ERROR("The compression level must be between 0 and 9.")
     }
     if (parser.isOpt("port")) {
       const string& arg = parser.getOptArg("port");
@@ -270,6 +311,21 @@ Args::parse(int argc, const char* const argv[])
       if (xmlPort < 1024 && xmlPort > 1)
     	   ARG_ERROR("Ports must be greater than 1024.")
     }
+    if (parser.isOpt("jobs")) {
+      const string& arg = parser.getOptArg("jobs");
+      jobs = (int) CmdLineParser::toLong(arg);
+      if (jobs < 1)
+         	  ARG_ERROR("The number of jobs must be at least 1.")
+    }
+    if (parser.isOpt("cache")) {
+      const string& arg = parser.getOptArg("cache");
+      cacheSize = (int) CmdLineParser::toLong(arg);
+      if (cacheSize < 0)
+         	  ARG_ERROR("The cache size cannot be negative.")
+    }
+    if (parser.isOpt("pyramid")) {
+      pyramid = true;
+    }
   }
   catch (const CmdLineParser::ParseError& x) {
     ARG_ERROR(x.what());
@@ -112,7 +112,11 @@ public:
   // Parsed Data: optional arguments
   int mainPort;       // default: 21590
   int xmlPort;        // default: 0
-  bool compression;   // default: true
+  int compressionType;   // default: COMPRESSION_DEFLATE
+  int compressionLevel;  // default: 6
+  int jobs;           // default: 1
+  int cacheSize;      // in MB, default: 256
+  bool pyramid;       // default: false
 
 private:
   void
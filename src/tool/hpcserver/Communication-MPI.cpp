@@ -65,11 +65,13 @@
 #include "DebugUtils.hpp"
 #include "Server.hpp"
 #include "Slave.hpp"
+#include "TraceStatistics.hpp"
 
 #include <mpi.h>
 
 #include <iostream> //For cerr, cout
 #include <algorithm> //For copy
+#include <vector>
 
 using namespace std;
 using namespace MPI;
@@ -99,6 +101,7 @@ void Communication::sendParseOpenDB(string pathToDB)
 	}
 	copy(pathToDB.begin(), pathToDB.end(), cmdPathToDB.ofile.path);
 	cmdPathToDB.ofile.path[pathToDB.size()] = '\0';
+	cmdPathToDB.ofile.compressionType = compressionType;
 
 	COMM_WORLD.Bcast(&cmdPathToDB, sizeof(cmdPathToDB), MPI_PACKED,
 			MPICommunication::SOCKET_SERVER);
@@ -118,7 +121,8 @@ void Communication::sendStartGetData(SpaceTimeDataController* contr, int process
 	COMM_WORLD.Bcast(&toBcast, sizeof(toBcast), MPI_PACKED,
 		MPICommunication::SOCKET_SERVER);
 }
-void Communication::sendEndGetData(DataSocketStream* stream, ProgressBar* prog, SpaceTimeDataController* controller)
+void Communication::sendEndGetData(DataSocketStream* stream, ProgressBar* prog, SpaceTimeDataController* controller,
+		RequestReader* reader)
 {
 	int ranksDone = 1;//1 for the MPI rank that deals with the sockets
 	int size = COMM_WORLD.Get_size();
@@ -168,6 +172,45 @@ void Communication::sendEndGetData(DataSocketStream* stream, ProgressBar* prog,
 	}
 	LOGTIMESTAMPEDMSG("All data done.")
 }
+void Communication::sendStartGetStatistics(SpaceTimeDataController* contr, int processStart, int processEnd,
+			Time timeStart, Time timeEnd, int verticalResolution, int horizontalResolution)
+{
+	//The socket server computes no lines, but needs the window to merge the
+	//statistics of the slaves
+	contr->attributes->begTime = timeStart;
+	contr->attributes->endTime = timeEnd;
+	contr->attributes->numPixelsH = horizontalResolution;
+
+	MPICommunication::CommandMessage toBcast;
+	toBcast.command = STAT;
+	toBcast.gdata.processStart = processStart;
+	toBcast.gdata.processEnd = processEnd;
+	toBcast.gdata.timeStart = timeStart;
+	toBcast.gdata.timeEnd = timeEnd;
+	toBcast.gdata.verticalResolution = verticalResolution;
+	toBcast.gdata.horizontalResolution = horizontalResolution;
+	COMM_WORLD.Bcast(&toBcast, sizeof(toBcast), MPI_PACKED,
+		MPICommunication::SOCKET_SERVER);
+}
+void Communication::sendEndGetStatistics(DataSocketStream* stream, ProgressBar* prog,
+		SpaceTimeDataController* controller)
+{
+	ImageTraceAttributes* attributes = controller->attributes;
+	TraceStatistics statistics(controller->getMinBegTime() + attributes->begTime,
+			controller->getMinBegTime() + attributes->endTime, attributes->numPixelsH);
+
+	int size = COMM_WORLD.Get_size();
+	for (int ranksDone = 1; ranksDone < size; ranksDone++)
+	{
+		MPICommunication::ResultMessage msg;
+		COMM_WORLD.Recv(&msg, sizeof(msg), MPI_PACKED, MPI_ANY_SOURCE, MPI_ANY_TAG);
+		vector<char> buffer(msg.stats.size);
+		COMM_WORLD.Recv(&buffer[0], msg.stats.size, MPI_BYTE, msg.stats.rankID, MPI_ANY_TAG);
+		statistics.unpack(&buffer[0], msg.stats.size);
+		prog->incrementProgress(msg.stats.lines);
+	}
+	statistics.write(stream);
+}
 void Communication::sendStartFilter(int count, bool excludeMatches)
 {
 	MPICommunication::CommandMessage toBcast;
@@ -183,6 +226,15 @@ void Communication::sendFilter(BinaryRepresentationOfFilter filt)
 	COMM_WORLD.Bcast(&filt, sizeof(filt), MPI_PACKED, MPICommunication::SOCKET_SERVER);
 }
 
+void Communication::sendDepth(int depth)
+{
+	MPICommunication::CommandMessage toBcast;
+	toBcast.command = DPTH;
+	toBcast.depth.depth = depth;
+	COMM_WORLD.Bcast(&toBcast, sizeof(toBcast), MPI_PACKED,
+				MPICommunication::SOCKET_SERVER);
+}
+
 bool Communication::basicInit(int argc, char** argv)
 {
 	MPI::Init(argc, argv);
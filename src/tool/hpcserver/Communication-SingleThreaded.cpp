@@ -62,7 +62,9 @@
 #include <string>                       // for string
 #include <vector>                       // for vector, vector<>::iterator
 
+#include "ByteUtilities.hpp"            // for ByteUtilities
 #include "Communication.hpp"            // for Communication
+#include "Constants.hpp"                // for CompressionType, SIZEOF_DELTASAMPLE
 #include "DataCompressionLayer.hpp"     // for DataCompressionLayer
 #include "DataSocketStream.hpp"         // for DataSocketStream
 #include "DebugUtils.hpp"               // for DEBUGCOUT
@@ -74,11 +76,76 @@
 #include "SpaceTimeDataController.hpp"  // for SpaceTimeDataController
 #include "TimeCPID.hpp"                 // for TimeCPID, Time
 #include "TraceDataByRank.hpp"          // for TraceDataByRank
+#include "TraceStatistics.hpp"          // for TraceStatistics
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 using namespace std;
 namespace TraceviewerServer {
 
+//A row ready to be written to the socket
+struct EncodedTimeline
+{
+	int line;
+	int entries;
+	Time begTime;
+	Time endTime;
+	vector<char> compressed;
+};
+
+//Compresses a row. Workers do this concurrently; only the writing is in order.
+static void encodeTimeline(int line, vector<TimeCPID>& data, EncodedTimeline* out)
+{
+	out->line = line;
+	out->entries = data.size();
+	// Begin time
+	out->begTime = data[0].timestamp;
+	//End time
+	out->endTime = data[data.size() - 1].timestamp;
+
+	DEBUGCOUT(2) << "Sending process timeline with " << data.size() << " entries" << endl;
+
+	if (compressionType == COMPRESSION_NONE)
+	{
+		out->compressed.resize(data.size() * SIZEOF_DELTASAMPLE);
+		char* currentPtr = &out->compressed[0];
+		Time currentTime = data[0].timestamp;
+		vector<TimeCPID>::iterator it;
+		for (it = data.begin(); it != data.end(); ++it)
+		{
+			ByteUtilities::writeInt(currentPtr, (int)(it->timestamp - currentTime));
+			currentPtr += SIZEOF_INT;
+			ByteUtilities::writeInt(currentPtr, it->cpid);
+			currentPtr += SIZEOF_INT;
+			currentTime = it->timestamp;
+		}
+		return;
+	}
+
+	DataCompressionLayer comprStr(compressionLevel, false, NULL);
+	comprStr.writeSamples(data, compressionType == COMPRESSION_PACKED);
+	comprStr.flush();
+	char* outputBuffer = (char*)comprStr.getOutputBuffer();
+	out->compressed.assign(outputBuffer, outputBuffer + comprStr.getOutputLength());
+}
+
+static void sendTimeline(DataSocketStream* stream, EncodedTimeline* timeline)
+{
+	stream->writeInt( timeline->line);
+	stream->writeInt( timeline->entries);
+	stream->writeLong( timeline->begTime);
+	stream->writeLong( timeline->endTime);
+
+	int outputBufferLen = timeline->compressed.size();
+	stream->writeInt(outputBufferLen);
+	stream->writeRawData(&timeline->compressed[0], outputBufferLen);
+	//Get every row to the client as soon as it is done
+	stream->flush();
+}
+
 void Communication::sendParseInfo(uint64_t minBegTime, uint64_t maxEndTime, int headerSize)
 {//Do nothing
 }
@@ -101,47 +168,97 @@ void Communication::sendStartGetData(SpaceTimeDataController* contr, int process
 
 
 }
-void Communication::sendEndGetData(DataSocketStream* stream, ProgressBar* prog, SpaceTimeDataController* controller)
+void Communication::sendEndGetData(DataSocketStream* stream, ProgressBar* prog, SpaceTimeDataController* controller,
+		RequestReader* reader)
 {
-	// TODO: Make this so that the Lines get sent as soon as they are
-	// filled.
+	int numWorkers = controller->getNumWorkers();
+	int numTraces = controller->prepareTraces();
+
+	// Once the client has sent a newer request, the rest of this one is
+	// answered with placeholder rows of a single sample, which costs nothing
+	// to compute but keeps the stream in step with what the client expects.
+	bool cancelled = false;
+	Time cancelledTime = controller->getMinBegTime() + controller->attributes->begTime;
+	vector<TimeCPID> placeholder(1, TimeCPID(cancelledTime, 0));
 
-	controller->fillTraces();
-	for (int i = 0; i < controller->tracesLength; i++)
+	// Each worker computes lines with its own page window. A line is sent as
+	// soon as it and all the lines before it are done, so the client still
+	// receives them in order.
+#pragma omp parallel for ordered schedule(dynamic, 1) num_threads(numWorkers)
+	for (int i = 0; i < numTraces; i++)
 	{
+		int worker = 0;
+#ifdef _OPENMP
+		worker = omp_get_thread_num();
+#endif
+		bool skip;
+#pragma omp atomic read
+		skip = cancelled;
 
-		ProcessTimeline* timeline = controller->traces[i];
-		stream->writeInt( timeline->line());
-		vector<TimeCPID> data = *timeline->data->listCPID;
-		stream->writeInt( data.size());
-		// Begin time
-		stream->writeLong( data[0].timestamp);
-		//End time
-		stream->writeLong( data[data.size() - 1].timestamp);
+		EncodedTimeline row;
+		if (skip)
+			encodeTimeline(i, placeholder, &row);
+		else
+		{
+			vector<TimeCPID>* data = controller->fillTrace(i, worker)->data->listCPID;
+			controller->collapseToDepth(data);
+			encodeTimeline(i, *data, &row);
+		}
+#pragma omp ordered
+		{
+			sendTimeline(stream, &row);
+			prog->incrementProgress();
+			if (!skip && reader->isSuperseded())
+			{
+				DEBUGCOUT(1) << "Data request superseded after " << i + 1 << " lines" << endl;
+#pragma omp atomic write
+				cancelled = true;
+			}
+		}
+	}
+	stream->flush();
+}
 
-		DataCompressionLayer comprStr;
+void Communication::sendStartGetStatistics(SpaceTimeDataController* contr, int processStart, int processEnd,
+			Time timeStart, Time timeEnd, int verticalResolution, int horizontalResolution)
+{
+	sendStartGetData(contr, processStart, processEnd, timeStart, timeEnd, verticalResolution,
+			horizontalResolution);
+}
 
-		vector<TimeCPID>::iterator it;
-		DEBUGCOUT(2) << "Sending process timeline with " << data.size() << " entries" << endl;
+void Communication::sendEndGetStatistics(DataSocketStream* stream, ProgressBar* prog,
+		SpaceTimeDataController* controller)
+{
+	int numWorkers = controller->getNumWorkers();
+	int numTraces = controller->prepareTraces();
 
+	ImageTraceAttributes* attributes = controller->attributes;
+	Time begTime = controller->getMinBegTime() + attributes->begTime;
+	Time endTime = controller->getMinBegTime() + attributes->endTime;
+	TraceStatistics statistics(begTime, endTime, attributes->numPixelsH);
 
-		Time currentTime = data[0].timestamp;
-		for (it = data.begin(); it != data.end(); ++it)
+	// Every worker summarizes the lines it computes and the summaries are
+	// merged at the end, so the workers never wait on each other.
+#pragma omp parallel num_threads(numWorkers)
+	{
+		int worker = 0;
+#ifdef _OPENMP
+		worker = omp_get_thread_num();
+#endif
+		TraceStatistics local(begTime, endTime, attributes->numPixelsH);
+#pragma omp for schedule(dynamic, 1)
+		for (int i = 0; i < numTraces; i++)
 		{
-			comprStr.writeInt( (int)(it->timestamp - currentTime));
-			comprStr.writeInt( it->cpid);
-			currentTime = it->timestamp;
+			vector<TimeCPID>* data = controller->fillTrace(i, worker)->data->listCPID;
+			controller->collapseToDepth(data);
+			local.add(*data);
+#pragma omp critical (statisticsProgress)
+			prog->incrementProgress();
 		}
-		comprStr.flush();
-		int outputBufferLen = comprStr.getOutputLength();
-		char* outputBuffer = (char*)comprStr.getOutputBuffer();
-
-		stream->writeInt(outputBufferLen);
-
-		stream->writeRawData(outputBuffer, outputBufferLen);
-		prog->incrementProgress();
+#pragma omp critical (statisticsMerge)
+		statistics.merge(local);
 	}
-	stream->flush();
+	statistics.write(stream);
 }
 
 void Communication::sendStartFilter(int count, bool excludeMatches)
@@ -152,6 +269,10 @@ void Communication::sendFilter(BinaryRepresentationOfFilter filt)
 {
 }
 
+void Communication::sendDepth(int depth)
+{//Do nothing
+}
+
 bool Communication::basicInit(int argc, char** argv)
 {
 	return true;
@@ -67,6 +67,7 @@
 #include "ProgressBar.hpp"
 #include "SpaceTimeDataController.hpp"
 #include "DataSocketStream.hpp"
+#include "RequestReader.hpp"
 #include "Filter.hpp"
 
 namespace TraceviewerServer
@@ -84,9 +85,15 @@ public:
 	static void sendParseOpenDB(string pathToDB);
 	static void sendStartGetData(SpaceTimeDataController* contr, int processStart, int processEnd,
 			Time timeStart, Time timeEnd, int verticalResolution, int horizontalResolution);
-	static void sendEndGetData(DataSocketStream* stream, ProgressBar* prog, SpaceTimeDataController* controller);
+	//Stops computing rows once reader has a request that supersedes this one
+	static void sendEndGetData(DataSocketStream* stream, ProgressBar* prog, SpaceTimeDataController* controller,
+			RequestReader* reader);
+	static void sendStartGetStatistics(SpaceTimeDataController* contr, int processStart, int processEnd,
+			Time timeStart, Time timeEnd, int verticalResolution, int horizontalResolution);
+	static void sendEndGetStatistics(DataSocketStream* stream, ProgressBar* prog, SpaceTimeDataController* controller);
 	static void sendStartFilter(int count, bool excludeMatches);
 	static void sendFilter(BinaryRepresentationOfFilter filt);
+	static void sendDepth(int depth);
 
 	static bool basicInit(int argc, char** argv);
 	static void run();
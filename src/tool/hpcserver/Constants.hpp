@@ -92,8 +92,21 @@ enum Header {
 	NODB = 0x4E4F4442,
 	EXML = 0x45584D4C,
 	FLTR = 0x464C5452,
+	STAT = 0x53544154,
+	DPTH = 0x44505448,
 	SLAVE_REPLY = 0x534C5250,
-	SLAVE_DONE = 0x534C444E
+	SLAVE_DONE = 0x534C444E,
+	SLAVE_STATS = 0x534C5354
+};
+
+//Announced to the client in DBOK. Clients written before COMPRESSION_PACKED
+//only know the first two, so the server sends it only when asked to with
+//--compression packed and the client's protocol version says it can read it.
+enum CompressionType {
+	COMPRESSION_NONE = 0,
+	COMPRESSION_DEFLATE = 1,
+	//Deflate over varint-encoded (delta timestamp, cpid) pairs
+	COMPRESSION_PACKED = 2
 };
 
 enum ServerNextAction {
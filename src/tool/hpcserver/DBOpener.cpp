@@ -69,6 +69,7 @@ namespace TraceviewerServer
 {
 	#define XML_FILENAME "experiment.xml"
 	#define TRACE_FILENAME "experiment.mt"
+	#define DEPTH_FILENAME "experiment.depth"
 
 	DBOpener::DBOpener()
 	{
@@ -122,6 +123,7 @@ namespace TraceviewerServer
 			DEBUGCOUT(2) << "\tExists and is a directory"<<endl;
 
 			location->fileXML = FileUtils::combinePaths(directory, XML_FILENAME);
+			location->fileDepth = FileUtils::combinePaths(directory, DEPTH_FILENAME);
 
 			DEBUGCOUT(2) << "\tTrying to open "<<location->fileXML<<endl;
 
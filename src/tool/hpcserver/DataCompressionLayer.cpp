@@ -71,6 +71,19 @@ namespace TraceviewerServer
 {
 
 	DataCompressionLayer::DataCompressionLayer()
+	{
+		progMonitor = NULL;
+		init(Z_DEFAULT_COMPRESSION, 15);
+	}
+
+	DataCompressionLayer::DataCompressionLayer(int level, bool gzip, ProgressBar* _progMonitor)
+	{
+		progMonitor = _progMonitor;
+		//Adding 16 to the window bits makes zlib write a gzip header
+		init(level, gzip ? 16 + 15 : 15);
+	}
+
+	void DataCompressionLayer::init(int level, int windowBits)
 	{
 
 		//See: http://www.zlib.net/zpipe.c
@@ -82,30 +95,17 @@ namespace TraceviewerServer
 		outBuf = new unsigned char[BUFFER_SIZE];
 		outBufferCurrentSize = BUFFER_SIZE;
 
-		progMonitor = NULL;
-
+		//The stream has to be initialized in place. zlib keeps a pointer back
+		//to it and rejects a copy.
 		compressor.zalloc = Z_NULL;
 		compressor.zfree = Z_NULL;
 		compressor.opaque = Z_NULL;
-		int ret = deflateInit(&compressor, -1);
+		int ret = deflateInit2(&compressor, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
 		if (ret != Z_OK)
 			throw ret;
 
 	}
 
-	DataCompressionLayer::DataCompressionLayer(z_stream customCompressor, ProgressBar* _progMonitor)
-	{
-		bufferIndex = 0;
-		posInCompBuffer = 0;
-
-		inBuf = new char[BUFFER_SIZE];
-		outBuf = new unsigned char[BUFFER_SIZE];
-		outBufferCurrentSize = BUFFER_SIZE;
-
-		progMonitor = _progMonitor;
-		compressor = customCompressor;
-	}
-
 	void DataCompressionLayer::writeInt(int toWrite)
 	{
 		makeRoom(4);
@@ -127,6 +127,42 @@ namespace TraceviewerServer
 		bufferIndex += 8;
 		pInc(8);
 	}
+	void DataCompressionLayer::writeVarInt(int toWrite)
+	{
+		//Five bytes are enough for any 32-bit value
+		makeRoom(5);
+		uint32_t zigzag = ((uint32_t)toWrite << 1) ^ (uint32_t)(toWrite >> 31);
+		int start = bufferIndex;
+		while (zigzag >= 0x80)
+		{
+			inBuf[bufferIndex++] = (char)(zigzag | 0x80);
+			zigzag >>= 7;
+		}
+		inBuf[bufferIndex++] = (char)zigzag;
+		pInc(bufferIndex - start);
+	}
+	void DataCompressionLayer::writeSamples(const vector<TimeCPID>& samples, bool packed)
+	{
+		if (samples.empty())
+			return;
+		Time currentTime = samples[0].timestamp;
+		vector<TimeCPID>::const_iterator it;
+		for (it = samples.begin(); it != samples.end(); ++it)
+		{
+			int delta = (int)(it->timestamp - currentTime);
+			if (packed)
+			{
+				writeVarInt(delta);
+				writeVarInt(it->cpid);
+			}
+			else
+			{
+				writeInt(delta);
+				writeInt(it->cpid);
+			}
+			currentTime = it->timestamp;
+		}
+	}
 	void DataCompressionLayer::writeFile(FILE* toWrite)
 	{
 		while (!feof(toWrite))
@@ -59,8 +59,10 @@
 #include "zlib.h"
 #include <stdint.h>
 #include <cstdio>
+#include <vector>
 
 #include "ProgressBar.hpp"
+#include "TimeCPID.hpp"
 /*
  * CompressingDataSocketLayer.h
  *
@@ -79,19 +81,27 @@ namespace TraceviewerServer
 	{
 	public:
 		DataCompressionLayer();
-		//Advanced constructor:
-		DataCompressionLayer(z_stream customCompressor, ProgressBar* progMonitor);
+		//Advanced constructor: level is the zlib compression level, and a gzip
+		//header is written instead of a zlib one if gzip is true
+		DataCompressionLayer(int level, bool gzip, ProgressBar* progMonitor);
 
 		virtual ~DataCompressionLayer();
 		void writeInt(int);
 		void writeLong(uint64_t);
 		void writeDouble(double);
+		//Zigzag-encoded LEB128: 7 bits per byte, low bits first, high bit set
+		//on every byte but the last
+		void writeVarInt(int);
+		//Writes a timeline as (delta timestamp, cpid) pairs, either as plain
+		//ints or, for COMPRESSION_PACKED, as varints
+		void writeSamples(const std::vector<TimeCPID>& samples, bool packed);
 		void writeFile(FILE*);
 		void flush();
 		unsigned char* getOutputBuffer();
 		int getOutputLength();
 
 	private:
+		void init(int level, int windowBits);
 		//Checks to make sure there is enough room in the buffer for count
 		//bytes. If there is not, it makes room by flushing the buffer.
 		void makeRoom(int count);
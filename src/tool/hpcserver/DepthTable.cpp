@@ -0,0 +1,191 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL: https://hpctoolkit.googlecode.com/svn/branches/hpctoolkit-hpcserver/src/tool/hpcserver/DepthTable.cpp $
+// $Id: DepthTable.cpp 4307 2013-07-18 17:04:52Z felipet1326@gmail.com $
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Maps sampled call paths to their procedure frame at a given depth.
+//
+// Description:
+//   The table is small (one entry per frame and per call path), so it is
+//   read whole. setDepth runs once per change of depth on the server
+//   thread, and collapse only reads, so workers can share the table.
+//
+//***************************************************************************
+
+#include "DepthTable.hpp"
+#include "ByteUtilities.hpp"
+#include "Constants.hpp"
+#include "DebugUtils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <utility>
+
+using namespace std;
+
+namespace TraceviewerServer
+{
+	static bool readInt(FILE* file, int* value)
+	{
+		char buffer[SIZEOF_INT];
+		if (fread(buffer, 1, SIZEOF_INT, file) != SIZEOF_INT)
+			return false;
+		*value = ByteUtilities::readInt(buffer);
+		return true;
+	}
+
+	DepthTable::DepthTable()
+	{
+	}
+
+	DepthTable::~DepthTable()
+	{
+	}
+
+	DepthTable* DepthTable::open(string file)
+	{
+		FILE* in = fopen(file.c_str(), "rb");
+		if (in == NULL)
+			return NULL;
+
+		DepthTable* table = new DepthTable();
+		map<int, int> indexOf;
+		bool ok = true;
+
+		int numFrames = 0;
+		ok = readInt(in, &numFrames) && numFrames >= 0;
+		for (int i = 0; ok && i < numFrames; i++)
+		{
+			int id, parent, depth;
+			ok = readInt(in, &id) && readInt(in, &parent) && readInt(in, &depth);
+			if (!ok)
+				break;
+			//Parents come before their children
+			map<int, int>::iterator p = indexOf.find(parent);
+			table->frameIds.push_back(id);
+			table->parents.push_back((depth > 0 && p != indexOf.end()) ? p->second : -1);
+			table->depths.push_back(depth);
+			indexOf[id] = i;
+		}
+
+		int numCpids = 0;
+		ok = ok && readInt(in, &numCpids) && numCpids >= 0;
+		vector<pair<int, int> > leaves;
+		for (int i = 0; ok && i < numCpids; i++)
+		{
+			int cpid, frame;
+			ok = readInt(in, &cpid) && readInt(in, &frame);
+			map<int, int>::iterator f = indexOf.find(frame);
+			if (ok && f != indexOf.end())
+				leaves.push_back(make_pair(cpid, f->second));
+		}
+		fclose(in);
+
+		if (!ok)
+		{
+			cerr << "Could not read the depth table " << file << endl;
+			delete table;
+			return NULL;
+		}
+
+		sort(leaves.begin(), leaves.end());
+		for (size_t i = 0; i < leaves.size(); i++)
+		{
+			table->cpids.push_back(leaves[i].first);
+			table->leafFrames.push_back(leaves[i].second);
+		}
+		DEBUGCOUT(1) << "Depth table has " << numFrames << " frames and " << leaves.size()
+				<< " call paths" << endl;
+		return table;
+	}
+
+	void DepthTable::setDepth(int depth)
+	{
+		framesAtDepth.resize(cpids.size());
+		for (size_t i = 0; i < cpids.size(); i++)
+		{
+			int frame = leafFrames[i];
+			while (depths[frame] > depth && parents[frame] >= 0)
+				frame = parents[frame];
+			framesAtDepth[i] = frameIds[frame];
+		}
+	}
+
+	int DepthTable::frameOf(int cpid) const
+	{
+		vector<int>::const_iterator it = lower_bound(cpids.begin(), cpids.end(), cpid);
+		if (it == cpids.end() || *it != cpid)
+			return 0;
+		return framesAtDepth[it - cpids.begin()];
+	}
+
+	void DepthTable::collapse(vector<TimeCPID>* samples) const
+	{
+		size_t kept = 0;
+		int lastCpid = 0;
+		int lastFrame = 0;
+		for (size_t i = 0; i < samples->size(); i++)
+		{
+			TimeCPID sample = (*samples)[i];
+			//Runs of one call path are common, so skip the search for them
+			int frame = (i > 0 && sample.cpid == lastCpid) ? lastFrame : frameOf(sample.cpid);
+			lastCpid = sample.cpid;
+			bool last = (i + 1 == samples->size());
+			if (kept > 0 && frame == lastFrame && !last)
+				continue;
+			lastFrame = frame;
+			sample.cpid = frame;
+			(*samples)[kept++] = sample;
+		}
+		samples->erase(samples->begin() + kept, samples->end());
+	}
+
+} /* namespace TraceviewerServer */
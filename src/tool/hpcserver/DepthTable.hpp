@@ -0,0 +1,107 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL: https://hpctoolkit.googlecode.com/svn/branches/hpctoolkit-hpcserver/src/tool/hpcserver/DepthTable.hpp $
+// $Id: DepthTable.hpp 4307 2013-07-18 17:04:52Z felipet1326@gmail.com $
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Maps sampled call paths to their procedure frame at a given depth.
+//
+// Description:
+//   hpcprof writes experiment.depth next to experiment.xml: the parent and
+//   depth of every procedure frame, and the innermost frame of every call
+//   path a trace can contain. Once the client has chosen a depth, the rows
+//   are sent with frame ids in place of cpids, and consecutive samples that
+//   show the same frame are sent once.
+//
+//***************************************************************************
+
+#ifndef DEPTHTABLE_HPP_
+#define DEPTHTABLE_HPP_
+
+#include <string>
+#include <vector>
+
+#include "TimeCPID.hpp"
+
+using std::string;
+using std::vector;
+
+namespace TraceviewerServer
+{
+	class DepthTable
+	{
+	public:
+		//Returns NULL if the file does not exist or cannot be read
+		static DepthTable* open(string file);
+		virtual ~DepthTable();
+
+		//Works out the frame at depth for every call path. Frames shallower
+		//than depth stand for themselves.
+		void setDepth(int depth);
+		//Replaces the cpids by their frames at the current depth (0 if the
+		//cpid is not in the table) and drops every sample but the last that
+		//shows the same frame as the one before it
+		void collapse(vector<TimeCPID>* samples) const;
+	private:
+		DepthTable();
+		int frameOf(int cpid) const;
+
+		//Frames in pre-order
+		vector<int> frameIds;
+		vector<int> parents;//Index of the parent frame, -1 at depth 0
+		vector<int> depths;
+
+		//Sorted by cpid
+		vector<int> cpids;
+		vector<int> leafFrames;//Index of the innermost frame
+		vector<int> framesAtDepth;//Frame id at the current depth
+	};
+
+} /* namespace TraceviewerServer */
+#endif /* DEPTHTABLE_HPP_ */
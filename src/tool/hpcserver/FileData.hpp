@@ -67,6 +67,8 @@ namespace TraceviewerServer
 	{
 		string fileXML;
 		string fileTrace;
+		//May not exist; older databases have no depth table
+		string fileDepth;
 	};
 }
 #endif
@@ -73,6 +73,7 @@ FilteredBaseData::FilteredBaseData(string filename, int _headerSize) {
 	baseDataFile = new BaseDataFile(filename, _headerSize);
 	headerSize = _headerSize;
 	baseOffsets = baseDataFile->getOffsets();
+	pyramid = TracePyramid::open(filename, _headerSize);
 	//Filters are default, which is allow everything, so this will initialize the vector
 	filter();
 
@@ -80,6 +81,7 @@ FilteredBaseData::FilteredBaseData(string filename, int _headerSize) {
 
 FilteredBaseData::~FilteredBaseData() {
 	delete baseDataFile;
+	delete pyramid;
 }
 
 void FilteredBaseData::setFilters(FilterSet _filter)
@@ -121,6 +123,12 @@ int FilteredBaseData::getInt(FileOffset position)
 	return baseDataFile->getMasterBuffer()->getInt(position);
 }
 
+int FilteredBaseData::getRealRank(int pseudoRank)
+{
+	assert((unsigned int)pseudoRank < rankMapping.size());
+	return rankMapping[pseudoRank];
+}
+
 int FilteredBaseData::getNumberOfRanks()
 {
 	return rankMapping.size();
@@ -134,4 +142,13 @@ short* FilteredBaseData::getThreadIDs()
 {
 	return baseDataFile->threadIDs;
 }
+
+bool FilteredBaseData::samplePyramid(int pseudoRank, Time timeStart, double pixelLength,
+		int numPixels, vector<TimeCPID>* list)
+{
+	if (pyramid == NULL)
+		return false;
+	assert((unsigned int)pseudoRank < rankMapping.size());
+	return pyramid->sample(rankMapping[pseudoRank], timeStart, pixelLength, numPixels, list);
+}
 }
@@ -63,6 +63,7 @@
 #include "ImageTraceAttributes.hpp"
 #include "BaseDataFile.hpp"
 #include "FilterSet.hpp"
+#include "TracePyramid.hpp"
 #include "FileUtils.hpp"//For FileOffset
 
 #include <vector>
@@ -83,13 +84,19 @@ namespace TraceviewerServer
 		int64_t getLong(FileOffset position);
 		int getInt(FileOffset position);
 		int getNumberOfRanks();
+		//The rank in the unfiltered pool that a pseudorank refers to
+		int getRealRank(int pseudoRank);
 		int* getProcessIDs();
 		short* getThreadIDs();
+		//Samples a timeline from the level-of-detail pyramid, if there is one
+		bool samplePyramid(int pseudoRank, Time timeStart, double pixelLength,
+				int numPixels, vector<TimeCPID>* list);
 	private:
 
 		void filter();
 
 		BaseDataFile* baseDataFile;
+		TracePyramid* pyramid;
 		OffsetPair* baseOffsets;
 		FilterSet currentlyAppliedFilter;
 		//Maps the pseudoranks the program asks for from the unfiltered
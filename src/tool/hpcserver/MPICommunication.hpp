@@ -79,6 +79,7 @@ namespace TraceviewerServer
 		typedef struct
 		{
 			char path[1024];
+			int compressionType; //negotiated with the client
 		} open_file_command;
 		typedef struct
 		{
@@ -102,6 +103,10 @@ namespace TraceviewerServer
 			bool excludeMatches;
 		} filter_header_command;
 		typedef struct
+		{
+			int depth;
+		} depth_command;
+		typedef struct
 		{
 			int command;
 			union
@@ -111,6 +116,7 @@ namespace TraceviewerServer
 				get_data_command gdata;
 				more_info_command minfo;
 				filter_header_command filt;
+				depth_command depth;
 			};
 		} CommandMessage;
 
@@ -132,6 +138,14 @@ namespace TraceviewerServer
 			int compressedSize;//In Bytes
 		} DataHeader;
 
+		//Followed by size bytes of packed TraceStatistics
+		typedef struct
+		{
+			int rankID;
+			int lines;
+			int size;
+		} StatisticsHeader;
+
 		typedef struct
 		{
 			int tag;
@@ -139,6 +153,7 @@ namespace TraceviewerServer
 			{
 				DataHeader data;
 				DoneMessage done;
+				StatisticsHeader stats;
 			};
 		} ResultMessage;
 
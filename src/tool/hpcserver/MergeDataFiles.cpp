@@ -64,12 +64,20 @@
 #include "FileUtils.hpp"
 #include "DebugUtils.hpp"
 #include "ProgressBar.hpp"
+#include "TracePyramid.hpp"
 
 #include <string>
 #include <algorithm>
 #include <cstdlib>
 #include <cstdio>
 #include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 typedef int64_t Long;
@@ -90,7 +98,14 @@ namespace TraceviewerServer
 			DEBUGCOUT(2) << "Exists" << endl;
 
 			if (isMergedFileCorrect(&outputFile))
+			{
+				// databases merged before the pyramid existed or without
+				// --pyramid get one now
+				if (TracePyramid::enabled
+						&& !FileUtils::exists(TracePyramid::pyramidFileName(outputFile)))
+					TracePyramid::build(outputFile);
 				return SUCCESS_ALREADY_CREATED;
+			}
 			// the file exists but corrupted.
 			cout << "Database file may be corrupted. Continuing" << endl;
 			return STATUS_UNKNOWN;
@@ -135,6 +150,10 @@ namespace TraceviewerServer
 				* (SIZEOF_LONG + 2 * SIZEOF_INT);
 		FileOffset currentOffset = num_metric_header + num_metric_index;
 
+		//Where each file goes in the merged file, known before any data is copied
+		vector<string> copyFrom;
+		vector<FileOffset> copyTo, copySize;
+
 		int name_format = 0; // FIXME hack:some hpcprof revisions have different format name !!
 		//-----------------------------------------------------
 		// 2. Record the process ID, thread ID and the currentOffset
@@ -177,50 +196,106 @@ namespace TraceviewerServer
 			if (Thread != 0)
 				type |= MULTI_THREADING;
 			dos.writeLong(currentOffset);
-			currentOffset += FileUtils::getFileSize(Filename);
+			FileOffset size = FileUtils::getFileSize(Filename);
+			copyFrom.push_back(Filename);
+			copyTo.push_back(currentOffset);
+			copySize.push_back(size);
+			currentOffset += size;
 		}
+		dos.close();
 		//-----------------------------------------------------
 		// 3. Copy all data from the multiple files into one file
+		//	Every file has its own place in the merged file, so the
+		//	files are copied concurrently.
 		//-----------------------------------------------------
-		ProgressBar prog("Merging database", filteredFileNames.size());
-		for (it2 = filteredFileNames.begin(); it2 < filteredFileNames.end(); it2++)
+		int outFd = open(outputFile.c_str(), O_WRONLY);
+		if (outFd < 0)
 		{
-			string i = *it2;
-
-			ifstream dis(i.c_str(), ios_base::binary | ios_base::in);
-			char data[PAGE_SIZE_GUESS];
-			dis.read(data, PAGE_SIZE_GUESS);
-			int bytesRead = dis.gcount();
-			while (bytesRead > 0)
-			{
-				dos.write(data, bytesRead);
-				dis.read(data, PAGE_SIZE_GUESS);
-				bytesRead = dis.gcount();
-			}
-			dis.close();
+			cerr << "Could not open " << outputFile << " for merging" << endl;
+			return STATUS_UNKNOWN;
+		}
+		int numCopies = copyFrom.size();
+		bool copied = true;
+		ProgressBar prog("Merging database", numCopies);
+#pragma omp parallel for schedule(dynamic, 1) reduction(&&: copied)
+		for (int i = 0; i < numCopies; i++)
+		{
+			copied = copyFile(copyFrom[i], outFd, copyTo[i], copySize[i]) && copied;
+#pragma omp critical (mergeProgress)
 			prog.incrementProgress();
 		}
-		insertMarker(&dos);
-		dos.close();
+		close(outFd);
+		if (!copied)
+		{
+			// without the marker, the next attempt would merge again anyway
+			cerr << "Could not copy all trace files into " << outputFile << endl;
+			remove(outputFile.c_str());
+			return STATUS_UNKNOWN;
+		}
 		//-----------------------------------------------------
 		// 4. FIXME: write the type of the application
 		//  	the type of the application is computed in step 2
 		//		Ideally, this step has to be in the beginning !
+		//	The end marker goes in last, once all data is in place.
 		//-----------------------------------------------------
 		//While we don't actually want to do any input operations, adding the input flag prevents the file from being truncated to 0 bytes
 		DataOutputFileStream f(outputFile.c_str(), ios_base::in | ios_base::out | ios_base::binary);
 		f.writeInt(type);
+		f.seekp(currentOffset, ios_base::beg);
+		insertMarker(&f);
 		f.close();
 
 		//-----------------------------------------------------
 		// 5. remove old files
 		//-----------------------------------------------------
 		removeFiles(filteredFileNames);
+
+		//-----------------------------------------------------
+		// 6. build the level-of-detail pyramid for zoomed-out views, if
+		//    it is enabled
+		//-----------------------------------------------------
+		TracePyramid::build(outputFile);
 		return SUCCESS_MERGED;
 	}
 
 
 
+	//Copies one trace file to its place in the merged file. Safe to call
+	//concurrently for different places of the same output descriptor.
+	bool MergeDataFiles::copyFile(string from, int toFd, FileOffset offset, FileOffset size)
+	{
+		int fromFd = open(from.c_str(), O_RDONLY);
+		if (fromFd < 0)
+			return false;
+		FileOffset done = 0;
+#ifdef SYS_copy_file_range
+		// copy within the kernel (or the file system) where supported
+		loff_t inPos = 0, outPos = offset;
+		while (done < size)
+		{
+			long n = syscall(SYS_copy_file_range, fromFd, &inPos, toFd, &outPos,
+					(size_t) (size - done), 0);
+			if (n <= 0)
+				break;
+			done += n;
+		}
+#endif
+		// otherwise, or for whatever is left, go through a buffer
+		vector<char> buffer(COPY_BUFFER_SIZE);
+		while (done < size)
+		{
+			size_t len = (size_t) min(size - done, (FileOffset) COPY_BUFFER_SIZE);
+			ssize_t n = pread(fromFd, &buffer[0], len, done);
+			if (n <= 0)
+				break;
+			if (pwrite(toFd, &buffer[0], n, offset + done) != n)
+				break;
+			done += n;
+		}
+		close(fromFd);
+		return done == size;
+	}
+
 	void MergeDataFiles::insertMarker(DataOutputFileStream* dos)
 	{
 		dos->writeLong(MARKER_END_MERGED_FILE);
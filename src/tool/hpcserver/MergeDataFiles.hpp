@@ -60,6 +60,7 @@
 #define MERGEDATAFILES_H_
 
 #include "DataOutputFileStream.hpp"
+#include "FileUtils.hpp"//For FileOffset
 #include <vector>
 #include <string>
 #include <stdint.h>
@@ -81,9 +82,10 @@ namespace TraceviewerServer
 		static vector<string> splitString(string, char);
 	private:
 		static const uint64_t MARKER_END_MERGED_FILE = 0xFFFFFFFFDEADF00D;
-		static const int PAGE_SIZE_GUESS = 4096;
+		static const int COPY_BUFFER_SIZE = 1 << 20;
 		static const int PROC_POS = 5;
 		static const int THREAD_POS = 4;
+		static bool copyFile(string, int, FileOffset, FileOffset);
 		static void insertMarker(DataOutputFileStream*);
 		static bool isMergedFileCorrect(string*);
 		static bool removeFiles(vector<string>);
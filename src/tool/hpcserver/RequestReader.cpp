@@ -0,0 +1,196 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL: https://hpctoolkit.googlecode.com/svn/branches/hpctoolkit-hpcserver/src/tool/hpcserver/FilteredBaseData.cpp $
+// $Id: FilteredBaseData.cpp 4307 2013-07-18 17:04:52Z felipet1326@gmail.com $
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Reads the requests of a connection ahead of the one being answered.
+//
+// Description:
+//   The reader thread only reads from the socket and the server thread only
+//   writes to it (DataSocketStream keeps separate streams for the two), so
+//   the queue is the only state they share.
+//
+//***************************************************************************
+
+#include "RequestReader.hpp"
+#include "Constants.hpp"
+#include "DebugUtils.hpp"
+
+namespace TraceviewerServer
+{
+	RequestReader::RequestReader(DataSocketStream* _stream)
+	{
+		stream = _stream;
+		finished = false;
+		pthread_mutex_init(&lock, NULL);
+		pthread_cond_init(&arrived, NULL);
+		pthread_create(&thread, NULL, run, this);
+	}
+
+	RequestReader::~RequestReader()
+	{
+		//The thread is done once it has queued OPEN, DONE or an error. If the
+		//server gives up on the connection before that, the thread is still
+		//waiting for the client and has to be cancelled.
+		pthread_mutex_lock(&lock);
+		if (!finished)
+			pthread_cancel(thread);
+		pthread_mutex_unlock(&lock);
+		pthread_join(thread, NULL);
+		pthread_cond_destroy(&arrived);
+		pthread_mutex_destroy(&lock);
+	}
+
+	void* RequestReader::run(void* reader)
+	{
+		((RequestReader*) reader)->readRequests();
+		return NULL;
+	}
+
+	void RequestReader::readRequests()
+	{
+		while (true)
+		{
+			Request request;
+			try
+			{
+				request = readRequest();
+			} catch (ErrorCode e)
+			{
+				request.command = 0;
+				request.error = e;
+			}
+			bool last = (request.command != DATA && request.command != FLTR
+					&& request.command != STAT && request.command != DPTH);
+			push(request, last);
+			if (last)
+				return;
+		}
+	}
+
+	Request RequestReader::readRequest()
+	{
+		Request request;
+		request.command = stream->readInt();
+		request.error = 0;
+		switch (request.command)
+		{
+			case DATA:
+			case STAT:
+				request.processStart = stream->readInt();
+				request.processEnd = stream->readInt();
+				request.timeStart = stream->readLong();
+				request.timeEnd = stream->readLong();
+				request.verticalResolution = stream->readInt();
+				request.horizontalResolution = stream->readInt();
+				break;
+			case FLTR:
+			{
+				stream->readByte();//Padding
+				request.excludeMatches = stream->readByte();
+				int count = stream->readShort();
+				for (int i = 0; i < count; ++i) {
+					BinaryRepresentationOfFilter filt;
+					filt.processMin = stream->readInt();
+					filt.processMax = stream->readInt();
+					filt.processStride = stream->readInt();
+					filt.threadMin = stream->readInt();
+					filt.threadMax = stream->readInt();
+					filt.threadStride = stream->readInt();
+					request.filters.push_back(filt);
+				}
+				break;
+			}
+			case DPTH:
+				request.depth = stream->readInt();
+				break;
+			default:
+				//OPEN and DONE carry no parameters we read here, and anything
+				//else ends the connection
+				break;
+		}
+		DEBUGCOUT(2) << "Queued request " << request.command << endl;
+		return request;
+	}
+
+	void RequestReader::push(const Request& request, bool last)
+	{
+		pthread_mutex_lock(&lock);
+		queue.push_back(request);
+		finished = last;
+		pthread_cond_signal(&arrived);
+		pthread_mutex_unlock(&lock);
+	}
+
+	Request RequestReader::next()
+	{
+		pthread_mutex_lock(&lock);
+		while (queue.empty())
+			pthread_cond_wait(&arrived, &lock);
+		Request request = queue.front();
+		queue.pop_front();
+		pthread_mutex_unlock(&lock);
+		return request;
+	}
+
+	bool RequestReader::isSuperseded()
+	{
+		bool superseded = false;
+		pthread_mutex_lock(&lock);
+		for (size_t i = 0; i < queue.size(); i++)
+			if (queue[i].command != FLTR && queue[i].command != STAT
+					&& queue[i].command != DPTH)
+				superseded = true;
+		pthread_mutex_unlock(&lock);
+		return superseded;
+	}
+
+} /* namespace TraceviewerServer */
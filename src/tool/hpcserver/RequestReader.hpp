@@ -0,0 +1,127 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL: https://hpctoolkit.googlecode.com/svn/branches/hpctoolkit-hpcserver/src/tool/hpcserver/FilteredBaseData.hpp $
+// $Id: FilteredBaseData.hpp 4307 2013-07-18 17:04:52Z felipet1326@gmail.com $
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Reads the requests of a connection ahead of the one being answered.
+//
+// Description:
+//   After INFO, a reader thread keeps listening on the socket and queues
+//   every complete request. The server takes requests from the queue in
+//   order, and while it answers a DATA request it can see that a newer one
+//   has arrived and stop computing rows nobody will look at. The thread
+//   stops after OPEN or DONE, so the next connection reads the socket
+//   directly again.
+//
+//***************************************************************************
+
+#ifndef REQUESTREADER_HPP_
+#define REQUESTREADER_HPP_
+
+#include <pthread.h>
+#include <deque>
+#include <vector>
+
+#include "DataSocketStream.hpp"
+#include "Filter.hpp"
+#include "TimeCPID.hpp"
+
+namespace TraceviewerServer
+{
+	struct Request
+	{
+		//DATA, STAT, FLTR, DPTH, OPEN or DONE; 0 if the connection failed with error
+		int command;
+		int error;
+
+		//DATA and STAT
+		int processStart;
+		int processEnd;
+		Time timeStart;
+		Time timeEnd;
+		int verticalResolution;
+		int horizontalResolution;
+
+		//FLTR
+		bool excludeMatches;
+		std::vector<BinaryRepresentationOfFilter> filters;
+
+		//DPTH
+		int depth;
+	};
+
+	class RequestReader
+	{
+	public:
+		RequestReader(DataSocketStream* _stream);
+		virtual ~RequestReader();
+
+		//Blocks until the next request has been read
+		Request next();
+		//True if a request that makes the current DATA request stale is queued.
+		//Filters, depths and statistics are answered after it and do not count.
+		bool isSuperseded();
+	private:
+		static void* run(void*);
+		void readRequests();
+		Request readRequest();
+		void push(const Request&, bool last);
+
+		DataSocketStream* stream;
+		pthread_t thread;
+		pthread_mutex_t lock;
+		pthread_cond_t arrived;
+		std::deque<Request> queue;
+		bool finished;
+	};
+
+} /* namespace TraceviewerServer */
+#endif /* REQUESTREADER_HPP_ */
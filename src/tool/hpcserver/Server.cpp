@@ -69,6 +69,7 @@
 #include "DebugUtils.hpp"
 #include "Filter.hpp"
 #include "FilterSet.hpp"
+#include "RequestReader.hpp"
 #include "SpaceTimeDataController.hpp"
 #include "TimeCPID.hpp" //For Time
 
@@ -86,9 +87,13 @@ using namespace std;
 
 namespace TraceviewerServer
 {
-	bool useCompression = true;
+	int requestedCompressionType = COMPRESSION_DEFLATE;
+	int compressionType = COMPRESSION_DEFLATE;
+	int compressionLevel = Z_DEFAULT_COMPRESSION;
 	int mainPortNumber = DEFAULT_PORT;
 	int xmlPortNumber = 0;
+	int numWorkerThreads = 1;
+	size_t timelineCacheSize = 0;
 
 	Server::Server()
 	{
@@ -184,26 +189,41 @@ namespace TraceviewerServer
 		// main loop for a communication session
 		// as long as the client doesn't send OPEN or DONE, we remain in 
 		// in this loop 
+		// requests are read ahead by the reader, so that a data request
+		// can be cut short once a newer one has arrived
 		// ------------------------------------------------------------------
+		RequestReader reader(socketptr);
 		while (true)
 		{
-			int nextCommand = socketptr->readInt();
-			switch (nextCommand)
+			Request request = reader.next();
+			switch (request.command)
 			{
 				case DATA:
 #ifdef HPCTOOLKIT_PROFILE
 					hpctoolkit_sampling_start();
 #endif
-					getAndSendData(socketptr);
+					getAndSendData(socketptr, request, &reader);
 #ifdef HPCTOOLKIT_PROFILE
 					hpctoolkit_sampling_stop();
 #endif
 					break;
+				case STAT:
+#ifdef HPCTOOLKIT_PROFILE
+					hpctoolkit_sampling_start();
+#endif
+					getAndSendStatistics(socketptr, request);
+#ifdef HPCTOOLKIT_PROFILE
+					hpctoolkit_sampling_stop();
+#endif
+					break;
+				case DPTH:
+					setDepth(socketptr, request);
+					break;
 				case FLTR:
 #ifdef HPCTOOLKIT_PROFILE
 					hpctoolkit_sampling_start();
 #endif
-					filter(socketptr);
+					filter(request);
 #ifdef HPCTOOLKIT_PROFILE
 					hpctoolkit_sampling_stop();
 #endif
@@ -212,6 +232,8 @@ namespace TraceviewerServer
 					return CLOSE_SERVER;
 				case OPEN:
 					return START_NEW_CONNECTION_IMMEDIATELY;
+				case 0:
+					throw (ErrorCode) request.error;
 				default:
 					cerr << "Unknown command received" << endl;
 					return ERROR_UNKNOWN_COMMAND;
@@ -241,11 +263,7 @@ namespace TraceviewerServer
 		int numFiles = controller->getNumRanks();
 		socket->writeInt(numFiles);
 
-		// This is an int so that it is possible to have different compression
-		// algorithms in the future. For now, it is just
-		// 0=no compression, 1= normal compression
-		int compressionType;
-		compressionType = useCompression ? 1 : 0;
+		// One of the CompressionType values
 		socket->writeInt(compressionType);
 
 		//Send ValuesX
@@ -279,18 +297,8 @@ namespace TraceviewerServer
 		{
 			ProgressBar prog("Compressing XML", uncompressedFileSize);
 			FILE* in = fopen(controller->getExperimentXML().c_str(), "r");
-			//From http://zlib.net/zpipe.c with some editing
-			z_stream compressor;
-			compressor.zalloc = Z_NULL;
-			compressor.zfree = Z_NULL;
-			compressor.opaque = Z_NULL;
-
-			//This makes a gzip stream with a window of 15 bits
-			int ret = deflateInit2(&compressor, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16+15, 8, Z_DEFAULT_STRATEGY);
-			if (ret != Z_OK)
-				throw ret;
-
-			DataCompressionLayer compL(compressor, &prog);
+			//The XML is sent once per database, so it gets the better ratio
+			DataCompressionLayer compL(Z_DEFAULT_COMPRESSION, true, &prog);
 			compL.writeFile(in);
 
 			fclose(in);
@@ -308,6 +316,7 @@ namespace TraceviewerServer
 	void Server::checkProtocolVersions(DataSocketStream* receiver)
 	{
 		int clientProtocolVersion = receiver->readInt();
+		agreedUponProtocolVersion = clientProtocolVersion;
 
 		if (clientProtocolVersion != SERVER_PROTOCOL_MAX_VERSION)
 			cout << "The client is using protocol version 0x" << hex << clientProtocolVersion<<
@@ -329,6 +338,17 @@ namespace TraceviewerServer
 	{
 		checkProtocolVersions(receiver);
 
+		//Only clients that speak PACKED_PROTOCOL_VERSION can decode packed
+		//timelines; everyone else gets plain deflate. compressionType is
+		//what this session uses, and it is what DBOK announces.
+		compressionType = requestedCompressionType;
+		if (compressionType == COMPRESSION_PACKED
+				&& agreedUponProtocolVersion < PACKED_PROTOCOL_VERSION)
+		{
+			cout << "The client does not support packed timelines, using deflate." << endl;
+			compressionType = COMPRESSION_DEFLATE;
+		}
+
 		string pathToDB = receiver->readString();
 		DBOpener DBO;
 		cout << "Opening database: " << pathToDB << endl;
@@ -336,6 +356,8 @@ namespace TraceviewerServer
 
 		if (controller != NULL)
 		{
+			controller->setNumWorkers(numWorkerThreads);
+			controller->setCacheSize(timelineCacheSize);
 			Communication::sendParseOpenDB(pathToDB);
 		}
 
@@ -352,28 +374,32 @@ namespace TraceviewerServer
 
 
 
-	void Server::getAndSendData(DataSocketStream* stream)
+	void Server::checkParameters(Request& request)
 	{
-		LOGTIMESTAMPEDMSG("Front end received data request.")
-		int processStart = stream->readInt();
-		int processEnd = stream->readInt();
-		Time timeStart = stream->readLong();
-		Time timeEnd = stream->readLong();
-		int verticalResolution = stream->readInt();
-		int horizontalResolution = stream->readInt();
+		DEBUGCOUT(2) << "Time end: " << request.timeEnd <<endl;
 
-		DEBUGCOUT(2) << "Time end: " << timeEnd <<endl;
-
-
-		if ((processStart < 0) || (processEnd<0) || (processStart > processEnd)
-				|| (verticalResolution<0) || (horizontalResolution<0)
-				|| (timeEnd < timeStart))
+		if ((request.processStart < 0) || (request.processEnd<0) || (request.processStart > request.processEnd)
+				|| (request.verticalResolution<0) || (request.horizontalResolution<0)
+				|| (request.timeEnd < request.timeStart))
 		{
 			cerr
 					<< "A data request with invalid parameters was received. This sometimes happens if the client shuts down in the middle of a request. The server will now shut down."
 					<< endl;
 			throw(ERROR_INVALID_PARAMETERS);
 		}
+	}
+
+	void Server::getAndSendData(DataSocketStream* stream, Request& request, RequestReader* reader)
+	{
+		LOGTIMESTAMPEDMSG("Front end received data request.")
+		int processStart = request.processStart;
+		int processEnd = request.processEnd;
+		Time timeStart = request.timeStart;
+		Time timeEnd = request.timeEnd;
+		int verticalResolution = request.verticalResolution;
+		int horizontalResolution = request.horizontalResolution;
+
+		checkParameters(request);
 		Communication::sendStartGetData(controller, processStart, processEnd, timeStart, timeEnd, verticalResolution, horizontalResolution);
 		LOGTIMESTAMPEDMSG("Back end received data request.")
 
@@ -382,25 +408,49 @@ namespace TraceviewerServer
 
 		ProgressBar prog("Computing traces", min(processEnd - processStart, verticalResolution));
 
-		Communication::sendEndGetData(stream, &prog, controller);
+		Communication::sendEndGetData(stream, &prog, controller, reader);
+
+	}
+
+	//Takes the same parameters as a data request, but answers with the
+	//summary of the lines instead of the lines themselves
+	void Server::getAndSendStatistics(DataSocketStream* stream, Request& request)
+	{
+		checkParameters(request);
+		Communication::sendStartGetStatistics(controller, request.processStart, request.processEnd,
+				request.timeStart, request.timeEnd, request.verticalResolution, request.horizontalResolution);
+
+		stream->writeInt(STAT);
 
+		ProgressBar prog("Computing statistics",
+				min(request.processEnd - request.processStart, request.verticalResolution));
+
+		Communication::sendEndGetStatistics(stream, &prog, controller);
+		stream->flush();
+	}
+
+	//Answers DPTH with 1 if rows will now be sent at the requested depth,
+	//and 0 if the database has no depth table and they stay as cpids
+	void Server::setDepth(DataSocketStream* stream, Request& request)
+	{
+		Communication::sendDepth(request.depth);
+		bool applied = controller->setDepth(request.depth);
+		if (!applied)
+			cerr << "No depth table in this database; sending call path ids" << endl;
+
+		stream->writeInt(DPTH);
+		stream->writeInt(applied ? 1 : 0);
+		stream->flush();
 	}
 
-	void Server::filter(DataSocketStream* stream)
+	void Server::filter(Request& request)
 	{
-		stream->readByte();//Padding
-		bool excludeMatches = stream->readByte();
-		int count = stream->readShort();
+		bool excludeMatches = request.excludeMatches;
+		int count = request.filters.size();
 		Communication::sendStartFilter(count, excludeMatches);
 		FilterSet filters(excludeMatches);
 		for (int i = 0; i < count; ++i) {
-			BinaryRepresentationOfFilter filt;//This makes the MPI code easier and the non-mpi code about the same
-			filt.processMin = stream->readInt();
-			filt.processMax = stream->readInt();
-			filt.processStride = stream->readInt();
-			filt.threadMin = stream->readInt();
-			filt.threadMax = stream->readInt();
-			filt.threadStride = stream->readInt();
+			BinaryRepresentationOfFilter filt = request.filters[i];//This makes the MPI code easier and the non-mpi code about the same
 			DEBUGCOUT(2) << "Filter proc: " << filt.processMin <<":" << filt.processMax <<":"<<filt.processStride<<",";
 			DEBUGCOUT(2) << "Filter thread: " << filt.threadMax <<":" << filt.threadMax <<":"<<filt.threadStride<<endl;
 
@@ -62,14 +62,19 @@
 
 #include "DataSocketStream.hpp"
 #include "SpaceTimeDataController.hpp"
+#include "RequestReader.hpp"
 
 
 
 namespace TraceviewerServer
 {
-	extern bool useCompression;
+	extern int requestedCompressionType;
+	extern int compressionType;
+	extern int compressionLevel;
 	extern int mainPortNumber;
 	extern int xmlPortNumber;
+	extern int numWorkerThreads;
+	extern size_t timelineCacheSize;
 	class Server
 	{
 
@@ -84,17 +89,22 @@ namespace TraceviewerServer
 
 		void parseInfo(DataSocketStream*);
 		SpaceTimeDataController* parseOpenDB(DataSocketStream*);
-		void filter(DataSocketStream*);
-		void getAndSendData(DataSocketStream*);
+		void filter(Request&);
+		void setDepth(DataSocketStream*, Request&);
+		void checkParameters(Request&);
+		void getAndSendData(DataSocketStream*, Request&, RequestReader*);
+		void getAndSendStatistics(DataSocketStream*, Request&);
 		void sendXML(DataSocketStream*);
 		void sendDBOpenFailed(DataSocketStream*);
 		void checkProtocolVersions(DataSocketStream* receiver);
 
 		SpaceTimeDataController* controller;
 
-		//Currently not really used, but pretty necessary for future extensions
+		//Decides whether the client can be sent COMPRESSION_PACKED
 		int agreedUponProtocolVersion;
-		static const int SERVER_PROTOCOL_MAX_VERSION = 0x00010001;
+		static const int SERVER_PROTOCOL_MAX_VERSION = 0x00010002;
+		//First version whose clients can decode COMPRESSION_PACKED
+		static const int PACKED_PROTOCOL_VERSION = 0x00010002;
 
 	};
 }/* namespace TraceviewerServer */
@@ -73,6 +73,7 @@
 #include "DataCompressionLayer.hpp"
 #include "Server.hpp"
 #include "FilterSet.hpp"
+#include "TraceStatistics.hpp"
 #include "DebugUtils.hpp"
 
 #ifdef HPCTOOLKIT_PROFILE
@@ -108,7 +109,10 @@ namespace TraceviewerServer
 					delete (controller);
 					{//Set an artificial context to avoid initialization crossing cases
 						DBOpener DBO;
+						compressionType = Message.ofile.compressionType;
 						controller = DBO.openDbAndCreateStdc(string(Message.ofile.path));
+						if (controller != NULL)
+							controller->setCacheSize(timelineCacheSize);
 					}
 					break;
 				case INFO:
@@ -129,6 +133,12 @@ namespace TraceviewerServer
 							MPICommunication::SOCKET_SERVER, 0);
 					break;
 				}
+				case STAT:
+					getStatistics(&Message);
+					break;
+				case DPTH:
+					controller->setDepth(Message.depth.depth);
+					break;
 				case FLTR:
 				{
 					FilterSet f(Message.filt.excludeMatches);
@@ -152,20 +162,13 @@ namespace TraceviewerServer
 		}
 	}
 
-	int Slave::getData(MPICommunication::CommandMessage* Message)
+	bool Slave::assignLines(MPICommunication::get_data_command gc, int* lower, int* upper)
 	{
-		MPICommunication::get_data_command gc = Message->gdata;
 		ImageTraceAttributes correspondingAttributes;
 
 		int trueRank = COMM_WORLD.Get_rank();
 		int size = COMM_WORLD.Get_size();
 
-		// Keep track of all these buffers we declare so that we can free them
-		// all at the end. Allocating them on the heap lets us put out multiple
-		// ISends and overlap computation and communication at the cost of extra
-		// memory usage (a negligible amount though: < 10 MB)
-		list<MPICommunication::ResultBufferLocations*> buffers;
-
 		//Gives us a contiguous count of ranks from 0 to size-2 regardless of which node is the socket server
 		//If ss = 0, they are all mapped one less. If ss = size-1, no changes happen
 		int rank = trueRank > MPICommunication::SOCKET_SERVER ? trueRank - 1 : trueRank;
@@ -179,20 +182,20 @@ namespace TraceviewerServer
 		if (rank > n)
 		{
 			DEBUGCOUT(1) << "No work to do" << endl;
-			return 0;
+			return false;
 		}
 
 		//If rank < (n % (p-1)) this node should compute ceil(n/(p-1)) trace lines,
 		//otherwise it should compute floor(n/(p-1))
 
 		//=MIN(F5, $D$1)*(CEILING($B$1/($B$2-1),1)) + (F5-MIN(F5, $D$1))*(FLOOR($B$1/($B$2-1),1))
-		int LowerInclusiveBound = (int) (min(mod, rank) * ceil(q)
+		*lower = (int) (min(mod, rank) * ceil(q)
 				+ (rank - min(mod, rank)) * floor(q) + gc.processStart);
-		int UpperInclusiveBound = (int) (min(mod, rank + 1) * ceil(q)
+		*upper = (int) (min(mod, rank + 1) * ceil(q)
 				+ (rank + 1 - min(mod, rank + 1)) * floor(q) - 1 + gc.processStart);
 
-		DEBUGCOUT(1) << "Rank " << trueRank << " is getting lines [" << LowerInclusiveBound << ", "
-				<< UpperInclusiveBound << "]" << endl;
+		DEBUGCOUT(1) << "Rank " << trueRank << " is getting lines [" << *lower << ", "
+				<< *upper << "]" << endl;
 
 		//These have to be the originals so that the strides will be correct
 		correspondingAttributes.begProcess = gc.processStart;
@@ -221,6 +224,26 @@ namespace TraceviewerServer
 
 		*controller->attributes = correspondingAttributes;
 
+		return true;
+	}
+
+	int Slave::getData(MPICommunication::CommandMessage* Message)
+	{
+		MPICommunication::get_data_command gc = Message->gdata;
+
+		int trueRank = COMM_WORLD.Get_rank();
+
+		// Keep track of all these buffers we declare so that we can free them
+		// all at the end. Allocating them on the heap lets us put out multiple
+		// ISends and overlap computation and communication at the cost of extra
+		// memory usage (a negligible amount though: < 10 MB)
+		list<MPICommunication::ResultBufferLocations*> buffers;
+
+		int LowerInclusiveBound, UpperInclusiveBound;
+		if (!assignLines(gc, &LowerInclusiveBound, &UpperInclusiveBound))
+			return 0;
+		int autoskip = controller->attributes->lineNum;
+
 		ProcessTimeline* nextTrace = controller->getNextTrace();
 		int LinesSentCount = 0;
 		int waitcount = 0;
@@ -246,9 +269,10 @@ namespace TraceviewerServer
 
 				waitcount = 0;
 			}
-			nextTrace->readInData();
+			controller->readTimeline(nextTrace);
 
 			vector<TimeCPID> ActualData = *nextTrace->data->listCPID;
+			controller->collapseToDepth(&ActualData);
 
 			MPICommunication::ResultBufferLocations* locs = new MPICommunication::ResultBufferLocations;
 
@@ -270,20 +294,14 @@ namespace TraceviewerServer
 			unsigned char* outputBuffer = NULL;
 			DataCompressionLayer* compr = NULL;
 			int outputBufferLen;
-			if (useCompression)
+			if (compressionType != COMPRESSION_NONE)
 			{
-				compr = new DataCompressionLayer();
+				compr = new DataCompressionLayer(compressionLevel, false, NULL);
 
 				locs->compressed = true;
 				locs->compMsg = compr;
 
-				Time currentTimestamp = msg->data.begtime;
-				for (i = 0; i < entries; i++)
-				{
-					compr->writeInt((int) (ActualData[i].timestamp - currentTimestamp));
-					compr->writeInt(ActualData[i].cpid);
-					currentTimestamp = ActualData[i].timestamp;
-				}
+				compr->writeSamples(ActualData, compressionType == COMPRESSION_PACKED);
 				compr->flush();
 				outputBufferLen = compr->getOutputLength();
 				outputBuffer = compr->getOutputBuffer();
@@ -337,6 +355,47 @@ namespace TraceviewerServer
 
 		return LinesSentCount;
 	}
+	void Slave::getStatistics(MPICommunication::CommandMessage* Message)
+	{
+		MPICommunication::get_data_command gc = Message->gdata;
+		Time begTime = controller->getMinBegTime() + gc.timeStart;
+		Time endTime = controller->getMinBegTime() + gc.timeEnd;
+		TraceStatistics statistics(begTime, endTime, gc.horizontalResolution);
+		int lines = 0;
+
+		int LowerInclusiveBound, UpperInclusiveBound;
+		if (assignLines(gc, &LowerInclusiveBound, &UpperInclusiveBound))
+		{
+			ProcessTimeline* nextTrace = controller->getNextTrace();
+			while (nextTrace != NULL)
+			{
+				if ((nextTrace->data->rank >= LowerInclusiveBound)
+						&& (nextTrace->data->rank <= UpperInclusiveBound))
+				{
+					controller->readTimeline(nextTrace);
+					controller->collapseToDepth(nextTrace->data->listCPID);
+					statistics.add(*nextTrace->data->listCPID);
+					lines++;
+				}
+				delete nextTrace;
+				nextTrace = controller->getNextTrace();
+			}
+		}
+
+		//Every rank answers, even without lines, so the socket server knows
+		//when it has heard from all of them
+		vector<char> buffer;
+		statistics.pack(&buffer);
+
+		MPICommunication::ResultMessage msg;
+		msg.tag = SLAVE_STATS;
+		msg.stats.rankID = COMM_WORLD.Get_rank();
+		msg.stats.lines = lines;
+		msg.stats.size = buffer.size();
+		COMM_WORLD.Send(&msg, sizeof(msg), MPI_PACKED, MPICommunication::SOCKET_SERVER, 0);
+		COMM_WORLD.Send(&buffer[0], buffer.size(), MPI_BYTE, MPICommunication::SOCKET_SERVER, 0);
+	}
+
 	void Slave::cleanSent(list<MPICommunication::ResultBufferLocations*>& buffers, bool wait)
 	{
 		MPICommunication::ResultBufferLocations* current;
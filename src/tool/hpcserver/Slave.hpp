@@ -77,7 +77,11 @@ namespace TraceviewerServer
 
 	private:
 		SpaceTimeDataController* controller;
+		//Sets up the controller for the request and finds the lines this rank
+		//computes. Returns false if there are none.
+		bool assignLines(MPICommunication::get_data_command gc, int* lower, int* upper);
 		int getData(MPICommunication::CommandMessage*);
+		void getStatistics(MPICommunication::CommandMessage*);
 		// Removes all sent messages from the queue
 		void cleanSent(list<MPICommunication::ResultBufferLocations*>& buffers, bool wait);
 	};
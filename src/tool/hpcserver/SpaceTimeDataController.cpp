@@ -59,6 +59,12 @@
 #include "SpaceTimeDataController.hpp"
 #include "FileData.hpp"
 #include <iostream>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace std;
 namespace TraceviewerServer
 {
@@ -80,6 +86,10 @@ namespace TraceviewerServer
 		experimentXML = locations->fileXML;
 		fileTrace = locations->fileTrace;
 		tracesInitialized = false;
+		numWorkers = 1;
+		cache = NULL;
+		depthTable = DepthTable::open(locations->fileDepth);
+		depth = -1;
 
 	}
 
@@ -92,6 +102,49 @@ namespace TraceviewerServer
 		headerSize = _headerSize;
 		delete dataTrace;
 		dataTrace = new FilteredBaseData(fileTrace, headerSize);
+
+		//The page windows of FilteredBaseData are not thread safe, so every
+		//worker other than the first reads through its own.
+		deleteWorkerData();
+		for (int i = 1; i < numWorkers; i++)
+			workerData.push_back(new FilteredBaseData(fileTrace, headerSize));
+	}
+
+	//Must be called before setInfo
+	void SpaceTimeDataController::setNumWorkers(int workers)
+	{
+#ifdef _OPENMP
+		numWorkers = max(workers, 1);
+#else
+		numWorkers = 1;
+#endif
+	}
+
+	int SpaceTimeDataController::getNumWorkers()
+	{
+		return numWorkers;
+	}
+
+	void SpaceTimeDataController::setCacheSize(size_t bytes)
+	{
+		delete cache;
+		cache = (bytes > 0) ? new TimelineCache(bytes) : NULL;
+	}
+
+	bool SpaceTimeDataController::setDepth(int _depth)
+	{
+		if (_depth >= 0 && depthTable == NULL)
+			return false;
+		depth = _depth;
+		if (depth >= 0)
+			depthTable->setDepth(depth);
+		return true;
+	}
+
+	void SpaceTimeDataController::collapseToDepth(vector<TimeCPID>* samples)
+	{
+		if (depth >= 0)
+			depthTable->collapse(samples);
 	}
 
 	int SpaceTimeDataController::getNumRanks()
@@ -99,6 +152,11 @@ namespace TraceviewerServer
 		return height;
 	}
 
+	Time SpaceTimeDataController::getMinBegTime()
+	{
+		return minBegTime;
+	}
+
 	string SpaceTimeDataController::getExperimentXML()
 	{
 		return experimentXML;
@@ -126,20 +184,78 @@ namespace TraceviewerServer
 
 	//Don't call if in MPI mode
 	void SpaceTimeDataController::fillTraces()
+	{
+		int numTraces = prepareTraces();
+
+		if (numWorkers == 1)
+		{
+			//Taken straight from TimelineThread
+			ProcessTimeline* nextTrace = getNextTrace();
+			while (nextTrace != NULL)
+			{
+				readTimeline(nextTrace);
+				addNextTrace(nextTrace);
+
+				nextTrace = getNextTrace();
+			}
+			return;
+		}
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(numWorkers)
+		for (int line = 0; line < numTraces; line++)
+		{
+			fillTrace(line, omp_get_thread_num());
+		}
+#endif
+		attributes->lineNum = numTraces;
+	}
+
+	//Resets the traces array for the current attributes and returns the number
+	//of lines to fill. Lines may then be filled in any order with fillTrace.
+	int SpaceTimeDataController::prepareTraces()
 	{
 		//Traces might be null. resetTraces will fix that.
 		resetTraces();
+		return tracesLength;
+	}
 
+	//Computes one line of the current request with the page window of the given
+	//worker. Different workers may fill different lines concurrently.
+	ProcessTimeline* SpaceTimeDataController::fillTrace(int line, int worker)
+	{
+		FilteredBaseData* data = (worker == 0) ? dataTrace : workerData[worker - 1];
+		ProcessTimeline* trace = new ProcessTimeline(*attributes, line, data,
+				minBegTime + attributes->begTime, headerSize);
+		readTimeline(trace, data);
+		traces[line] = trace;
+		return trace;
+	}
 
-		//Taken straight from TimelineThread
-		ProcessTimeline* nextTrace = getNextTrace();
-		while (nextTrace != NULL)
-		{
-			nextTrace->readInData();
-			addNextTrace(nextTrace);
+	void SpaceTimeDataController::readTimeline(ProcessTimeline* trace)
+	{
+		readTimeline(trace, dataTrace);
+	}
 
-			nextTrace = getNextTrace();
+	//Fills in a timeline from the cache if it holds the same row, and from
+	//the trace data otherwise. Rows are only reused for the exact same view:
+	//a row sampled on another pixel grid, even a shifted one, differs from
+	//what the trace gives for this one.
+	void SpaceTimeDataController::readTimeline(ProcessTimeline* trace, FilteredBaseData* data)
+	{
+		if (cache == NULL)
+		{
+			trace->readInData();
+			return;
 		}
+		TimelineKey key(data->getRealRank(trace->data->rank), minBegTime + attributes->begTime,
+				attributes->endTime - attributes->begTime, attributes->numPixelsH);
+		vector<TimeCPID>* row = trace->data->listCPID;
+		if (cache->lookup(key, row))
+			return;
+
+		trace->readInData();
+		cache->insert(key, *row);
 	}
 
 	 int* SpaceTimeDataController::getValuesXProcessID()
@@ -159,7 +275,8 @@ namespace TraceviewerServer
 
 		deleteTraces();
 
-		traces = new ProcessTimeline*[numTraces];
+		//Lines of a cancelled request are never filled
+		traces = new ProcessTimeline*[numTraces]();
 		tracesLength = numTraces;
 		tracesInitialized = true;
 
@@ -167,6 +284,14 @@ namespace TraceviewerServer
 	void SpaceTimeDataController::applyFilters(FilterSet filters)
 	{
 		dataTrace->setFilters(filters);
+		for (unsigned int i = 0; i < workerData.size(); i++)
+			workerData[i]->setFilters(filters);
+	}
+	void SpaceTimeDataController::deleteWorkerData()
+	{
+		for (unsigned int i = 0; i < workerData.size(); i++)
+			delete workerData[i];
+		workerData.clear();
 	}
 	void SpaceTimeDataController::deleteTraces()
 	{
@@ -185,6 +310,11 @@ namespace TraceviewerServer
 	{
 		delete attributes;
 		delete dataTrace;
+		deleteWorkerData();
+		if (cache != NULL)
+			cache->report(cout);
+		delete cache;
+		delete depthTable;
 
 		//The MPI implementation actually doesn't use the Traces array at all!
 		//It does call getNextTrace, but changedBounds is always true so
@@ -63,9 +63,12 @@
 #include "ProcessTimeline.hpp"
 #include "FilteredBaseData.hpp"
 #include "FilterSet.hpp"
+#include "TimelineCache.hpp"
+#include "DepthTable.hpp"
 #include "TimeCPID.hpp"
 
 #include <string>
+#include <vector>
 
 namespace TraceviewerServer
 {
@@ -81,9 +84,23 @@ namespace TraceviewerServer
 		void addNextTrace(ProcessTimeline*);
 		void fillTraces();
 		ProcessTimeline* fillTrace(bool);
+		int prepareTraces();
+		ProcessTimeline* fillTrace(int line, int worker);
+		void setNumWorkers(int);
+		int getNumWorkers();
+		//Keeps up to the given number of bytes of computed rows; 0 disables the cache
+		void setCacheSize(size_t);
+		void readTimeline(ProcessTimeline*);
 		void applyFilters(FilterSet filters);
+		//Makes rows show the procedure frame at depth instead of the cpid. A
+		//negative depth goes back to cpids. Returns false if the database has
+		//no depth table.
+		bool setDepth(int depth);
+		//Applies the current depth, if any, to a computed row
+		void collapseToDepth(vector<TimeCPID>* samples);
 		//The number of processes in the database, independent of the current display size
 		int getNumRanks();
+		Time getMinBegTime();
 
 		 int* getValuesXProcessID();
 		 short* getValuesXThreadID();
@@ -95,8 +112,16 @@ namespace TraceviewerServer
 	private:
 		void resetTraces();
 		void deleteTraces();
+		void deleteWorkerData();
+		void readTimeline(ProcessTimeline*, FilteredBaseData*);
 
 		FilteredBaseData* dataTrace;
+		//One FilteredBaseData (and so one page window) per additional worker
+		std::vector<FilteredBaseData*> workerData;
+		int numWorkers;
+		TimelineCache* cache;
+		DepthTable* depthTable;
+		int depth;
 		int headerSize;
 
 		// The minimum beginning and maximum ending time stamp across all traces (in microseconds).
@@ -0,0 +1,153 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL: https://hpctoolkit.googlecode.com/svn/branches/hpctoolkit-hpcserver/src/tool/hpcserver/FilteredBaseData.cpp $
+// $Id: FilteredBaseData.cpp 4307 2013-07-18 17:04:52Z felipet1326@gmail.com $
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   A bounded cache of computed timeline rows.
+//
+// Description:
+//   Workers computing lines in parallel share one cache, so every public
+//   method runs in the same critical section.
+//
+//***************************************************************************
+
+#include "TimelineCache.hpp"
+#include "DebugUtils.hpp"
+
+namespace TraceviewerServer
+{
+	#define ROW_BYTES(row) (sizeof(Entry) + (row).size() * sizeof(TimeCPID))
+
+	TimelineCache::TimelineCache(size_t _maxBytes)
+	{
+		maxBytes = _maxBytes;
+		bytes = 0;
+		hits = misses = 0;
+	}
+
+	TimelineCache::~TimelineCache()
+	{
+		clear();
+	}
+
+	bool TimelineCache::lookup(TimelineKey key, vector<TimeCPID>* row)
+	{
+		bool found = false;
+#pragma omp critical (timelineCache)
+		{
+			Index::iterator it = index.find(key);
+			if (it != index.end())
+			{
+				*row = it->second.row;
+				touch(it);
+				hits++;
+				found = true;
+			}
+			else
+				misses++;
+		}
+		return found;
+	}
+
+	void TimelineCache::insert(TimelineKey key, const vector<TimeCPID>& row)
+	{
+#pragma omp critical (timelineCache)
+		{
+			Index::iterator it = index.find(key);
+			if (it == index.end())
+			{
+				Entry& e = index[key];
+				e.row = row;
+				lru.push_front(key);
+				e.age = lru.begin();
+				bytes += ROW_BYTES(row);
+				evict();
+			}
+		}
+	}
+
+	void TimelineCache::clear()
+	{
+#pragma omp critical (timelineCache)
+		{
+			index.clear();
+			lru.clear();
+			bytes = 0;
+		}
+	}
+
+	void TimelineCache::touch(Index::iterator it)
+	{
+		lru.splice(lru.begin(), lru, it->second.age);
+	}
+
+	void TimelineCache::evict()
+	{
+		while (bytes > maxBytes && !lru.empty())
+		{
+			Index::iterator it = index.find(lru.back());
+			bytes -= ROW_BYTES(it->second.row);
+			index.erase(it);
+			lru.pop_back();
+		}
+	}
+
+	void TimelineCache::report(ostream& out)
+	{
+		long lookups = hits + misses;
+		if (lookups == 0)
+			return;
+		out << "Timeline cache: " << lookups << " rows requested, "
+				<< (100 * hits) / lookups << "% hits, "
+				<< index.size() << " rows (" << bytes / 1024 << " KB) cached" << endl;
+	}
+
+} /* namespace TraceviewerServer */
@@ -0,0 +1,143 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL: https://hpctoolkit.googlecode.com/svn/branches/hpctoolkit-hpcserver/src/tool/hpcserver/FilteredBaseData.hpp $
+// $Id: FilteredBaseData.hpp 4307 2013-07-18 17:04:52Z felipet1326@gmail.com $
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   A bounded cache of computed timeline rows.
+//
+// Description:
+//   Rows are keyed by the unfiltered rank, the start and length of the time
+//   range and the number of horizontal pixels. The rank a line shows depends
+//   on the filter set, but the samples of a rank do not, so rows stay valid
+//   across filter changes. A new database gets a new controller and with it
+//   an empty cache. The least recently used rows are dropped once the
+//   samples held exceed the memory budget.
+//
+//***************************************************************************
+
+#ifndef TIMELINECACHE_HPP_
+#define TIMELINECACHE_HPP_
+
+#include <list>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "TimeCPID.hpp"
+
+using std::list;
+using std::map;
+using std::ostream;
+using std::vector;
+
+namespace TraceviewerServer
+{
+	struct TimelineKey
+	{
+		int rank;
+		Time range;
+		int pixels;
+		Time start;
+
+		TimelineKey(int _rank, Time _start, Time _range, int _pixels)
+		{
+			rank = _rank;
+			start = _start;
+			range = _range;
+			pixels = _pixels;
+		}
+		bool operator<(const TimelineKey& o) const
+		{
+			if (rank != o.rank)
+				return rank < o.rank;
+			if (range != o.range)
+				return range < o.range;
+			if (pixels != o.pixels)
+				return pixels < o.pixels;
+			return start < o.start;
+		}
+	};
+
+	class TimelineCache
+	{
+	public:
+		TimelineCache(size_t _maxBytes);
+		virtual ~TimelineCache();
+
+		//Copies the row for key into row and returns true if it is cached
+		bool lookup(TimelineKey key, vector<TimeCPID>* row);
+		void insert(TimelineKey key, const vector<TimeCPID>& row);
+		void clear();
+
+		void report(ostream& out);
+	private:
+		typedef list<TimelineKey> LRU;
+		struct Entry
+		{
+			vector<TimeCPID> row;
+			LRU::iterator age;
+		};
+		typedef map<TimelineKey, Entry> Index;
+
+		void touch(Index::iterator it);
+		void evict();
+
+		Index index;
+		LRU lru;//Most recently used first
+		size_t bytes;
+		size_t maxBytes;
+
+		long hits;
+		long misses;
+	};
+
+} /* namespace TraceviewerServer */
+#endif /* TIMELINECACHE_HPP_ */
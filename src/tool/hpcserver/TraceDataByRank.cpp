@@ -83,6 +83,12 @@ namespace TraceviewerServer
 	void TraceDataByRank::getData(Time timeStart, Time timeRange,
 			double pixelLength)
 	{
+		// with --pyramid, zoomed-out views come straight from the precomputed
+		// pyramid, which replaces the binary search per pixel with one
+		// contiguous read
+		if (data->samplePyramid(rank, timeStart, pixelLength, numPixelsH, listCPID))
+			return;
+
 		// get the start location
 		FileOffset startLoc = findTimeInInterval(timeStart, minloc, maxloc);
 
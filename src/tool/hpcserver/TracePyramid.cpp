@@ -0,0 +1,428 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL: https://hpctoolkit.googlecode.com/svn/branches/hpctoolkit-hpcserver/src/tool/hpcserver/FilteredBaseData.cpp $
+// $Id: FilteredBaseData.cpp 4307 2013-07-18 17:04:52Z felipet1326@gmail.com $
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Builds and reads the level-of-detail pyramid of a merged trace file.
+//
+// Description:
+//   File layout (all values big endian, like the merged trace file):
+//      long magic, long size of the trace file, int header size,
+//      int number of ranks, int number of levels, long min time,
+//      long max time, then one long record count per rank.
+//   Then, for every level (coarsest first), for every rank, one
+//   (long time, int cpid) entry per bucket.
+//
+//***************************************************************************
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "TracePyramid.hpp"
+#include "ByteUtilities.hpp"
+#include "Constants.hpp"
+#include "DataOutputFileStream.hpp"
+#include "DebugUtils.hpp"
+
+using namespace std;
+
+namespace TraceviewerServer
+{
+	#define PYRAMID_SUFFIX ".lod"
+	#define FIXED_HEADER_SIZE (4 * SIZEOF_LONG + 3 * SIZEOF_INT)
+
+	//The header of each rank in the merged file is the header of its .hpctrace file
+	#define TRACE_MAGIC "HPCRUN-trace______"
+	#define TRACE_MAGIC_LEN 18
+	#define TRACE_OLD_VERSION "01.00"
+	#define TRACE_VERSION_LEN 5
+	#define TRACE_HEADER_SIZE_OLD 24
+	#define TRACE_HEADER_SIZE 32
+
+	//Reads the trace records of one rank front to back in large chunks
+	class RecordReader
+	{
+	public:
+		RecordReader(ifstream* _in, FileOffset start, Long _count)
+		{
+			in = _in;
+			remaining = _count;
+			pos = filled = 0;
+			in->seekg(start, ios_base::beg);
+		}
+		bool next(TimeCPID* rec)
+		{
+			if (pos == filled)
+			{
+				if (remaining == 0)
+					return false;
+				Long n = min(remaining, (Long) CHUNK_RECORDS);
+				in->read(buffer, n * SIZE_OF_TRACE_RECORD);
+				remaining -= n;
+				filled = n;
+				pos = 0;
+			}
+			char* r = buffer + pos * SIZE_OF_TRACE_RECORD;
+			rec->timestamp = ByteUtilities::readLong(r);
+			rec->cpid = ByteUtilities::readInt(r + SIZEOF_LONG);
+			pos++;
+			return true;
+		}
+	private:
+		static const int CHUNK_RECORDS = 8192;
+		ifstream* in;
+		Long remaining;
+		Long pos, filled;
+		char buffer[CHUNK_RECORDS * SIZE_OF_TRACE_RECORD];
+	};
+
+	static TimeCPID readRecord(ifstream* in, FileOffset loc)
+	{
+		char buffer[SIZE_OF_TRACE_RECORD];
+		in->seekg(loc, ios_base::beg);
+		in->read(buffer, SIZE_OF_TRACE_RECORD);
+		return TimeCPID(ByteUtilities::readLong(buffer),
+				ByteUtilities::readInt(buffer + SIZEOF_LONG));
+	}
+
+	static void writeEntry(char* buffer, TimeCPID entry)
+	{
+		ByteUtilities::writeLong(buffer, entry.timestamp);
+		ByteUtilities::writeInt(buffer + SIZEOF_LONG, entry.cpid);
+	}
+
+	bool TracePyramid::enabled = false;
+
+	string TracePyramid::pyramidFileName(string traceFile)
+	{
+		return traceFile + PYRAMID_SUFFIX;
+	}
+
+	int TracePyramid::detectHeaderSize(char* rankHeader)
+	{
+		if (memcmp(rankHeader, TRACE_MAGIC, TRACE_MAGIC_LEN) != 0)
+			return TRACE_HEADER_SIZE_OLD;
+		if (memcmp(rankHeader + TRACE_MAGIC_LEN, TRACE_OLD_VERSION, TRACE_VERSION_LEN) == 0)
+			return TRACE_HEADER_SIZE_OLD;
+		return TRACE_HEADER_SIZE;
+	}
+
+	FileOffset TracePyramid::levelOffset(int level, int numRanks)
+	{
+		//Level l has 2^(MIN_BUCKETS_LOG + l) buckets, so the levels before it
+		//hold 2^(MIN_BUCKETS_LOG + l) - 2^MIN_BUCKETS_LOG entries per rank
+		FileOffset entries = (1LL << (MIN_BUCKETS_LOG + level)) - (1LL << MIN_BUCKETS_LOG);
+		return entries * numRanks * ENTRY_SIZE;
+	}
+
+	bool TracePyramid::build(string traceFile)
+	{
+		if (!enabled)
+			return false;
+
+		string pyramidFile = pyramidFileName(traceFile);
+		remove(pyramidFile.c_str());
+
+		FileOffset traceSize = FileUtils::getFileSize(traceFile);
+		ifstream in(traceFile.c_str(), ios_base::binary | ios_base::in);
+		if (!in.good())
+			return false;
+
+		//-----------------------------------------------------
+		// 1. Find where the records of every rank are
+		//-----------------------------------------------------
+		char buffer[TRACE_HEADER_SIZE];
+		in.read(buffer, 2 * SIZEOF_INT);
+		int numRanks = ByteUtilities::readInt(buffer + SIZEOF_INT);
+		if (numRanks <= 0)
+			return false;
+
+		vector<FileOffset> starts(numRanks + 1);
+		for (int i = 0; i < numRanks; i++)
+		{
+			in.read(buffer, 2 * SIZEOF_INT + SIZEOF_LONG);
+			starts[i] = ByteUtilities::readLong(buffer + 2 * SIZEOF_INT);
+		}
+		starts[numRanks] = traceSize - SIZEOF_LONG;//The end-of-file marker
+
+		in.seekg(starts[0], ios_base::beg);
+		in.read(buffer, TRACE_HEADER_SIZE);
+		int headerSize = detectHeaderSize(buffer);
+
+		vector<Long> counts(numRanks);
+		Long maxCount = 0;
+		Time minTime = 0, maxTime = 0;
+		bool haveTime = false;
+		for (int i = 0; i < numRanks; i++)
+		{
+			Long bytes = (Long) (starts[i + 1] - starts[i]) - headerSize;
+			counts[i] = max(bytes / SIZE_OF_TRACE_RECORD, (Long) 0);
+			if (counts[i] == 0)
+				continue;
+			maxCount = max(maxCount, counts[i]);
+			Time first = readRecord(&in, starts[i] + headerSize).timestamp;
+			Time last = readRecord(&in, starts[i] + headerSize
+					+ (counts[i] - 1) * SIZE_OF_TRACE_RECORD).timestamp;
+			if (!haveTime || first < minTime)
+				minTime = first;
+			if (!haveTime || last > maxTime)
+				maxTime = last;
+			haveTime = true;
+		}
+
+		//Keep the pyramid well below the size of the densest rank: the levels
+		//together hold about twice the entries of the finest one
+		int finestLog = MIN_BUCKETS_LOG;
+		while (finestLog < MAX_BUCKETS_LOG && (4LL << (finestLog + 1)) <= maxCount)
+			finestLog++;
+		if (!haveTime || maxTime <= minTime || maxCount < (4LL << MIN_BUCKETS_LOG))
+		{
+			DEBUGCOUT(1) << "Trace too small for a pyramid" << endl;
+			return false;
+		}
+		int numLevels = finestLog - MIN_BUCKETS_LOG + 1;
+		int finestBuckets = 1 << finestLog;
+		double width = (double) (maxTime - minTime) / finestBuckets;
+
+		//-----------------------------------------------------
+		// 2. Write the header
+		//-----------------------------------------------------
+		DataOutputFileStream dos(pyramidFile.c_str());
+		dos.writeLong(MAGIC);
+		dos.writeLong(traceSize);
+		dos.writeInt(headerSize);
+		dos.writeInt(numRanks);
+		dos.writeInt(numLevels);
+		dos.writeLong(minTime);
+		dos.writeLong(maxTime);
+		for (int i = 0; i < numRanks; i++)
+			dos.writeLong(counts[i]);
+		FileOffset dataStart = FIXED_HEADER_SIZE + (FileOffset) numRanks * SIZEOF_LONG;
+
+		//-----------------------------------------------------
+		// 3. One pass over the records of each rank computes the finest
+		//	level; the coarser levels are every other entry of the next
+		//	finer one.
+		//-----------------------------------------------------
+		vector<TimeCPID> finest(finestBuckets, TimeCPID(0, 0));
+		vector<char> out((size_t) finestBuckets * ENTRY_SIZE);
+		for (int rank = 0; rank < numRanks; rank++)
+		{
+			if (counts[rank] > 0)
+			{
+				RecordReader reader(&in, starts[rank] + headerSize, counts[rank]);
+				TimeCPID cur(0, 0), next(0, 0);
+				reader.next(&cur);
+				bool haveNext = reader.next(&next);
+				for (int b = 0; b < finestBuckets; b++)
+				{
+					Time bucketStart = minTime + (Time) (b * width);
+					while (haveNext && next.timestamp <= bucketStart)
+					{
+						cur = next;
+						haveNext = reader.next(&next);
+					}
+					//Same choice as TraceDataByRank::findTimeInInterval: the closer
+					//of the two records around the time, the right one on ties
+					if (haveNext && cur.timestamp <= bucketStart
+							&& next.timestamp - bucketStart <= bucketStart - cur.timestamp)
+						finest[b] = next;
+					else
+						finest[b] = cur;
+				}
+			}
+			for (int level = 0; level < numLevels; level++)
+			{
+				int buckets = 1 << (MIN_BUCKETS_LOG + level);
+				int stride = finestBuckets / buckets;
+				for (int b = 0; b < buckets; b++)
+					writeEntry(&out[(size_t) b * ENTRY_SIZE], finest[(size_t) b * stride]);
+				dos.seekp(dataStart + levelOffset(level, numRanks)
+						+ (FileOffset) rank * buckets * ENTRY_SIZE, ios_base::beg);
+				dos.write(&out[0], (streamsize) buckets * ENTRY_SIZE);
+			}
+		}
+		dos.close();
+		in.close();
+		DEBUGCOUT(1) << "Built a " << numLevels << " level pyramid for " << numRanks
+				<< " ranks" << endl;
+		return true;
+	}
+
+	TracePyramid* TracePyramid::open(string traceFile, int headerSize)
+	{
+		string pyramidFile = pyramidFileName(traceFile);
+		if (!enabled || !FileUtils::exists(pyramidFile))
+			return NULL;
+		int fd = ::open(pyramidFile.c_str(), O_RDONLY);
+		if (fd < 0)
+			return NULL;
+		TracePyramid* pyramid = new TracePyramid(fd);
+		if (!pyramid->readHeader(FileUtils::getFileSize(traceFile), headerSize))
+		{
+			DEBUGCOUT(1) << "Ignoring stale pyramid " << pyramidFile << endl;
+			delete pyramid;
+			return NULL;
+		}
+		return pyramid;
+	}
+
+	TracePyramid::TracePyramid(int _fd)
+	{
+		fd = _fd;
+		numRanks = numLevels = 0;
+		minTime = maxTime = 0;
+		dataStart = 0;
+	}
+
+	bool TracePyramid::readHeader(FileOffset traceSize, int headerSize)
+	{
+		char buffer[FIXED_HEADER_SIZE];
+		if (pread(fd, buffer, FIXED_HEADER_SIZE, 0) != FIXED_HEADER_SIZE)
+			return false;
+		char* p = buffer;
+		uint64_t magic = ByteUtilities::readLong(p);
+		FileOffset builtFrom = ByteUtilities::readLong(p += SIZEOF_LONG);
+		int builtHeaderSize = ByteUtilities::readInt(p += SIZEOF_LONG);
+		numRanks = ByteUtilities::readInt(p += SIZEOF_INT);
+		numLevels = ByteUtilities::readInt(p += SIZEOF_INT);
+		minTime = ByteUtilities::readLong(p += SIZEOF_INT);
+		maxTime = ByteUtilities::readLong(p += SIZEOF_LONG);
+
+		//The pyramid belongs to a different (e.g. re-merged) trace file
+		if (magic != MAGIC || builtFrom != traceSize || builtHeaderSize != headerSize)
+			return false;
+		if (numRanks <= 0 || numLevels <= 0
+				|| numLevels > MAX_BUCKETS_LOG - MIN_BUCKETS_LOG + 1 || maxTime <= minTime)
+			return false;
+
+		vector<char> counts((size_t) numRanks * SIZEOF_LONG);
+		if (pread(fd, &counts[0], counts.size(), FIXED_HEADER_SIZE) != (ssize_t) counts.size())
+			return false;
+		recordCount.resize(numRanks);
+		for (int i = 0; i < numRanks; i++)
+			recordCount[i] = ByteUtilities::readLong(&counts[(size_t) i * SIZEOF_LONG]);
+		dataStart = FIXED_HEADER_SIZE + counts.size();
+		return true;
+	}
+
+	bool TracePyramid::sample(int rank, Time timeStart, double pixelLength, int numPixels,
+			vector<TimeCPID>* list)
+	{
+		if (rank < 0 || rank >= numRanks || numPixels <= 0)
+			return false;
+		//Sparse ranks are cheap to read directly, and that shows every record
+		if (recordCount[rank] <= numPixels)
+			return false;
+
+		//The coarsest level whose buckets are no wider than a pixel
+		Time range = maxTime - minTime;
+		int level = 0;
+		while (level < numLevels && range / (double) (1 << (MIN_BUCKETS_LOG + level)) > pixelLength)
+			level++;
+		if (level == numLevels)
+			return false;
+		int buckets = 1 << (MIN_BUCKETS_LOG + level);
+		double width = range / (double) buckets;
+
+		//Like sampleTimeLine, sample the interior pixels and add one sample
+		//beyond each end of the view so the edges of the timeline are drawn
+		vector<int> pixelBucket;
+		Long firstBucket = bucketOf(timeStart, width) - 1;
+		if (firstBucket >= 0)
+			pixelBucket.push_back(firstBucket);
+		for (int p = 1; p < numPixels; p++)
+			pixelBucket.push_back(min(bucketOf(timeStart + (Time) (p * pixelLength), width),
+					(Long) buckets - 1));
+		Long lastBucket = bucketOf(timeStart + (Time) (numPixels * pixelLength), width) + 1;
+		if (lastBucket < buckets)
+			pixelBucket.push_back(lastBucket);
+		if (pixelBucket.empty())
+			return false;
+
+		//The samples are one contiguous run of entries in the file
+		int first = pixelBucket.front();
+		int last = pixelBucket.back();
+		size_t bytes = (size_t) (last - first + 1) * ENTRY_SIZE;
+		vector<char> entries(bytes);
+		FileOffset loc = dataStart + levelOffset(level, numRanks)
+				+ ((FileOffset) rank * buckets + first) * ENTRY_SIZE;
+		if (pread(fd, &entries[0], bytes, loc) != (ssize_t) bytes)
+			return false;
+
+		for (size_t p = 0; p < pixelBucket.size(); p++)
+		{
+			char* e = &entries[(size_t) (pixelBucket[p] - first) * ENTRY_SIZE];
+			TimeCPID next(ByteUtilities::readLong(e), ByteUtilities::readInt(e + SIZEOF_LONG));
+			if (list->empty() || list->back().timestamp != next.timestamp)
+				list->push_back(next);
+		}
+		return true;
+	}
+
+	//The bucket whose start is closest to t
+	Long TracePyramid::bucketOf(Time t, double width)
+	{
+		if (t <= minTime)
+			return 0;
+		return (Long) ((t - minTime) / width + 0.5);
+	}
+
+	TracePyramid::~TracePyramid()
+	{
+		close(fd);
+	}
+
+} /* namespace TraceviewerServer */
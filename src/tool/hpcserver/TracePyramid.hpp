@@ -0,0 +1,134 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL: https://hpctoolkit.googlecode.com/svn/branches/hpctoolkit-hpcserver/src/tool/hpcserver/FilteredBaseData.hpp $
+// $Id: FilteredBaseData.hpp 4307 2013-07-18 17:04:52Z felipet1326@gmail.com $
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   A precomputed level-of-detail pyramid for the merged trace file.
+//
+// Description:
+//   For every rank, each level holds one trace record per time bucket, and
+//   each level has twice the buckets of the level before it.  The entry of a
+//   bucket is the record closest to the start of the bucket, which is what
+//   TraceDataByRank::sampleTimeLine would pick for a pixel at that time.
+//   Zoomed-out views can then be served from one contiguous read of the
+//   coarsest adequate level instead of a binary search per pixel.
+//
+//   The pyramid lives next to the trace file (experiment.mt.lod) and is
+//   only used when it matches the trace file it was built from.
+//
+//   Buckets do not line up with the pixels of a request, so a timeline
+//   sampled from the pyramid can differ slightly from one sampled from
+//   the trace.  The pyramid is therefore only built and used when enabled
+//   (hpcserver --pyramid).
+//
+//***************************************************************************
+
+#ifndef TRACEPYRAMID_HPP_
+#define TRACEPYRAMID_HPP_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "TimeCPID.hpp"
+#include "FileUtils.hpp"//For FileOffset
+
+using std::string;
+using std::vector;
+
+namespace TraceviewerServer
+{
+	class TracePyramid
+	{
+	public:
+		//Returns NULL if there is no usable pyramid for traceFile
+		static TracePyramid* open(string traceFile, int headerSize);
+		//Builds (or rebuilds) the pyramid of a merged trace file
+		static bool build(string traceFile);
+		static string pyramidFileName(string traceFile);
+
+		//Set by --pyramid; when false, open returns NULL and build does nothing
+		static bool enabled;
+
+		virtual ~TracePyramid();
+
+		/**
+		 * Fills list with the samples of rank for numPixels pixels of width
+		 * pixelLength starting at timeStart. Returns false, leaving list
+		 * untouched, if no level is fine enough for this view or if the rank
+		 * has few enough records that they should all be read directly.
+		 */
+		bool sample(int rank, Time timeStart, double pixelLength, int numPixels,
+				vector<TimeCPID>* list);
+
+		static const int MIN_BUCKETS_LOG = 8;
+		static const int MAX_BUCKETS_LOG = 12;
+	private:
+		TracePyramid(int _fd);
+		bool readHeader(FileOffset traceSize, int headerSize);
+		int64_t bucketOf(Time t, double width);
+
+		static int detectHeaderSize(char* rankHeader);
+		static FileOffset levelOffset(int level, int numRanks);
+
+		int fd;
+		int numRanks;
+		int numLevels;
+		Time minTime;
+		Time maxTime;
+		vector<int64_t> recordCount;
+		FileOffset dataStart;
+
+		static const uint64_t MAGIC = 0x48504354504C4F44ULL;//"HPCTPLOD"
+		static const int ENTRY_SIZE = 12;
+	};
+} /* namespace TraceviewerServer */
+#endif /* TRACEPYRAMID_HPP_ */
@@ -0,0 +1,193 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL: https://hpctoolkit.googlecode.com/svn/branches/hpctoolkit-hpcserver/src/tool/hpcserver/TraceStatistics.cpp $
+// $Id: TraceStatistics.cpp 4307 2013-07-18 17:04:52Z felipet1326@gmail.com $
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Summary of the timelines of a data request.
+//
+// Description:
+//   The packed form is also what is sent to the client, all big-endian:
+//     int lines, int columns,
+//     for each column: int n, then n x (int cpid, int lines),
+//     int n, then n x (int cpid, long time)
+//
+//***************************************************************************
+
+#include "TraceStatistics.hpp"
+#include "ByteUtilities.hpp"
+#include "Constants.hpp"
+
+#include <algorithm> //For max, min
+
+using namespace std;
+
+namespace TraceviewerServer
+{
+	static void appendInt(vector<char>* buffer, int value)
+	{
+		size_t pos = buffer->size();
+		buffer->resize(pos + SIZEOF_INT);
+		ByteUtilities::writeInt(&(*buffer)[pos], value);
+	}
+
+	static void appendLong(vector<char>* buffer, Time value)
+	{
+		size_t pos = buffer->size();
+		buffer->resize(pos + SIZEOF_LONG);
+		ByteUtilities::writeLong(&(*buffer)[pos], value);
+	}
+
+	TraceStatistics::TraceStatistics(Time _begTime, Time _endTime, int _numColumns)
+	{
+		begTime = _begTime;
+		endTime = _endTime;
+		numColumns = max(_numColumns, 0);
+		pixelLength = numColumns > 0 ? (endTime - begTime) / (double) numColumns : 0;
+		numLines = 0;
+		columns.resize(numColumns);
+	}
+
+	TraceStatistics::~TraceStatistics()
+	{
+	}
+
+	void TraceStatistics::add(const vector<TimeCPID>& samples)
+	{
+		numLines++;
+		int column = 0;
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			//Sample i lasts until the next one, or to the end of the window
+			Time start = samples[i].timestamp;
+			Time end = (i + 1 < samples.size()) ? samples[i + 1].timestamp : endTime;
+			int cpid = samples[i].cpid;
+
+			Time from = max(start, begTime);
+			Time to = min(end, endTime);
+			if (to > from)
+				totals[cpid] += to - from;
+
+			//Every column that starts while this sample is current shows it
+			while (column < numColumns && begTime + column * pixelLength < end)
+			{
+				if (begTime + column * pixelLength >= start)
+					columns[column][cpid]++;
+				column++;
+			}
+		}
+	}
+
+	void TraceStatistics::merge(const TraceStatistics& other)
+	{
+		numLines += other.numLines;
+		for (int c = 0; c < numColumns && c < other.numColumns; c++)
+		{
+			map<int, int>::const_iterator it;
+			for (it = other.columns[c].begin(); it != other.columns[c].end(); ++it)
+				columns[c][it->first] += it->second;
+		}
+		map<int, Time>::const_iterator it;
+		for (it = other.totals.begin(); it != other.totals.end(); ++it)
+			totals[it->first] += it->second;
+	}
+
+	void TraceStatistics::pack(vector<char>* buffer) const
+	{
+		appendInt(buffer, numLines);
+		appendInt(buffer, numColumns);
+		for (int c = 0; c < numColumns; c++)
+		{
+			appendInt(buffer, columns[c].size());
+			map<int, int>::const_iterator it;
+			for (it = columns[c].begin(); it != columns[c].end(); ++it)
+			{
+				appendInt(buffer, it->first);
+				appendInt(buffer, it->second);
+			}
+		}
+		appendInt(buffer, totals.size());
+		map<int, Time>::const_iterator it;
+		for (it = totals.begin(); it != totals.end(); ++it)
+		{
+			appendInt(buffer, it->first);
+			appendLong(buffer, it->second);
+		}
+	}
+
+	void TraceStatistics::unpack(char* buffer, int length)
+	{
+		char* end = buffer + length;
+		numLines += ByteUtilities::readInt(buffer);
+		int packedColumns = ByteUtilities::readInt(buffer + SIZEOF_INT);
+		buffer += 2 * SIZEOF_INT;
+		for (int c = 0; c < packedColumns && buffer < end; c++)
+		{
+			int n = ByteUtilities::readInt(buffer);
+			buffer += SIZEOF_INT;
+			for (int i = 0; i < n; i++, buffer += 2 * SIZEOF_INT)
+				if (c < numColumns)
+					columns[c][ByteUtilities::readInt(buffer)] += ByteUtilities::readInt(buffer + SIZEOF_INT);
+		}
+		if (buffer >= end)
+			return;
+		int n = ByteUtilities::readInt(buffer);
+		buffer += SIZEOF_INT;
+		for (int i = 0; i < n; i++, buffer += SIZEOF_INT + SIZEOF_LONG)
+			totals[ByteUtilities::readInt(buffer)] += ByteUtilities::readLong(buffer + SIZEOF_INT);
+	}
+
+	void TraceStatistics::write(DataSocketStream* stream) const
+	{
+		vector<char> buffer;
+		pack(&buffer);
+		stream->writeRawData(&buffer[0], buffer.size());
+	}
+
+} /* namespace TraceviewerServer */
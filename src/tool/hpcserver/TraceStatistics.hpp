@@ -0,0 +1,109 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL: https://hpctoolkit.googlecode.com/svn/branches/hpctoolkit-hpcserver/src/tool/hpcserver/TraceStatistics.hpp $
+// $Id: TraceStatistics.hpp 4307 2013-07-18 17:04:52Z felipet1326@gmail.com $
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Summary of the timelines of a data request.
+//
+// Description:
+//   Instead of the rows themselves, a STAT request gets, for each pixel
+//   column, how many of the sampled ranks were in each call path, and for
+//   each call path the total time the sampled ranks spent in it over the
+//   window. Each worker (or MPI rank) summarizes its own lines and the
+//   partial results are merged, so only the aggregate crosses the network.
+//
+//***************************************************************************
+
+#ifndef TRACESTATISTICS_HPP_
+#define TRACESTATISTICS_HPP_
+
+#include <map>
+#include <vector>
+
+#include "DataSocketStream.hpp"
+#include "TimeCPID.hpp"
+
+using std::map;
+using std::vector;
+
+namespace TraceviewerServer
+{
+	class TraceStatistics
+	{
+	public:
+		//begTime and endTime are absolute, like the timestamps of the samples
+		TraceStatistics(Time _begTime, Time _endTime, int _numColumns);
+		virtual ~TraceStatistics();
+
+		//Adds the sampled timeline of one line
+		void add(const vector<TimeCPID>& samples);
+		void merge(const TraceStatistics& other);
+
+		//The MPI ranks send their partial statistics to the socket server as
+		//a flat buffer
+		void pack(vector<char>* buffer) const;
+		void unpack(char* buffer, int length);
+
+		void write(DataSocketStream* stream) const;
+	private:
+		Time begTime;
+		Time endTime;
+		int numColumns;
+		double pixelLength;
+
+		int numLines;
+		//cpid -> number of lines in that call path, per column
+		vector<map<int, int> > columns;
+		//cpid -> time spent
+		map<int, Time> totals;
+	};
+
+} /* namespace TraceviewerServer */
+#endif /* TRACESTATISTICS_HPP_ */
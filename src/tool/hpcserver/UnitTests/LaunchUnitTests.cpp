@@ -57,14 +57,25 @@
 //
 //***************************************************************************
 
+#include <string>
+using std::string;
+
 extern void filterTest();
 extern void progBarTest();
 extern void compressionTest();
 extern void lruTest();
+extern void timelineCacheTest();
+extern void timelineScalingBench();
 
 int main(int argc, char** argv)
 {
+	if (argc > 1 && string(argv[1]) == "bench")
+	{
+		timelineScalingBench();
+		return 0;
+	}
 	lruTest();
+	timelineCacheTest();
 	compressionTest();
 	progBarTest();
 	filterTest();
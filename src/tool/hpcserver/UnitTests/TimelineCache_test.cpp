@@ -0,0 +1,190 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL$
+// $Id$
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Checks that cached timelines match timelines read from the trace.
+//
+// Description:
+//   Pans, zooms and revisits views of a synthetic trace with the timeline
+//   cache on and off, and requires every row to be identical.
+//
+//***************************************************************************
+
+
+#undef NDEBUG
+
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+#include "../Constants.hpp"
+#include "../DataOutputFileStream.hpp"
+#include "../FileData.hpp"
+#include "../FileUtils.hpp"
+#include "../ImageTraceAttributes.hpp"
+#include "../MergeDataFiles.hpp"
+#include "../ProcessTimeline.hpp"
+#include "../SpaceTimeDataController.hpp"
+
+using namespace std;
+using namespace TraceviewerServer;
+
+#define CACHE_RANKS    8
+#define CACHE_RECORDS  20000
+#define CACHE_HEADER   24
+#define CACHE_BEG_TIME 1000000
+
+//Irregular gaps between records, so that the sample chosen for a pixel
+//depends on exactly where the pixel starts
+static Long recordTime(int rank, int i)
+{
+	return CACHE_BEG_TIME + (Long) i * 100 + (i * 37 + rank * 11) % 61;
+}
+
+static void writeCacheTraces(string dir)
+{
+	for (int rank = 0; rank < CACHE_RANKS; rank++)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "cache-%06d-000-0-0-0.hpctrace", rank);
+		string path = FileUtils::combinePaths(dir, name);
+		DataOutputFileStream dos(path.c_str());
+		for (int i = 0; i < CACHE_HEADER / SIZEOF_INT; i++)
+			dos.writeInt(0);
+		for (int i = 0; i < CACHE_RECORDS; i++)
+		{
+			dos.writeLong(recordTime(rank, i));
+			dos.writeInt((i * 13 + rank) % 89);
+		}
+		dos.close();
+	}
+}
+
+static void requestView(SpaceTimeDataController* contr, Time begTime, Time endTime,
+		int pixels)
+{
+	ImageTraceAttributes* attr = contr->attributes;
+	attr->begProcess = 0;
+	attr->endProcess = CACHE_RANKS;
+	attr->numPixelsH = pixels;
+	attr->numPixelsV = CACHE_RANKS;
+	attr->begTime = begTime;
+	attr->endTime = endTime;
+	attr->lineNum = 0;
+	contr->fillTraces();
+}
+
+static void compareRows(SpaceTimeDataController* cached, SpaceTimeDataController* uncached)
+{
+	assert(cached->tracesLength == uncached->tracesLength);
+	for (int i = 0; i < cached->tracesLength; i++)
+	{
+		vector<TimeCPID>& a = *cached->traces[i]->data->listCPID;
+		vector<TimeCPID>& b = *uncached->traces[i]->data->listCPID;
+		assert(a.size() == b.size());
+		for (size_t j = 0; j < a.size(); j++)
+		{
+			assert(a[j].timestamp == b[j].timestamp);
+			assert(a[j].cpid == b[j].cpid);
+		}
+	}
+}
+
+void timelineCacheTest()
+{
+	char dirTemplate[] = "/tmp/hpcserver-cache-XXXXXX";
+	char* dir = mkdtemp(dirTemplate);
+	assert(dir != NULL);
+
+	writeCacheTraces(dir);
+	string merged = FileUtils::combinePaths(dir, "experiment.mt");
+	MergeDataAttribute status = MergeDataFiles::merge(dir, "*.hpctrace", merged);
+	assert(status == SUCCESS_MERGED);
+
+	FileData location;
+	location.fileTrace = merged;
+	Time traceEnd = (Time) CACHE_RECORDS * 100;
+
+	SpaceTimeDataController cached(&location);
+	cached.setCacheSize(64 << 20);
+	cached.setInfo(CACHE_BEG_TIME, CACHE_BEG_TIME + traceEnd, CACHE_HEADER);
+	SpaceTimeDataController uncached(&location);
+	uncached.setCacheSize(0);
+	uncached.setInfo(CACHE_BEG_TIME, CACHE_BEG_TIME + traceEnd, CACHE_HEADER);
+
+	//Pans by amounts that are not a whole number of pixels, in both
+	//directions, then revisits earlier views so that they hit the cache
+	const int pixels = 700;
+	Time range = traceEnd / 5;
+	Time begTime = traceEnd / 10;
+	Time pans[] = { range / 7, range / 3 + 13, -(range / 5), range / 11, -(range / 2) - 1,
+			range / 7, 0, -(range / 7) };
+	int numPans = sizeof(pans) / sizeof(pans[0]);
+	for (int round = 0; round < 2; round++)
+	{
+		Time t = begTime;
+		for (int p = 0; p <= numPans; p++)
+		{
+			requestView(&cached, t, t + range, pixels);
+			requestView(&uncached, t, t + range, pixels);
+			compareRows(&cached, &uncached);
+			if (p < numPans)
+				t += pans[p];
+		}
+	}
+
+	//A different zoom level of the same region
+	requestView(&cached, begTime, begTime + range / 4, pixels);
+	requestView(&uncached, begTime, begTime + range / 4, pixels);
+	compareRows(&cached, &uncached);
+
+	vector<string> files = FileUtils::getAllFilesInDir(dir);
+	for (size_t i = 0; i < files.size(); i++)
+		unlink(files[i].c_str());
+	rmdir(dir);
+	cout << "Cached timelines were identical to timelines read from the trace" << endl;
+}
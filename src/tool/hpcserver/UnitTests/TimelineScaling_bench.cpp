@@ -0,0 +1,248 @@
+// -*-Mode: C++;-*-
+
+// * BeginRiceCopyright *****************************************************
+//
+// $HeadURL$
+// $Id$
+//
+// --------------------------------------------------------------------------
+// Part of HPCToolkit (hpctoolkit.org)
+//
+// Information about sources of support for research and development of
+// HPCToolkit is at 'hpctoolkit.org' and in 'README.Acknowledgments'.
+// --------------------------------------------------------------------------
+//
+// Copyright ((c)) 2002-2022, Rice University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// * Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the distribution.
+//
+// * Neither the name of Rice University (RICE) nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// This software is provided by RICE and contributors "as is" and any
+// express or implied warranties, including, but not limited to, the
+// implied warranties of merchantability and fitness for a particular
+// purpose are disclaimed. In no event shall RICE or contributors be
+// liable for any direct, indirect, incidental, special, exemplary, or
+// consequential damages (including, but not limited to, procurement of
+// substitute goods or services; loss of use, data, or profits; or
+// business interruption) however caused and on any theory of liability,
+// whether in contract, strict liability, or tort (including negligence
+// or otherwise) arising in any way out of the use of this software, even
+// if advised of the possibility of such damage.
+//
+// ******************************************************* EndRiceCopyright *
+
+//***************************************************************************
+//
+// File:
+//   $HeadURL$
+//
+// Purpose:
+//   Scaling benchmark for the multithreaded timeline computation.
+//
+// Description:
+//   Builds a synthetic trace database and times the merge and fillTraces()
+//   for an increasing number of threads, checking that every worker count
+//   produces the same timelines as the serial path. Also reports the size
+//   and CPU time of each compression type for one full data request.
+//
+//***************************************************************************
+
+
+#undef NDEBUG
+
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <ctime>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../Constants.hpp"
+#include "../DataCompressionLayer.hpp"
+#include "../DataOutputFileStream.hpp"
+#include "../FileData.hpp"
+#include "../FileUtils.hpp"
+#include "../ImageTraceAttributes.hpp"
+#include "../MergeDataFiles.hpp"
+#include "../ProcessTimeline.hpp"
+#include "../SpaceTimeDataController.hpp"
+#include "../TimeCPID.hpp"
+#include "../TraceDataByRank.hpp"
+#include "../TracePyramid.hpp"
+
+#include <lib/prof-lean/usec_time.h>
+
+using namespace std;
+using namespace TraceviewerServer;
+
+#define BENCH_RANKS     512
+#define BENCH_RECORDS   20000
+#define BENCH_HEADER    24
+#define BENCH_BEG_TIME  1000000
+#define BENCH_STEP      100
+#define BENCH_PIXELS_H  2000
+
+//Writes one .hpctrace file per rank, named so that MergeDataFiles picks up
+//the rank from the usual position in the file name.
+static void writeSyntheticTraces(string dir)
+{
+	for (int rank = 0; rank < BENCH_RANKS; rank++)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "bench-%06d-000-0-0-0.hpctrace", rank);
+		string path = FileUtils::combinePaths(dir, name);
+		DataOutputFileStream dos(path.c_str());
+		for (int i = 0; i < BENCH_HEADER / SIZEOF_INT; i++)
+			dos.writeInt(0);
+		for (int i = 0; i < BENCH_RECORDS; i++)
+		{
+			dos.writeLong(BENCH_BEG_TIME + (Long) i * BENCH_STEP);
+			dos.writeInt((i * 7 + rank) % 97);
+		}
+		dos.close();
+	}
+}
+
+static unsigned long checksum(SpaceTimeDataController* contr)
+{
+	unsigned long sum = 0;
+	for (int i = 0; i < contr->tracesLength; i++)
+	{
+		ProcessTimeline* t = contr->traces[i];
+		assert(t != NULL && t->line() == i);
+		vector<TimeCPID>* list = t->data->listCPID;
+		for (size_t j = 0; j < list->size(); j++)
+			sum = sum * 31 + (*list)[j].timestamp + (*list)[j].cpid;
+	}
+	return sum;
+}
+
+static void compressionBench(SpaceTimeDataController* contr)
+{
+	struct { const char* name; int level; bool packed; } types[] = {
+		{ "deflate, level 6", 6, false },
+		{ "deflate, level 1", 1, false },
+		{ "packed, level 6", 6, true },
+		{ "packed, level 1", 1, true }
+	};
+	long rawBytes = 0;
+	for (int i = 0; i < contr->tracesLength; i++)
+		rawBytes += contr->traces[i]->data->listCPID->size() * SIZEOF_DELTASAMPLE;
+	cout << "uncompressed: " << rawBytes << " bytes" << endl;
+
+	for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++)
+	{
+		long bytes = 0;
+		clock_t start = clock();
+		for (int i = 0; i < contr->tracesLength; i++)
+		{
+			DataCompressionLayer compr(types[t].level, false, NULL);
+			compr.writeSamples(*contr->traces[i]->data->listCPID, types[t].packed);
+			compr.flush();
+			bytes += compr.getOutputLength();
+		}
+		double cpu = (double)(clock() - start) / CLOCKS_PER_SEC;
+		cout << types[t].name << ": " << bytes << " bytes  cpu: " << cpu << " s" << endl;
+	}
+}
+
+void timelineScalingBench()
+{
+	char dirTemplate[] = "/tmp/hpcserver-bench-XXXXXX";
+	char* dir = mkdtemp(dirTemplate);
+	assert(dir != NULL);
+
+	int maxWorkers = 1;
+#ifdef _OPENMP
+	maxWorkers = omp_get_max_threads();
+#endif
+
+	//The merge removes its input, so every round starts from fresh files
+	string merged = FileUtils::combinePaths(dir, "experiment.mt");
+	double serialMerge = 0;
+	for (int workers = 1; workers <= maxWorkers; workers *= 2)
+	{
+		remove(merged.c_str());
+		writeSyntheticTraces(dir);
+#ifdef _OPENMP
+		omp_set_num_threads(workers);
+#endif
+		unsigned long start = usec_time();
+		MergeDataAttribute status = MergeDataFiles::merge(dir, "*.hpctrace", merged);
+		double elapsed = (usec_time() - start) / 1e6;
+		assert(status == SUCCESS_MERGED);
+		if (workers == 1)
+			serialMerge = elapsed;
+		cout << endl << "merge threads: " << workers << "  time: " << elapsed
+				<< " s  speedup: " << serialMerge / elapsed << endl;
+	}
+#ifdef _OPENMP
+	omp_set_num_threads(maxWorkers);
+#endif
+	//Time the sampling of the raw records, not the pyramid lookups
+	remove(TracePyramid::pyramidFileName(merged).c_str());
+
+	FileData location;
+	location.fileTrace = merged;
+
+	Time endTime = (Time) BENCH_RECORDS * BENCH_STEP;
+
+	unsigned long serialSum = 0;
+	double serialTime = 0;
+	for (int workers = 1; workers <= maxWorkers; workers *= 2)
+	{
+		SpaceTimeDataController contr(&location);
+		contr.setNumWorkers(workers);
+		contr.setInfo(BENCH_BEG_TIME, BENCH_BEG_TIME + endTime, BENCH_HEADER);
+
+		ImageTraceAttributes* attr = contr.attributes;
+		attr->begProcess = 0;
+		attr->endProcess = BENCH_RANKS;
+		attr->numPixelsH = BENCH_PIXELS_H;
+		attr->numPixelsV = BENCH_RANKS;
+		attr->begTime = 0;
+		attr->endTime = endTime;
+
+		unsigned long start = usec_time();
+		contr.fillTraces();
+		double elapsed = (usec_time() - start) / 1e6;
+
+		unsigned long sum = checksum(&contr);
+		if (workers == 1)
+		{
+			serialSum = sum;
+			serialTime = elapsed;
+		}
+		assert(sum == serialSum);
+
+		cout << "workers: " << contr.getNumWorkers() << "  time: " << elapsed
+				<< " s  speedup: " << serialTime / elapsed << endl;
+		if (workers == 1)
+			compressionBench(&contr);
+	}
+
+	vector<string> files = FileUtils::getAllFilesInDir(dir);
+	for (size_t i = 0; i < files.size(); i++)
+		unlink(files[i].c_str());
+	rmdir(dir);
+	cout << "Timelines were identical for every worker count" << endl;
+}
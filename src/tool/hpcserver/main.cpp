@@ -62,6 +62,7 @@
 #include "Constants.hpp"
 #include "Args.hpp"
 #include "DebugUtils.hpp"
+#include "TracePyramid.hpp"
 
 using namespace std;
 
@@ -71,9 +72,13 @@ int main(int argc, char *argv[])
 		return 0;
 
 	Args args(argc, argv);
-	TraceviewerServer::useCompression = args.compression;
+	TraceviewerServer::requestedCompressionType = args.compressionType;
+	TraceviewerServer::compressionLevel = args.compressionLevel;
 	TraceviewerServer::xmlPortNumber = args.xmlPort;
 	TraceviewerServer::mainPortNumber = args.mainPort;
+	TraceviewerServer::numWorkerThreads = args.jobs;
+	TraceviewerServer::timelineCacheSize = (size_t) args.cacheSize << 20;
+	TraceviewerServer::TracePyramid::enabled = args.pyramid;
 
 	try
 	{
@@ -132,6 +132,10 @@ CmdLineParser::OptArgDesc Args::optArgs[] = {
   // Output options
   { 'o', "output",        CLP::ARG_REQ , CLP::DUPOPT_CLOB, NULL,
      NULL },
+  {  0 , "reuse",         CLP::ARG_REQ , CLP::DUPOPT_CLOB, NULL,
+     NULL },
+  {  0 , "mem-limit",     CLP::ARG_REQ , CLP::DUPOPT_CLOB, NULL,
+     NULL },
 
   // General
   { 'v', "verbose",       CLP::ARG_OPT,  CLP::DUPOPT_CLOB, NULL,
@@ -185,6 +189,7 @@ Args::Ctor()
   meas_dir = "";
   is_from_makefile = false;
   cache_stat = CACHE_DISABLED;
+  mem_limit = 0;
 }
 
 
@@ -379,6 +384,17 @@ Args::parse(int argc, const char* const argv[])
     if (parser.isOpt("output")) {
       out_filenm = parser.getOptArg("output");
     }
+    if (parser.isOpt("reuse")) {
+      reuse_filenm = parser.getOptArg("reuse");
+    }
+    if (parser.isOpt("mem-limit")) {
+      const string & arg = parser.getOptArg("mem-limit");
+      long meg = CmdLineParser::toLong(arg);
+      if (meg < 1) {
+	ARG_ERROR("invalid argument for --mem-limit: '" << arg << "'");
+      }
+      mem_limit = (unsigned long) meg << 20;
+    }
 
     // Check for required arguments
     if (parser.getNumArgs() != 1) {
@@ -137,6 +137,8 @@ public:
   // Parsed Data: arguments
   std::string in_filenm;
   std::string out_filenm;
+  std::string reuse_filenm;
+  unsigned long mem_limit;        // bytes, default: 0 (no limit)
   std::string cache_directory;
 
 private:
@@ -46,7 +46,9 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <dirent.h>
+#include <fcntl.h>
 
 #include <iostream>
 using std::cerr;
@@ -60,6 +62,9 @@ using std::endl;
 #include <streambuf>
 #include <new>
 #include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
 
 #include <string.h>
 #include <unistd.h>
@@ -80,18 +85,52 @@ using namespace std;
 
 // Function prototypes
 static void create_structs_directory ( string &structs_dir);
-static void open_makefile ( string &makefile_name, fstream &makefile);
 static void verify_measurements_directory(string &measurements_dir);
 
-// Contents of Makefile to be generated for the directory
-static const char* analysis_makefile =
-#include "pmake.h"
-;
+//
+// A unit of work for the measurements-directory scheduler: either an
+// hpcrun file whose load modules are to be listed, or a CPU or GPU
+// binary to be analyzed.  Each job runs in a child process that is
+// forked from this one, so a crash or fatal error in one binary does
+// not take down the analysis of the others.
+//
+class AnalysisJob {
+public:
+  string name;        // basename of the binary, used in messages
+  string input;       // file to be processed
+  string output;      // structure file or load module list
+  string warnings;    // captures the stdout and stderr of the child
+  long size;          // bytes in the input; the cost used to order jobs
+  unsigned threads;   // threads the job may use
+  bool gpu;
+};
+
+typedef void (*JobFn)(AnalysisJob &job, Args &args);
+typedef void (*DoneFn)(AnalysisJob &job, int status, Args &args);
+
+static void analyze_binary(AnalysisJob &job, Args &args);
+static void report_binary(AnalysisJob &job, int status, Args &args);
+static void list_load_modules(string &measurements_dir, string &hpcproftt_path,
+			      unsigned int jobs, Args &args, vector<string> &modules);
+static void run_jobs(vector<AnalysisJob> &queue, unsigned int pool,
+		     Args &args, JobFn child, DoneFn done);
+static bool out_of_date(const string &input, const string &output);
 
 
 //
-// For a measurements directory, write a Makefile and launch hpcstruct
-// to analyze CPU and GPU binaries associated with the measurements
+// For a measurements directory, analyze the CPU and GPU binaries
+// associated with the measurements.
+//
+// The binaries are placed in a queue ordered by size, largest first,
+// and a pool of threads is shared among them: a binary of at least
+// --psize bytes gets up to 16 threads, smaller ones get 2, and as many
+// binaries run concurrently as fit in the pool.  Each binary is
+// analyzed by doSingleBinary() in a forked child, with the structure
+// cache set up once here and shared by all of them.  Results are
+// reported as each binary finishes.
+//
+// As with make, a binary is reanalyzed only if its structure file is
+// missing or older than the binary.
 //
 
 
@@ -116,25 +155,14 @@ doMeasurementsDir
 
   setenv("PATH", new_path.c_str(), 1);
 
-  // Construct full paths for hpcproftt and hpcstruct
+  // Construct the full path for hpcproftt
   //
   string hpcproftt_path = string(HPCTOOLKIT_INSTALL_PREFIX) 
     + "/libexec/hpctoolkit/hpcproftt";
 
-  string hpcstruct_path = string(HPCTOOLKIT_INSTALL_PREFIX)
-    + "/bin/hpcstruct";
-
-  //
-  // Write Makefile and launch analysis.
-  //
   string structs_dir = measurements_dir + "/structs";
   create_structs_directory(structs_dir);
 
-  string makefile_name = structs_dir + "/Makefile";
-
-  fstream makefile;
-  open_makefile(makefile_name, makefile);
-
   // Figure out how many threads and jobs are to be used
   unsigned int pthreads;
   unsigned int jobs;
@@ -177,38 +205,10 @@ doMeasurementsDir
   }
 
   string gpucfg = args.compute_gpu_cfg ? "yes" : "no";
+  string gpucfg_alt = args.compute_gpu_cfg ? "no" : "yes";
 
   // two threads per small binary unless concurrency is 1
-  int small_jobs = (jobs >= 2) ? jobs / 2 : jobs;
-  int small_threads = (jobs == 1) ? 1 : 2;
-
-  // Write the header with definitions to the makefile
-  makefile << "MEAS_DIR =  "    << measurements_dir << "\n"
- 	   << "GPUBIN_CFG = "   << gpucfg << "\n"
-	   << "CPU_ANALYZE = "  << args.analyze_cpu_binaries << "\n"
-	   << "GPU_ANALYZE = "  << args.analyze_gpu_binaries << "\n"
-	   << "PAR_SIZE = "     << args.parallel_analysis_threshold << "\n"
-	   << "JOBS = "         << jobs << "\n"
-	   << "SJOBS = "        << small_jobs << "\n"
-	   << "STHREADS = "     << small_threads << "\n"
-	   << "LJOBS = "        << jobs/pthreads << "\n"
-	   << "LTHREADS = "     << pthreads << "\n"
-	   << "PROFTT = "       << hpcproftt_path << "\n"
-	   << "STRUCT= "        << hpcstruct_path << "\n";
-
-  if (!cache_path.empty()) {
-    makefile << "CACHE= "       << cache_path << "\n";
-  } else {
-    makefile << "CACHE= " << "\n";
-  }
-
-  makefile << analysis_makefile << endl;
-
-  makefile.close();
-
-  // Construct the make command to invoke it
-  string make_cmd = string("make -C ") + structs_dir + " -k --silent "
-      + " --no-print-directory all";
+  unsigned int small_threads = (jobs == 1) ? 1 : 2;
 
   // Describe the parallelism and concurrency used
   cout << "NOTE: Using a pool of " << jobs << " threads to analyze binaries in a measurement directory" << endl;
@@ -217,13 +217,86 @@ doMeasurementsDir
   cout << "NOTE: Analyzing each small binary using " << small_threads <<
     " thread" << ((small_threads > 1) ? "s" : "") <<  "\n" << endl;
 
-  // Run the make command
+  // Find the load modules named by the measurements
+  vector<string> modules;
+  list_load_modules(measurements_dir, hpcproftt_path, jobs, args, modules);
+
+  // Build the queue of binaries to analyze
   //
-  if (system(make_cmd.c_str()) != 0) {
-    DIAG_EMsg("Running make to generate hpcstruct files for measurement directory failed.");
-    exit(1);
+  string cpubin_dir = measurements_dir + "/cpubins";
+  string gpubin_dir = measurements_dir + "/" GPU_BINARY_DIRECTORY;
+
+  if (args.analyze_cpu_binaries) {
+    mkdir(cpubin_dir.c_str(), 0755);
   }
 
+  vector<AnalysisJob> queue;
+  std::set<string> seen;
+
+  for (auto it = modules.begin(); it != modules.end(); ++it) {
+    AnalysisJob job;
+
+    job.gpu = (it->find(GPU_BINARY_SUFFIX) != string::npos);
+    job.name = FileUtil::basename(*it);
+
+    if (job.gpu ? !args.analyze_gpu_binaries : !args.analyze_cpu_binaries) {
+      continue;
+    }
+    if (!seen.insert((job.gpu ? "g/" : "c/") + job.name).second) {
+      continue;
+    }
+
+    if (job.gpu) {
+      // the measurements directory holds a copy of each GPU binary
+      job.input = gpubin_dir + "/" + job.name;
+      string prefix = structs_dir + "/" + job.name + "-gpucfg-";
+      job.output = prefix + gpucfg + ".hpcstruct";
+      job.warnings = prefix + gpucfg + ".warnings";
+
+      // discard results computed with the other gpucfg setting
+      unlink((prefix + gpucfg_alt + ".hpcstruct").c_str());
+      unlink((prefix + gpucfg_alt + ".warnings").c_str());
+    } else {
+      // analyze a CPU binary through a link in the cpubins directory
+      job.input = cpubin_dir + "/" + job.name;
+      symlink(it->c_str(), job.input.c_str());
+      job.output = structs_dir + "/" + job.name + ".hpcstruct";
+      job.warnings = structs_dir + "/" + job.name + ".warnings";
+    }
+
+    struct stat st;
+    if (stat(job.input.c_str(), &st) != 0) {
+      cout << "WARNING: unable to find binary " << job.input
+	   << " named in the measurements" << endl;
+      continue;
+    }
+    if (!out_of_date(job.input, job.output)) {
+      continue;
+    }
+
+    job.size = st.st_size;
+    job.threads = (job.size > args.parallel_analysis_threshold)
+      ? pthreads : small_threads;
+    queue.push_back(job);
+  }
+
+  std::stable_sort(queue.begin(), queue.end(),
+		   [](const AnalysisJob &a, const AnalysisJob &b)
+		   { return a.size > b.size; });
+
+  // Settings shared by every binary; the per-binary ones are set in
+  // the child.  The phase-specific thread counts are not passed on,
+  // so -j alone governs each binary.
+  args.meas_dir = measurements_dir;
+  args.is_from_makefile = true;
+  args.cache_directory = cache_path;
+  args.jobs_struct = 0;
+  args.jobs_parse = 0;
+  args.jobs_symtab = 0;
+  args.show_time = false;
+
+  run_jobs(queue, jobs, args, analyze_binary, report_binary);
+
   // Write a blank line
   std::cerr << std::endl;
 
@@ -231,6 +304,347 @@ doMeasurementsDir
   exit(0);
 }
 
+// Redirect the standard output and error of a child to a file
+static void
+redirect_output
+(
+  const string &file_name,
+  bool both
+)
+{
+  int fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    DIAG_EMsg("Unable to write file: " << file_name << ": " << strerror(errno));
+    _exit(1);
+  }
+  dup2(fd, STDOUT_FILENO);
+  if (both) {
+    dup2(fd, STDERR_FILENO);
+  }
+  close(fd);
+}
+
+
+// Child side of a load module listing: run hpcproftt on an hpcrun file
+static void
+list_child
+(
+  AnalysisJob &job,
+  Args &args
+)
+{
+  redirect_output(job.output, false);
+  execl(job.name.c_str(), job.name.c_str(), "-l", job.input.c_str(), (char *) NULL);
+  DIAG_EMsg("Unable to run " << job.name << ": " << strerror(errno));
+  _exit(127);
+}
+
+
+static void
+list_done
+(
+  AnalysisJob &job,
+  int status,
+  Args &args
+)
+{
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    cout << "WARNING: unable to list the load modules in " << job.input << endl;
+    // don't let a partial list look up to date
+    unlink(job.output.c_str());
+  }
+}
+
+
+// Child side of a binary analysis: the analysis is done in this
+// process, with output going to the binary's warnings file
+static void
+analyze_binary
+(
+  AnalysisJob &job,
+  Args &args
+)
+{
+  redirect_output(job.warnings, true);
+
+  args.in_filenm = job.input;
+  args.out_filenm = job.output;
+  args.jobs = job.threads;
+
+  struct stat sb;
+  if (stat(args.in_filenm.c_str(), &sb) != 0) {
+    cerr << "ERROR -- input file " << args.in_filenm << " does not exist" << endl;
+    exit(1);
+  }
+
+  try {
+    doSingleBinary(args, &sb);
+  }
+  catch (const Diagnostics::Exception& x) {
+    DIAG_EMsg(x.message());
+    exit(1);
+  }
+  catch (const std::exception& x) {
+    DIAG_EMsg("[std::exception] " << x.what());
+    exit(1);
+  }
+  exit(0);
+}
+
+
+static string
+parallel_status
+(
+  AnalysisJob &job,
+  Args &args
+)
+{
+  string status = (job.threads > 1) ? "parallel" : "concurrent";
+  if (job.gpu) {
+    status += string(" [gpucfg=") + (args.compute_gpu_cfg ? "yes" : "no") + "]";
+  }
+  return status;
+}
+
+
+static void
+announce_binary
+(
+  AnalysisJob &job,
+  Args &args
+)
+{
+  cout << " begin " << parallel_status(job, args) << " analysis of "
+       << (job.gpu ? "GPU" : "CPU") << " binary " << job.name
+       << " (size = " << job.size << ", threads = " << job.threads << ")"
+       << endl;
+}
+
+
+// Report the outcome of a binary from its exit status and the contents
+// of its warnings file
+static void
+report_binary
+(
+  AnalysisJob &job,
+  int status,
+  Args &args
+)
+{
+  // ADVICE, NOTE, DEBUG and CACHESTAT lines and blank lines are
+  // expected; anything else indicates trouble
+  string cache_stat;
+  bool incomplete = !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+
+  std::ifstream warnings(job.warnings.c_str());
+  string line;
+  while (std::getline(warnings, line)) {
+    if (line.compare(0, 9, "CACHESTAT") == 0) {
+      size_t pos = line.find_first_not_of(" ", 9);
+      if (pos != string::npos) {
+	cache_stat = " " + line.substr(pos);
+      }
+    } else if (!line.empty()
+	       && line.find("DEBUG") == string::npos
+	       && line.find("NOTE") == string::npos
+	       && line.find("ADVICE") == string::npos) {
+      incomplete = true;
+    }
+  }
+
+  if (incomplete) {
+    cout << "WARNING: incomplete analysis of " << job.name << "; see "
+	 << job.warnings << " for details" << endl;
+  }
+
+  cout << "   end " << parallel_status(job, args) << " analysis of "
+       << (job.gpu ? "GPU" : "CPU") << " binary " << job.name
+       << cache_stat << endl;
+}
+
+
+//
+// Run each job in a forked child, largest first, keeping the threads in
+// use by running jobs within the pool.  A job that needs more threads
+// than are free waits for running jobs to finish, unless nothing is
+// running.
+//
+static void
+run_jobs
+(
+  vector<AnalysisJob> &queue,
+  unsigned int pool,
+  Args &args,
+  JobFn child,
+  DoneFn done
+)
+{
+  std::map<pid_t, size_t> running;
+  unsigned int busy = 0;
+  size_t next = 0;
+
+  for (;;) {
+    while (next < queue.size()
+	   && (running.empty() || busy + queue[next].threads <= pool)) {
+      AnalysisJob &job = queue[next];
+
+      if (child == analyze_binary) {
+	announce_binary(job, args);
+      }
+
+      // don't let the child inherit unwritten output
+      cout.flush();
+      cerr.flush();
+      fflush(NULL);
+
+      pid_t pid = fork();
+      if (pid == 0) {
+	child(job, args);
+	_exit(1);
+      }
+      if (pid < 0) {
+	DIAG_EMsg("Unable to start analysis of " << job.input << ": "
+		  << strerror(errno));
+	exit(1);
+      }
+
+      running[pid] = next;
+      busy += job.threads;
+      next++;
+    }
+
+    if (running.empty()) {
+      break;
+    }
+
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR) {
+	continue;
+      }
+      DIAG_EMsg("Waiting for analysis failed: " << strerror(errno));
+      exit(1);
+    }
+
+    auto it = running.find(pid);
+    if (it == running.end()) {
+      continue;
+    }
+
+    AnalysisJob &job = queue[it->second];
+    busy -= job.threads;
+    running.erase(it);
+    done(job, status, args);
+  }
+}
+
+
+//
+// List the load modules used by the measurements, in the manner of
+// make: hpcproftt lists the modules of each hpcrun file into
+// lm/<name>.lm, and a list is rebuilt only if it is older than its
+// hpcrun file.  HPCToolkit's own libraries and the GPU runtimes are
+// omitted.  The sorted, unique list is also written to lm/all.lm.
+//
+static void
+list_load_modules
+(
+  string &measurements_dir,
+  string &hpcproftt_path,
+  unsigned int jobs,
+  Args &args,
+  vector<string> &modules
+)
+{
+  static const char *omit[] = {
+    "libhpcrun", "libmonitor", "libxed", "libpfm", "libcuda", "libcupti"
+  };
+
+  string lm_dir = measurements_dir + "/lm";
+  mkdir(lm_dir.c_str(), 0755);
+
+  vector<string> lists;
+  vector<AnalysisJob> queue;
+
+  DIR *dir = opendir(measurements_dir.c_str());
+  if (dir != NULL) {
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+      string file_name(ent->d_name);
+      size_t len = file_name.length();
+      if (len <= 7 || file_name.compare(len - 7, 7, ".hpcrun") != 0) {
+	continue;
+      }
+
+      AnalysisJob job;
+      job.name = hpcproftt_path;
+      job.input = measurements_dir + "/" + file_name;
+      job.output = lm_dir + "/" + file_name.substr(0, len - 7) + ".lm";
+      job.size = 0;
+      job.threads = 1;
+      job.gpu = false;
+
+      lists.push_back(job.output);
+      if (out_of_date(job.input, job.output)) {
+	queue.push_back(job);
+      }
+    }
+    closedir(dir);
+  }
+
+  run_jobs(queue, jobs, args, list_child, list_done);
+
+  std::set<string> names;
+  for (auto it = lists.begin(); it != lists.end(); ++it) {
+    std::ifstream list(it->c_str());
+    string line;
+    while (std::getline(list, line)) {
+      if (line.empty()) {
+	continue;
+      }
+      bool keep = true;
+      for (size_t i = 0; i < sizeof(omit) / sizeof(omit[0]); i++) {
+	if (line.find(omit[i]) != string::npos) {
+	  keep = false;
+	  break;
+	}
+      }
+      if (keep) {
+	names.insert(line);
+      }
+    }
+  }
+
+  modules.assign(names.begin(), names.end());
+
+  std::ofstream all((lm_dir + "/all.lm").c_str());
+  for (auto it = modules.begin(); it != modules.end(); ++it) {
+    all << *it << "\n";
+  }
+}
+
+
+// True if output is missing or older than input
+static bool
+out_of_date
+(
+  const string &input,
+  const string &output
+)
+{
+  struct stat in_sb, out_sb;
+
+  if (stat(output.c_str(), &out_sb) != 0 || stat(input.c_str(), &in_sb) != 0) {
+    return true;
+  }
+  if (in_sb.st_mtim.tv_sec != out_sb.st_mtim.tv_sec) {
+    return in_sb.st_mtim.tv_sec > out_sb.st_mtim.tv_sec;
+  }
+  return in_sb.st_mtim.tv_nsec > out_sb.st_mtim.tv_nsec;
+}
+
+
 // Routine to verify that given measurements directory 
 // (1) is readable
 // (2) contains measurement files
@@ -317,20 +731,3 @@ create_structs_directory
     exit(1);
   }
 }
-
-// Open the Makefile to create it.
-static void
-open_makefile
-(
-  string &makefile_name,
-  fstream &makefile
-)
-{
-  makefile.open(makefile_name, fstream::out | fstream::trunc);
-
-  if (! makefile.is_open()) {
-    DIAG_EMsg("Unable to write file: " << makefile_name);
-    exit(1);
-  }
-}
-
@@ -133,6 +133,8 @@ doSingleBinary
   opts.set(args.jobs, jobs_struct, jobs_parse, jobs_symtab, args.show_time,
 	   args.analyze_cpu_binaries, args.analyze_gpu_binaries,
 	   args.compute_gpu_cfg, args.parallel_analysis_threshold);
+  opts.reuse_file = args.reuse_filenm;
+  opts.mem_limit = args.mem_limit;
   if (args.show_gaps && args.out_filenm == "-") {
     DIAG_EMsg("Cannot make gaps file when hpcstruct file is stdout.");
     exit(1);
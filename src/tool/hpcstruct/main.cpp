@@ -57,9 +57,9 @@
 //  it is created.
 //
 // If the argument is a measurements directory, which may contain both
-//  CPU and GPU binaries, it writes a Makefile with commands for
-//  launching subsidiary hpcstruct commands, one for each binary.
-//  It then runs make with Makefile, which invokes those commands.
+//  CPU and GPU binaries, it queues the binaries by size and analyzes
+//  each one in a forked child, running as many concurrently as fit in
+//  the pool of threads.
 //
 // If the argument is a single binary, hpstruct may have been invoked
 //  directly by a user or invoked for a binary in a measurements directory.
@@ -199,6 +199,14 @@ realmain(int argc, char* argv[])
       DIAG_EMsg("Outfile file may not be specified when analyzing a measurement directory.");
       exit(1);
     }
+    if (!args.reuse_filenm.empty()) {
+      DIAG_EMsg("Reuse file may not be specified when analyzing a measurement directory.");
+      exit(1);
+    }
+    if (args.mem_limit > 0) {
+      DIAG_EMsg("Memory limit may not be specified when analyzing a measurement directory.");
+      exit(1);
+    }
     // Now process the measurements directory, passing it its stat result
     //
     doMeasurementsDir(args, &sb);
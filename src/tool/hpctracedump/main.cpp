@@ -50,79 +50,548 @@
 //   src/tool/hpctracedump/main.cpp
 //
 // Purpose:
-//   a program that dumps a trace file recorded by hpcrun
+//   a program that dumps trace files recorded by hpcrun
 //
 // Description:
-//   driver program that uses library functions to read a trace file
+//   driver program that maps each trace file, decodes its records a
+//   block at a time with library functions, and prints them as text,
+//   CSV or binary records.  Several files may be decoded concurrently;
+//   output always follows the order of the command line.
 //
 //***************************************************************************
 
+
+//***************************************************************************
+// system include files
+//***************************************************************************
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
 //***************************************************************************
 // local include files
 //***************************************************************************
 
+#include <lib/prof-lean/hpcio.h>
 #include <lib/prof-lean/hpcfmt.h>
 #include <lib/prof-lean/hpcrun-fmt.h>
 
 
 
 //***************************************************************************
-// interface functions
+// types
 //***************************************************************************
 
-int
-main(int argc, char **argv)
+enum OutputFormat {
+  Format_Text,    // one call path id per line (the original output)
+  Format_CSV,
+  Format_Binary
+};
+
+
+// a record of --format=binary output, in host byte order
+typedef struct dump_record_t {
+  int32_t  rank;
+  int32_t  thread;
+  uint64_t time;
+  uint32_t cpId;
+  uint32_t metricId;
+} dump_record_t;
+
+
+typedef struct dump_options_t {
+  OutputFormat format;
+
+  // keep records with timeBeg <= time < timeEnd
+  uint64_t timeBeg;
+  uint64_t timeEnd;
+
+  // keep files whose rank is in [rankLo, rankHi]
+  long rankLo;
+  long rankHi;
+
+  int jobs;
+} dump_options_t;
+
+
+
+//***************************************************************************
+// local data
+//***************************************************************************
+
+// number of records decoded (and rendered) at a time
+static const int DecodeBlockLen = 64 * 1024;
+
+static const char* usage =
+  "usage: %s [options] <trace-file>...\n"
+  "\n"
+  "options:\n"
+  "  -f, --format=text|csv|binary\n"
+  "        text: one call path id per line (default)\n"
+  "        csv: rank,thread,time,cpid,metricid\n"
+  "        binary: packed {int32 rank, int32 thread, uint64 time,\n"
+  "                uint32 cpid, uint32 metricid} in host byte order\n"
+  "  -t, --time=BEGIN:END\n"
+  "        keep records with BEGIN <= time < END (nanoseconds);\n"
+  "        either bound may be omitted\n"
+  "  -r, --rank=LO[:HI]\n"
+  "        keep files whose MPI rank is in [LO, HI]\n"
+  "  -j, --jobs=N\n"
+  "        decode N files concurrently (default 1); output stays in\n"
+  "        command-line order\n";
+
+
+
+//***************************************************************************
+// private operations
+//***************************************************************************
+
+static void
+appendUInt(std::string& out, uint64_t x)
 {
-  int ret;
-  if (argc < 2) {
-    fprintf(stderr, "usage: %s <filename>\n", argv[0]);
-    exit(-1);
+  char buf[24];
+  char* p = buf + sizeof(buf);
+  do {
+    *--p = '0' + (x % 10);
+    x /= 10;
+  } while (x != 0);
+  out.append(p, buf + sizeof(buf) - p);
+}
+
+
+static void
+appendInt(std::string& out, int x)
+{
+  if (x < 0) {
+    out += '-';
+    appendUInt(out, - (int64_t) x);
   }
-  char *fileName = argv[1];
-  char* infsBuf = new char[HPCIO_RWBufferSz];
+  else {
+    appendUInt(out, x);
+  }
+}
 
-  FILE* infs = hpcio_fopen_r(fileName);
 
-  if (!infs) {
-    fprintf(stderr, "%s: error opening trace file %s\n", argv[0], fileName);
+static uint64_t
+recordTime(const char* records, size_t recSz, size_t i,
+	   hpctrace_hdr_flags_t flags)
+{
+  hpctrace_fmt_datum_t datum;
+  hpctrace_fmt_data_decode(&datum, 1, flags, records + i * recSz);
+  return HPCTRACE_FMT_GET_TIME(datum.comp);
+}
+
+
+// True if the profile hpcrun wrote next to 'fileName' says its records
+// are in time order (HPCRUN_FMT_NV_traceOrdered).  GPU traces need not
+// be, and without a profile the order is unknown.
+static bool
+isTimeOrdered(const char* fileName)
+{
+  std::string name(fileName);
+  std::string ext = std::string(".") + HPCRUN_TraceFnmSfx;
+  size_t pos = name.rfind(ext);
+  if (pos == std::string::npos) {
+    return false;
+  }
+  name.replace(pos, std::string::npos, std::string(".") + HPCRUN_ProfileFnmSfx);
+
+  FILE* fs = hpcio_fopen_r(name.c_str());
+  if (!fs) {
+    return false;
+  }
+  hpcrun_fmt_hdr_t hdr;
+  int ret = hpcrun_fmt_hdr_fread(&hdr, fs, malloc);
+  hpcio_fclose(fs);
+  if (ret != HPCFMT_OK) {
+    return false;
   }
 
-  ret = setvbuf(infs, infsBuf, _IOFBF, HPCIO_RWBufferSz);
+  const char* val = hpcfmt_nvpairList_search(&hdr.nvps,
+					     HPCRUN_FMT_NV_traceOrdered);
+  bool ordered = (val != NULL && strcmp(val, "1") == 0);
+  hpcrun_fmt_hdr_free(&hdr, free);
 
-  if (ret != 0) {
-    fprintf(stderr, "%s: setvbuf failed\n", argv[0]);
-    exit(-1);
+  return ordered;
+}
+
+
+static bool
+flush(std::string& out, FILE* outfs)
+{
+  bool ok = fwrite(out.data(), 1, out.size(), outfs) == out.size();
+  out.clear();
+  return ok;
+}
+
+
+// an unlinked temporary file in $TMPDIR (or /tmp); it goes away when
+// closed
+static FILE*
+openSpillFile()
+{
+  const char* dir = getenv("TMPDIR");
+  std::string path = std::string((dir && *dir) ? dir : "/tmp")
+    + "/hpctracedump-XXXXXX";
+
+  std::vector<char> name(path.begin(), path.end());
+  name.push_back('\0');
+  int fd = mkstemp(name.data());
+  if (fd < 0) {
+    return NULL;
+  }
+  unlink(name.data());
+
+  FILE* fs = fdopen(fd, "w+");
+  if (!fs) {
+    close(fd);
+  }
+  return fs;
+}
+
+
+// write what was spilled to 'spill', then the tail still in 'out'
+static bool
+copySpill(FILE* spill, std::string& out, FILE* outfs)
+{
+  bool ok = true;
+  if (ftell(spill) > 0) {
+    ok = flush(out, spill) && fflush(spill) == 0
+      && fseek(spill, 0, SEEK_SET) == 0;
+
+    std::vector<char> buf(HPCIO_RWBufferSz);
+    size_t len;
+    while (ok && (len = fread(buf.data(), 1, buf.size(), spill)) > 0) {
+      ok = fwrite(buf.data(), 1, len, outfs) == len;
+    }
+    ok = ok && !ferror(spill);
+  }
+  return flush(out, outfs) && ok;
+}
+
+
+// Render the records of 'fileName' that pass the filters into 'out'.
+// When 'outfs' is non-NULL, 'out' is written to it whenever it grows
+// past a buffer's worth, so a single file never has to fit in memory.
+// Returns false (with a message in 'err') on error.
+static bool
+dumpFile(const char* fileName, const dump_options_t& opts,
+	 std::string& out, FILE* outfs, std::string& err)
+{
+  int rank, thread;
+  hpcrun_fmt_fnm_rank_thread(fileName, &rank, &thread);
+  if (rank < opts.rankLo || rank > opts.rankHi) {
+    return true;
+  }
+
+  FILE* infs = hpcio_fopen_r(fileName);
+  if (!infs) {
+    err = std::string("error opening trace file ") + fileName;
+    return false;
   }
 
   hpctrace_fmt_hdr_t hdr;
+  int ret = hpctrace_fmt_hdr_fread(&hdr, infs);
+  long offset = ftell(infs);
+  hpcio_fclose(infs);
 
-  ret = hpctrace_fmt_hdr_fread(&hdr, infs);
+  if (ret != HPCFMT_OK || offset < 0) {
+    err = std::string("unable to read header for ") + fileName;
+    return false;
+  }
 
-  if (ret != HPCFMT_OK) {
-    fprintf(stderr, "%s: unable to read header for %s\n", argv[0], fileName);
-    exit(-1);
+  int fd = open(fileName, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    err = std::string("error opening trace file ") + fileName;
+    return false;
+  }
+
+  const size_t recSz = hpctrace_fmt_datum_size(hdr.flags);
+  size_t bodySz = (st.st_size > offset) ? st.st_size - offset : 0;
+  size_t n = bodySz / recSz;
+
+  if (bodySz % recSz != 0) {
+    err = std::string("error reading trace file ") + fileName
+      + " (truncated record)";
+  }
+
+  if (n == 0) {
+    close(fd);
+    return err.empty();
+  }
+
+  void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    err = std::string("unable to map trace file ") + fileName;
+    return false;
+  }
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+  const char* records = (const char*) map + offset;
+
+  // when the records are in time order, the first record of the range
+  // can be found by binary search and the scan can stop at its end
+  bool ordered = isTimeOrdered(fileName);
+  size_t lo = 0, hi = ordered ? n : 0;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (recordTime(records, recSz, mid, hdr.flags) < opts.timeBeg) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+
+  std::vector<hpctrace_fmt_datum_t> data(DecodeBlockLen);
+  bool done = false;
+  bool ok = true;
+
+  for (size_t i = lo; i < n && !done && ok; i += DecodeBlockLen) {
+    int len = (n - i < (size_t) DecodeBlockLen) ? n - i : DecodeBlockLen;
+    hpctrace_fmt_data_decode(data.data(), len, hdr.flags,
+			     records + i * recSz);
+
+    for (int j = 0; j < len; j++) {
+      const hpctrace_fmt_datum_t& d = data[j];
+      uint64_t time = HPCTRACE_FMT_GET_TIME(d.comp);
+      if (time < opts.timeBeg || time >= opts.timeEnd) {
+	if (ordered && time >= opts.timeEnd) {
+	  done = true;
+	  break;
+	}
+	continue;
+      }
+
+      if (opts.format == Format_Text) {
+	appendUInt(out, d.cpId);
+	out += '\n';
+      }
+      else if (opts.format == Format_CSV) {
+	appendInt(out, rank);
+	out += ',';
+	appendInt(out, thread);
+	out += ',';
+	appendUInt(out, time);
+	out += ',';
+	appendUInt(out, d.cpId);
+	out += ',';
+	if (d.metricId != HPCTRACE_FMT_MetricId_NULL) {
+	  appendUInt(out, d.metricId);
+	}
+	out += '\n';
+      }
+      else {
+	dump_record_t rec = { rank, thread, time, d.cpId, d.metricId };
+	out.append((const char*) &rec, sizeof(rec));
+      }
+    }
+
+    if (outfs && out.size() >= HPCIO_RWBufferSz) {
+      ok = flush(out, outfs);
+    }
+  }
+
+  munmap(map, st.st_size);
+
+  if (!ok) {
+    err = "error writing output";
+    return false;
+  }
+  return err.empty();
+}
+
+
+static bool
+parseRange(const char* arg, uint64_t* lo, uint64_t* hi)
+{
+  char* end;
+  if (*arg != ':') {
+    *lo = strtoull(arg, &end, 10);
+    if (end == arg) {
+      return false;
+    }
+    arg = end;
+  }
+  if (*arg == '\0') {
+    return true;
+  }
+  if (*arg != ':') {
+    return false;
+  }
+  arg++;
+  if (*arg != '\0') {
+    *hi = strtoull(arg, &end, 10);
+    if (*end != '\0') {
+      return false;
+    }
   }
+  return true;
+}
+
+
+
+//***************************************************************************
+// interface functions
+//***************************************************************************
+
+int
+main(int argc, char **argv)
+{
+  dump_options_t opts;
+  opts.format = Format_Text;
+  opts.timeBeg = 0;
+  opts.timeEnd = UINT64_MAX;
+  opts.rankLo = -1;
+  opts.rankHi = INT32_MAX;
+  opts.jobs = 1;
+
+  bool rankFilter = false;
+
+  static struct option longOpts[] = {
+    { "format", required_argument, NULL, 'f' },
+    { "time",   required_argument, NULL, 't' },
+    { "rank",   required_argument, NULL, 'r' },
+    { "jobs",   required_argument, NULL, 'j' },
+    { "help",   no_argument,       NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
 
-  // read and dump trace records until EOF 
-  while ( !feof(infs) ) {
-    hpctrace_fmt_datum_t datum;
+  int c;
+  while ((c = getopt_long(argc, argv, "f:t:r:j:h", longOpts, NULL)) != -1) {
+    switch (c) {
+    case 'f':
+      if (strcmp(optarg, "text") == 0) {
+	opts.format = Format_Text;
+      }
+      else if (strcmp(optarg, "csv") == 0) {
+	opts.format = Format_CSV;
+      }
+      else if (strcmp(optarg, "binary") == 0) {
+	opts.format = Format_Binary;
+      }
+      else {
+	fprintf(stderr, "%s: unknown format '%s'\n", argv[0], optarg);
+	exit(-1);
+      }
+      break;
 
-    ret = hpctrace_fmt_datum_fread(&datum, hdr.flags, infs);
+    case 't':
+      if (!parseRange(optarg, &opts.timeBeg, &opts.timeEnd)) {
+	fprintf(stderr, "%s: bad time range '%s'\n", argv[0], optarg);
+	exit(-1);
+      }
+      break;
 
-    if (ret == HPCFMT_EOF) {
+    case 'r': {
+      uint64_t lo = 0, hi = INT32_MAX;
+      if (!parseRange(optarg, &lo, &hi) || *optarg == ':') {
+	fprintf(stderr, "%s: bad rank range '%s'\n", argv[0], optarg);
+	exit(-1);
+      }
+      // a single rank selects just that rank
+      opts.rankLo = lo;
+      opts.rankHi = strchr(optarg, ':') ? (long) hi : (long) lo;
+      rankFilter = true;
       break;
     }
-    else if (ret == HPCFMT_ERR) {
-      fprintf(stderr, "%s: error reading trace file %s\n", argv[0], fileName);
+
+    case 'j':
+      opts.jobs = atoi(optarg);
+      if (opts.jobs < 1) {
+	fprintf(stderr, "%s: --jobs must be at least 1\n", argv[0]);
+	exit(-1);
+      }
+      break;
+
+    default:
+      fprintf(stderr, usage, argv[0]);
       exit(-1);
     }
+  }
 
-    printf("%d\n", datum.cpId);
+  if (optind >= argc) {
+    fprintf(stderr, usage, argv[0]);
+    exit(-1);
   }
 
-  hpcio_fclose(infs);
+  // files whose name carries no rank are kept unless filtering by rank
+  if (!rankFilter) {
+    opts.rankLo = -1;
+  }
+  else if (opts.rankLo < 0) {
+    opts.rankLo = 0;
+  }
+
+  int numFiles = argc - optind;
+  char** fileNames = argv + optind;
+  bool failed = false;
 
-  delete[] infsBuf;
+  std::string header;
+  if (opts.format == Format_CSV) {
+    header = "rank,thread,time,cpid,metricid\n";
+  }
+  fwrite(header.data(), 1, header.size(), stdout);
+
+  if (opts.jobs == 1 || numFiles == 1) {
+    std::string out;
+    for (int i = 0; i < numFiles; i++) {
+      std::string err;
+      bool ok = dumpFile(fileNames[i], opts, out, stdout, err);
+      ok = flush(out, stdout) && ok;
+      if (!ok) {
+	fprintf(stderr, "%s: %s\n", argv[0],
+		err.empty() ? "error writing output" : err.c_str());
+	failed = true;
+      }
+    }
+  }
+  else {
+    // each file is rendered into its own spill file, flushed from a
+    // buffer of at most HPCIO_RWBufferSz, and copied to stdout in the
+    // ordered section; memory stays bounded however large the dumps are
+#pragma omp parallel for ordered schedule(dynamic, 1) num_threads(opts.jobs)
+    for (int i = 0; i < numFiles; i++) {
+      std::string out, err;
+      FILE* spill = openSpillFile();
+      bool ok = false;
+      if (spill) {
+	ok = dumpFile(fileNames[i], opts, out, spill, err);
+      }
+      else {
+	err = "unable to create a temporary file";
+      }
+
+#pragma omp ordered
+      {
+	if (spill) {
+	  ok = copySpill(spill, out, stdout) && ok;
+	  fclose(spill);
+	}
+	if (!ok) {
+	  fprintf(stderr, "%s: %s\n", argv[0],
+		  err.empty() ? "error writing output" : err.c_str());
+	  failed = true;
+	}
+      }
+    }
+  }
 
-  return 0;
+  return failed ? -1 : 0;
 }
@@ -0,0 +1,20 @@
+//
+//  Copyright (c) 2002-2022, Rice University.
+//  See the file LICENSE for details.
+//
+//  Library that dlstress opens and closes.  The work loop keeps
+//  threads inside the library long enough for samples to land here.
+//
+
+long
+dlstress_work(long n)
+{
+    volatile long sum = 0;
+    long i;
+
+    for (i = 0; i < n; i++) {
+	sum += i % 7;
+    }
+
+    return sum;
+}
@@ -0,0 +1,74 @@
+//
+//  Copyright (c) 2002-2022, Rice University.
+//  See the file LICENSE for details.
+//
+//  Stress test for hpcrun's unwind recipe map: several threads
+//  repeatedly dlopen a small library, spin inside it and dlclose it,
+//  so that samples land in code whose load module is being unmapped
+//  by another thread.
+//
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_THREADS  4
+
+typedef long (*work_fn)(long);
+
+static const char *libpath;
+static long iters;
+
+static void *
+run(void *arg)
+{
+    long n, sum = 0;
+
+    for (n = 0; n < iters; n++) {
+	void *handle = dlopen(libpath, RTLD_NOW | RTLD_LOCAL);
+	if (handle == NULL) {
+	    fprintf(stderr, "dlopen failed: %s\n", dlerror());
+	    exit(1);
+	}
+	work_fn work = (work_fn) dlsym(handle, "dlstress_work");
+	if (work == NULL) {
+	    fprintf(stderr, "dlsym failed: %s\n", dlerror());
+	    exit(1);
+	}
+	sum += work(50000);
+	dlclose(handle);
+    }
+
+    *(long *) arg = sum;
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t thr[NUM_THREADS];
+    long sums[NUM_THREADS];
+    long sum;
+    int i;
+
+    if (argc < 2) {
+	fprintf(stderr, "usage: %s library [iterations]\n", argv[0]);
+	return 1;
+    }
+    libpath = argv[1];
+    iters = (argc > 2) ? atol(argv[2]) : 4000;
+
+    for (i = 0; i < NUM_THREADS; i++) {
+	pthread_create(&thr[i], NULL, run, &sums[i]);
+    }
+    sum = 0;
+    for (i = 0; i < NUM_THREADS; i++) {
+	pthread_join(thr[i], NULL);
+	sum += sums[i];
+    }
+
+    printf("dlstress:  %d threads  %ld iterations  sum %ld\n",
+	   NUM_THREADS, iters, sum);
+
+    return 0;
+}